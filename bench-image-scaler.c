@@ -0,0 +1,263 @@
+#include <gtk/gtk.h>
+#include <libgd/gd-icon-utils.h>
+#include <libgd/gd-image-scaler.h>
+
+typedef struct
+{
+  const gchar *description;
+  gint src_width;
+  gint src_height;
+  gint dest_width;
+  gint dest_height;
+} BenchCase;
+
+static const BenchCase cases[] =
+{
+  { "thumbnail to grid icon", 256, 256, 128, 128 },
+  { "photo to thumbnail", 2048, 1536, 256, 192 },
+  { "grid icon to large icon", 128, 128, 400, 400 },
+  { "odd sizes", 333, 217, 97, 61 },
+};
+
+static const struct
+{
+  const gchar *name;
+  GdImageScalerFilter filter;
+} filters[] =
+{
+  { "cairo", GD_IMAGE_SCALER_FILTER_CAIRO },
+  { "fast", GD_IMAGE_SCALER_FILTER_FAST },
+  { "good", GD_IMAGE_SCALER_FILTER_GOOD },
+};
+
+static const struct
+{
+  const gchar *description;
+  gint width;
+  gint height;
+} conversion_cases[] =
+{
+  { "grid icon", 128, 128 },
+  { "thumbnail", 256, 256 },
+  { "photo", 2048, 1536 },
+};
+
+static gint n_iterations = 50;
+
+static cairo_surface_t *
+create_source (gint width, gint height)
+{
+  cairo_surface_t *surface;
+  guint8 *data;
+  gint stride;
+  gint x;
+  gint y;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cairo_surface_flush (surface);
+
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (y = 0; y < height; y++)
+    {
+      guint32 *row = (guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        {
+          guint8 alpha = (guint8) g_random_int_range (128, 256);
+          guint8 red = (guint8) (g_random_int_range (0, 256) * alpha / 255);
+          guint8 green = (guint8) (x * alpha / width);
+          guint8 blue = (guint8) (y * alpha / height);
+
+          row[x] = (guint32) alpha << 24 | (guint32) red << 16 | (guint32) green << 8 | blue;
+        }
+    }
+
+  cairo_surface_mark_dirty (surface);
+  return surface;
+}
+
+static void
+run_case (const BenchCase *bench_case)
+{
+  cairo_surface_t *source;
+  guint i;
+
+  source = create_source (bench_case->src_width, bench_case->src_height);
+
+  g_print ("%s: %dx%d -> %dx%d\n",
+           bench_case->description,
+           bench_case->src_width,
+           bench_case->src_height,
+           bench_case->dest_width,
+           bench_case->dest_height);
+
+  for (i = 0; i < G_N_ELEMENTS (filters); i++)
+    {
+      gint64 elapsed;
+      gint64 start;
+      gint j;
+
+      start = g_get_monotonic_time ();
+
+      for (j = 0; j < n_iterations; j++)
+        {
+          cairo_surface_t *zoomed;
+
+          zoomed = gd_image_scaler_scale_surface (source,
+                                                  bench_case->dest_width,
+                                                  bench_case->dest_height,
+                                                  filters[i].filter);
+          cairo_surface_destroy (zoomed);
+        }
+
+      elapsed = g_get_monotonic_time () - start;
+      g_print ("  %-8s %10.1f us\n", filters[i].name, (gdouble) elapsed / n_iterations);
+    }
+
+  cairo_surface_destroy (source);
+}
+
+static GdkPixbuf *
+create_pixbuf (gint width, gint height)
+{
+  GdkPixbuf *pixbuf;
+  guint8 *pixels;
+  gint rowstride;
+  gint x;
+  gint y;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width * 4; x++)
+        pixels[y * rowstride + x] = (guint8) g_random_int_range (0, 256);
+    }
+
+  return pixbuf;
+}
+
+static gboolean
+pixbufs_equal (GdkPixbuf *a, GdkPixbuf *b)
+{
+  gint y;
+
+  for (y = 0; y < gdk_pixbuf_get_height (a); y++)
+    {
+      if (memcmp (gdk_pixbuf_read_pixels (a) + y * gdk_pixbuf_get_rowstride (a),
+                  gdk_pixbuf_read_pixels (b) + y * gdk_pixbuf_get_rowstride (b),
+                  (gsize) gdk_pixbuf_get_width (a) * 4) != 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Compares the round trip that gd_embed_image_in_frame() used to make
+ * through GDK with the one through gd_create_surface_from_pixbuf() and
+ * gd_create_pixbuf_from_surface().
+ */
+static void
+run_conversion_case (guint index)
+{
+  cairo_surface_t *surface;
+  GdkPixbuf *gd_pixbuf = NULL;
+  GdkPixbuf *gdk_pixbuf = NULL;
+  GdkPixbuf *source;
+  gint64 elapsed_from_pixbuf;
+  gint64 elapsed_to_pixbuf;
+  gint64 start;
+  gint height;
+  gint width;
+  gint j;
+
+  height = conversion_cases[index].height;
+  width = conversion_cases[index].width;
+  source = create_pixbuf (width, height);
+
+  g_print ("%s: %dx%d pixbuf -> surface -> pixbuf\n", conversion_cases[index].description, width, height);
+
+  elapsed_from_pixbuf = elapsed_to_pixbuf = 0;
+  for (j = 0; j < n_iterations; j++)
+    {
+      start = g_get_monotonic_time ();
+      surface = gdk_cairo_surface_create_from_pixbuf (source, 1, NULL);
+      elapsed_from_pixbuf += g_get_monotonic_time () - start;
+
+      g_clear_object (&gdk_pixbuf);
+      start = g_get_monotonic_time ();
+      gdk_pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, width, height);
+      elapsed_to_pixbuf += g_get_monotonic_time () - start;
+
+      cairo_surface_destroy (surface);
+    }
+
+  g_print ("  %-8s %10.1f us %10.1f us\n",
+           "gdk",
+           (gdouble) elapsed_from_pixbuf / n_iterations,
+           (gdouble) elapsed_to_pixbuf / n_iterations);
+
+  elapsed_from_pixbuf = elapsed_to_pixbuf = 0;
+  for (j = 0; j < n_iterations; j++)
+    {
+      start = g_get_monotonic_time ();
+      surface = gd_create_surface_from_pixbuf (source, 1);
+      elapsed_from_pixbuf += g_get_monotonic_time () - start;
+
+      g_clear_object (&gd_pixbuf);
+      start = g_get_monotonic_time ();
+      gd_pixbuf = gd_create_pixbuf_from_surface (surface);
+      elapsed_to_pixbuf += g_get_monotonic_time () - start;
+
+      cairo_surface_destroy (surface);
+    }
+
+  g_print ("  %-8s %10.1f us %10.1f us%s\n",
+           "libgd",
+           (gdouble) elapsed_from_pixbuf / n_iterations,
+           (gdouble) elapsed_to_pixbuf / n_iterations,
+           pixbufs_equal (gd_pixbuf, gdk_pixbuf) ? "" : " (differs from gdk)");
+
+  g_object_unref (gd_pixbuf);
+  g_object_unref (gdk_pixbuf);
+  g_object_unref (source);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  guint i;
+  GOptionEntry entries[] =
+    {
+      { "iterations", 'n', 0, G_OPTION_ARG_INT, &n_iterations, "Number of times to scale each image", "N" },
+      { NULL }
+    };
+
+  context = g_option_context_new ("- compare the image scaling and conversion paths");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  g_option_context_free (context);
+  n_iterations = MAX (n_iterations, 1);
+
+  g_print ("image scaler backend: %s\n", gd_image_scaler_get_backend ());
+
+  for (i = 0; i < G_N_ELEMENTS (cases); i++)
+    run_case (&cases[i]);
+
+  for (i = 0; i < G_N_ELEMENTS (conversion_cases); i++)
+    run_conversion_case (i);
+
+  return 0;
+}
@@ -100,6 +100,12 @@ AC_DEFUN([LIBGD_INIT], [
         AC_DEFINE([LIBGD_TAGGED_ENTRY], [1], [Description])
     ])
 
+    # benchmarks: programs that time the image paths
+    AM_CONDITIONAL([LIBGD_BENCHMARKS],[_LIBGD_IF_OPTION_SET([benchmarks],[true],[false])])
+    _LIBGD_IF_OPTION_SET([benchmarks],[
+        _LIBGD_SET_OPTION([gtk-hacks])
+    ])
+
     # vapi: vala bindings support
     AM_CONDITIONAL([LIBGD_VAPI],[ _LIBGD_IF_OPTION_SET([vapi],[true],[false])])
     _LIBGD_IF_OPTION_SET([vapi],[
@@ -125,15 +131,23 @@ AC_DEFUN([LIBGD_INIT], [
     # _box-common:
     AM_CONDITIONAL([LIBGD__BOX_COMMON],[_LIBGD_IF_OPTION_SET([_box-common],[true],[false])])
     _LIBGD_IF_OPTION_SET([_box-common],[
+        _LIBGD_SET_OPTION([_selection-common])
         AC_DEFINE([LIBGD__BOX_COMMON], [1], [Description])
     ])
 
     # _view-common:
     AM_CONDITIONAL([LIBGD__VIEW_COMMON],[_LIBGD_IF_OPTION_SET([_view-common],[true],[false])])
     _LIBGD_IF_OPTION_SET([_view-common],[
+        _LIBGD_SET_OPTION([_selection-common])
         AC_DEFINE([LIBGD__VIEW_COMMON], [1], [Description])
     ])
 
+    # _selection-common:
+    AM_CONDITIONAL([LIBGD__SELECTION_COMMON],[_LIBGD_IF_OPTION_SET([_selection-common],[true],[false])])
+    _LIBGD_IF_OPTION_SET([_selection-common],[
+        AC_DEFINE([LIBGD__SELECTION_COMMON], [1], [Description])
+    ])
+
     PKG_CHECK_MODULES(LIBGD, [ $LIBGD_MODULES ])
     AC_SUBST(LIBGD_GIR_INCLUDES)
     AC_SUBST(LIBGD_SOURCES)
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gd-frame-renderer.h"
+#include "gd-icon-utils.h"
+
+#include <math.h>
+
+/* Draws the same frame that gd_embed_surface_in_frame() used to get
+ * from a CSS border-image, with the default "stretch" repeat and
+ * without "fill": the corners of the frame image are scaled to the
+ * border widths, the edges are stretched along the sides, and the
+ * middle is left out.
+ *
+ * The frame image is cut into slices once, and nothing changes
+ * afterwards. Nothing here touches GtkStyleContext, so a renderer can
+ * be used from several threads at once.
+ */
+
+enum
+{
+  SLICE_TOP_LEFT,
+  SLICE_TOP,
+  SLICE_TOP_RIGHT,
+  SLICE_RIGHT,
+  SLICE_BOTTOM_RIGHT,
+  SLICE_BOTTOM,
+  SLICE_BOTTOM_LEFT,
+  SLICE_LEFT,
+  NUM_SLICES
+};
+
+struct _GdFrameRenderer
+{
+  GObject parent_instance;
+  GtkBorder border_width;
+  cairo_surface_t *slices[NUM_SLICES];
+};
+
+typedef struct _GdFrameRendererBatchData GdFrameRendererBatchData;
+typedef struct _GdFrameRendererBatchResult GdFrameRendererBatchResult;
+
+struct _GdFrameRendererBatchData
+{
+  GCallback batch_func;
+  GDestroyNotify batch_data_destroy;
+  GMutex mutex;
+  GPtrArray *source_images;
+  GQueue results;
+  gboolean flush_scheduled;
+  gboolean pixbufs;
+  gint next_index;
+  gpointer batch_data;
+  guint n_delivered;
+};
+
+struct _GdFrameRendererBatchResult
+{
+  gpointer framed_image;
+  guint index;
+};
+
+G_DEFINE_TYPE (GdFrameRenderer, gd_frame_renderer, G_TYPE_OBJECT)
+
+static void
+gd_frame_renderer_draw_slice (GdFrameRenderer *self,
+                              cairo_t         *cr,
+                              guint            slice,
+                              gdouble          x,
+                              gdouble          y,
+                              gdouble          width,
+                              gdouble          height)
+{
+  cairo_surface_t *surface = self->slices[slice];
+
+  if (surface == NULL || width <= 0.0 || height <= 0.0)
+    return;
+
+  cairo_save (cr);
+
+  cairo_rectangle (cr, x, y, width, height);
+  cairo_clip (cr);
+
+  cairo_translate (cr, x, y);
+  cairo_scale (cr,
+               width / (gdouble) cairo_image_surface_get_width (surface),
+               height / (gdouble) cairo_image_surface_get_height (surface));
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_PAD);
+  cairo_paint (cr);
+
+  cairo_restore (cr);
+}
+
+static void
+gd_frame_renderer_draw_frame (GdFrameRenderer *self, cairo_t *cr, gdouble width, gdouble height)
+{
+  const GtkBorder *border = &self->border_width;
+  gdouble inner_height;
+  gdouble inner_width;
+  gdouble bottom;
+  gdouble right;
+
+  bottom = height - border->bottom;
+  right = width - border->right;
+  inner_height = height - border->top - border->bottom;
+  inner_width = width - border->left - border->right;
+
+  gd_frame_renderer_draw_slice (self, cr, SLICE_TOP_LEFT, 0, 0, border->left, border->top);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_TOP, border->left, 0, inner_width, border->top);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_TOP_RIGHT, right, 0, border->right, border->top);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_RIGHT, right, border->top, border->right, inner_height);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_BOTTOM_RIGHT, right, bottom, border->right, border->bottom);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_BOTTOM, border->left, bottom, inner_width, border->bottom);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_BOTTOM_LEFT, 0, bottom, border->left, border->bottom);
+  gd_frame_renderer_draw_slice (self, cr, SLICE_LEFT, 0, border->top, border->left, inner_height);
+}
+
+/* Each slice gets a surface of its own, so that filtering at its edges
+ * doesn't pick up the pixels of its neighbours.
+ */
+static cairo_surface_t *
+gd_frame_renderer_cut_slice (cairo_surface_t *frame, gint x, gint y, gint width, gint height)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  if (width <= 0 || height <= 0)
+    return NULL;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, frame, -x, -y);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+static GdkPixbuf *
+gd_frame_renderer_load_pixbuf (const gchar *frame_image_url, GError **error)
+{
+  GdkPixbuf *pixbuf = NULL;
+  GFile *file;
+  GFileInputStream *stream;
+  gchar *scheme;
+
+  scheme = g_uri_parse_scheme (frame_image_url);
+  if (scheme != NULL)
+    file = g_file_new_for_uri (frame_image_url);
+  else
+    file = g_file_new_for_path (frame_image_url);
+
+  stream = g_file_read (file, NULL, error);
+  if (stream == NULL)
+    goto out;
+
+  pixbuf = gdk_pixbuf_new_from_stream (G_INPUT_STREAM (stream), NULL, error);
+
+ out:
+  g_clear_object (&stream);
+  g_object_unref (file);
+  g_free (scheme);
+  return pixbuf;
+}
+
+static void
+gd_frame_renderer_finalize (GObject *obj)
+{
+  GdFrameRenderer *self = GD_FRAME_RENDERER (obj);
+  guint i;
+
+  for (i = 0; i < NUM_SLICES; i++)
+    g_clear_pointer (&self->slices[i], cairo_surface_destroy);
+
+  G_OBJECT_CLASS (gd_frame_renderer_parent_class)->finalize (obj);
+}
+
+static void
+gd_frame_renderer_init (GdFrameRenderer *self)
+{
+}
+
+static void
+gd_frame_renderer_class_init (GdFrameRendererClass *klass)
+{
+  GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+  oclass->finalize = gd_frame_renderer_finalize;
+}
+
+/**
+ * gd_frame_renderer_new:
+ * @frame_image_url: the URI or path of the frame image
+ * @slice_width: where to cut the frame image, in its pixels
+ * @border_width: the width of the frame around the images
+ * @error:
+ *
+ * Loads the frame image. The arguments mean the same as in the CSS
+ * border-image "url(@frame_image_url) @slice_width / @border_width".
+ *
+ * Returns: (transfer full) (nullable): A new #GdFrameRenderer, or
+ * %NULL if the frame image could not be loaded.
+ */
+GdFrameRenderer *
+gd_frame_renderer_new (const gchar      *frame_image_url,
+                       const GtkBorder  *slice_width,
+                       const GtkBorder  *border_width,
+                       GError          **error)
+{
+  GdFrameRenderer *self = NULL;
+  GdkPixbuf *pixbuf;
+  GtkBorder slice;
+  cairo_surface_t *frame;
+  gint center_height;
+  gint center_width;
+  gint height;
+  gint width;
+
+  g_return_val_if_fail (frame_image_url != NULL, NULL);
+  g_return_val_if_fail (slice_width != NULL, NULL);
+  g_return_val_if_fail (border_width != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  pixbuf = gd_frame_renderer_load_pixbuf (frame_image_url, error);
+  if (pixbuf == NULL)
+    goto out;
+
+  frame = gd_create_surface_from_pixbuf (pixbuf, 1);
+  height = gdk_pixbuf_get_height (pixbuf);
+  width = gdk_pixbuf_get_width (pixbuf);
+  g_object_unref (pixbuf);
+
+  /* Like CSS, slices that are too large are clamped. */
+  slice.left = CLAMP (slice_width->left, 0, width);
+  slice.right = CLAMP (slice_width->right, 0, width - slice.left);
+  slice.top = CLAMP (slice_width->top, 0, height);
+  slice.bottom = CLAMP (slice_width->bottom, 0, height - slice.top);
+  center_height = height - slice.top - slice.bottom;
+  center_width = width - slice.left - slice.right;
+
+  self = g_object_new (GD_TYPE_FRAME_RENDERER, NULL);
+  self->border_width = *border_width;
+
+  self->slices[SLICE_TOP_LEFT] = gd_frame_renderer_cut_slice (frame, 0, 0, slice.left, slice.top);
+  self->slices[SLICE_TOP] = gd_frame_renderer_cut_slice (frame, slice.left, 0, center_width, slice.top);
+  self->slices[SLICE_TOP_RIGHT] = gd_frame_renderer_cut_slice (frame, width - slice.right, 0, slice.right, slice.top);
+  self->slices[SLICE_RIGHT] = gd_frame_renderer_cut_slice (frame,
+                                                           width - slice.right,
+                                                           slice.top,
+                                                           slice.right,
+                                                           center_height);
+  self->slices[SLICE_BOTTOM_RIGHT] = gd_frame_renderer_cut_slice (frame,
+                                                                  width - slice.right,
+                                                                  height - slice.bottom,
+                                                                  slice.right,
+                                                                  slice.bottom);
+  self->slices[SLICE_BOTTOM] = gd_frame_renderer_cut_slice (frame,
+                                                            slice.left,
+                                                            height - slice.bottom,
+                                                            center_width,
+                                                            slice.bottom);
+  self->slices[SLICE_BOTTOM_LEFT] = gd_frame_renderer_cut_slice (frame, 0, height - slice.bottom, slice.left, slice.bottom);
+  self->slices[SLICE_LEFT] = gd_frame_renderer_cut_slice (frame, 0, slice.top, slice.left, center_height);
+
+  cairo_surface_destroy (frame);
+
+ out:
+  return self;
+}
+
+/**
+ * gd_frame_renderer_render:
+ * @self:
+ * @source_image: an image surface
+ *
+ * Draws @source_image inside the borders, and the frame over its
+ * edges.
+ *
+ * Returns: (transfer full): A new surface of the same size as
+ * @source_image.
+ */
+cairo_surface_t *
+gd_frame_renderer_render (GdFrameRenderer *self, cairo_surface_t *source_image)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gdouble scale_x;
+  gdouble scale_y;
+  gint source_height;
+  gint source_width;
+
+  g_return_val_if_fail (GD_IS_FRAME_RENDERER (self), NULL);
+  g_return_val_if_fail (source_image != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (source_image) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+
+  cairo_surface_get_device_scale (source_image, &scale_x, &scale_y);
+
+  source_width = cairo_image_surface_get_width (source_image) / (gint) floor (scale_x);
+  source_height = cairo_image_surface_get_height (source_image) / (gint) floor (scale_y);
+
+  surface = cairo_surface_create_similar (source_image,
+                                          CAIRO_CONTENT_COLOR_ALPHA,
+                                          source_width, source_height);
+  cr = cairo_create (surface);
+
+  cairo_save (cr);
+  cairo_rectangle (cr,
+                   self->border_width.left,
+                   self->border_width.top,
+                   source_width - self->border_width.left - self->border_width.right,
+                   source_height - self->border_width.top - self->border_width.bottom);
+  cairo_clip (cr);
+  cairo_set_source_surface (cr, source_image, 0, 0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  gd_frame_renderer_draw_frame (self, cr, source_width, source_height);
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+/**
+ * gd_frame_renderer_render_pixbuf:
+ * @self:
+ * @source_image:
+ *
+ * Like gd_frame_renderer_render(), but for a #GdkPixbuf.
+ *
+ * Returns: (transfer full):
+ */
+GdkPixbuf *
+gd_frame_renderer_render_pixbuf (GdFrameRenderer *self, GdkPixbuf *source_image)
+{
+  cairo_surface_t *surface, *embedded_surface;
+  GdkPixbuf *retval;
+
+  g_return_val_if_fail (GD_IS_FRAME_RENDERER (self), NULL);
+  g_return_val_if_fail (GDK_IS_PIXBUF (source_image), NULL);
+
+  /* Pixbufs are always in unscaled dimensions. */
+  surface = gd_create_surface_from_pixbuf (source_image, 1);
+  embedded_surface = gd_frame_renderer_render (self, surface);
+  retval = gd_create_pixbuf_from_surface (embedded_surface);
+
+  cairo_surface_destroy (embedded_surface);
+  cairo_surface_destroy (surface);
+
+  return retval;
+}
+
+static void
+gd_frame_renderer_batch_result_free (GdFrameRendererBatchResult *result, gboolean pixbufs)
+{
+  if (result->framed_image != NULL)
+    {
+      if (pixbufs)
+        g_object_unref (result->framed_image);
+      else
+        cairo_surface_destroy (result->framed_image);
+    }
+
+  g_slice_free (GdFrameRendererBatchResult, result);
+}
+
+static void
+gd_frame_renderer_batch_data_free (GdFrameRendererBatchData *data)
+{
+  GdFrameRendererBatchResult *result;
+
+  while ((result = g_queue_pop_head (&data->results)) != NULL)
+    gd_frame_renderer_batch_result_free (result, data->pixbufs);
+
+  if (data->batch_data_destroy != NULL)
+    data->batch_data_destroy (data->batch_data);
+
+  g_ptr_array_unref (data->source_images);
+  g_mutex_clear (&data->mutex);
+  g_slice_free (GdFrameRendererBatchData, data);
+}
+
+static gboolean
+gd_frame_renderer_batch_flush (gpointer user_data)
+{
+  GTask *task = G_TASK (user_data);
+  GdFrameRenderer *self;
+  GdFrameRendererBatchData *data;
+  GdFrameRendererBatchResult *result;
+  GCancellable *cancellable;
+  GQueue results;
+
+  self = GD_FRAME_RENDERER (g_task_get_source_object (task));
+  data = (GdFrameRendererBatchData *) g_task_get_task_data (task);
+  cancellable = g_task_get_cancellable (task);
+
+  g_mutex_lock (&data->mutex);
+  results = data->results;
+  g_queue_init (&data->results);
+  data->flush_scheduled = FALSE;
+  g_mutex_unlock (&data->mutex);
+
+  while ((result = g_queue_pop_head (&results)) != NULL)
+    {
+      data->n_delivered++;
+
+      if (result->framed_image != NULL && !g_cancellable_is_cancelled (cancellable))
+        {
+          if (data->pixbufs)
+            ((GdFrameRendererPixbufFunc) data->batch_func) (self,
+                                                            result->index,
+                                                            result->framed_image,
+                                                            data->batch_data);
+          else
+            ((GdFrameRendererSurfaceFunc) data->batch_func) (self,
+                                                             result->index,
+                                                             result->framed_image,
+                                                             data->batch_data);
+        }
+
+      gd_frame_renderer_batch_result_free (result, data->pixbufs);
+    }
+
+  if (data->n_delivered == data->source_images->len)
+    {
+      if (!g_task_return_error_if_cancelled (task))
+        g_task_return_boolean (task, TRUE);
+
+      /* Drop the reference taken for the workers. */
+      g_object_unref (task);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Every image of a batch is pushed as a separate job, so the jobs of
+ * different batches interleave instead of one large batch holding up
+ * all the others. Each job claims the next image that is left.
+ */
+static void
+gd_frame_renderer_batch_worker (gpointer job_data, gpointer user_data)
+{
+  GTask *task = G_TASK (job_data);
+  GdFrameRenderer *self;
+  GdFrameRendererBatchData *data;
+  GdFrameRendererBatchResult *result;
+  gpointer source_image;
+
+  self = GD_FRAME_RENDERER (g_task_get_source_object (task));
+  data = (GdFrameRendererBatchData *) g_task_get_task_data (task);
+
+  result = g_slice_new0 (GdFrameRendererBatchResult);
+  result->index = (guint) g_atomic_int_add (&data->next_index, 1);
+
+  if (!g_cancellable_is_cancelled (g_task_get_cancellable (task)))
+    {
+      source_image = g_ptr_array_index (data->source_images, result->index);
+      if (data->pixbufs)
+        result->framed_image = gd_frame_renderer_render_pixbuf (self, source_image);
+      else
+        result->framed_image = gd_frame_renderer_render (self, source_image);
+    }
+
+  /* Results are handed over to the main context in bunches, instead
+   * of waking it up once for every image.
+   */
+  g_mutex_lock (&data->mutex);
+
+  g_queue_push_tail (&data->results, result);
+  if (!data->flush_scheduled)
+    {
+      GSource *source;
+
+      source = g_idle_source_new ();
+      g_task_attach_source (task, source, gd_frame_renderer_batch_flush);
+      g_source_unref (source);
+
+      data->flush_scheduled = TRUE;
+    }
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static GThreadPool *
+gd_frame_renderer_get_thread_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (gd_frame_renderer_batch_worker,
+                                    NULL,
+                                    (gint) g_get_num_processors (),
+                                    FALSE,
+                                    NULL);
+      g_once_init_leave (&pool, (gsize) new_pool);
+    }
+
+  return (GThreadPool *) pool;
+}
+
+static void
+gd_frame_renderer_render_batch_async (GdFrameRenderer     *self,
+                                      GPtrArray           *source_images,
+                                      gboolean             pixbufs,
+                                      GCancellable        *cancellable,
+                                      GCallback            batch_func,
+                                      gpointer             batch_data,
+                                      GDestroyNotify       batch_data_destroy,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data,
+                                      gpointer             source_tag)
+{
+  GdFrameRendererBatchData *data;
+  GThreadPool *pool;
+  GTask *task;
+  guint i;
+
+  data = g_slice_new0 (GdFrameRendererBatchData);
+  data->batch_func = batch_func;
+  data->batch_data = batch_data;
+  data->batch_data_destroy = batch_data_destroy;
+  data->pixbufs = pixbufs;
+  data->source_images = source_images;
+  g_mutex_init (&data->mutex);
+  g_queue_init (&data->results);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, source_tag);
+  g_task_set_task_data (task, data, (GDestroyNotify) gd_frame_renderer_batch_data_free);
+
+  if (source_images->len == 0)
+    {
+      g_task_return_boolean (task, TRUE);
+      goto out;
+    }
+
+  /* Kept until the last result has been delivered. */
+  g_object_ref (task);
+
+  pool = gd_frame_renderer_get_thread_pool ();
+  for (i = 0; i < source_images->len; i++)
+    g_thread_pool_push (pool, task, NULL);
+
+ out:
+  g_object_unref (task);
+}
+
+/**
+ * gd_frame_renderer_render_surfaces_async:
+ * @self:
+ * @source_images: (array length=n_images): image surfaces
+ * @n_images:
+ * @cancellable: (nullable):
+ * @surface_func: (scope notified): called with each framed surface
+ * @surface_data:
+ * @surface_data_destroy:
+ * @callback:
+ * @user_data:
+ *
+ * Frames @source_images on a pool of worker threads, bounded by the
+ * number of processors. @surface_func is called on the thread-default
+ * main context as soon as each image is done, so the order in which
+ * the indices arrive is unspecified. @callback is called after the
+ * last one.
+ */
+void
+gd_frame_renderer_render_surfaces_async (GdFrameRenderer             *self,
+                                         cairo_surface_t            **source_images,
+                                         guint                        n_images,
+                                         GCancellable                *cancellable,
+                                         GdFrameRendererSurfaceFunc   surface_func,
+                                         gpointer                     surface_data,
+                                         GDestroyNotify               surface_data_destroy,
+                                         GAsyncReadyCallback          callback,
+                                         gpointer                     user_data)
+{
+  GPtrArray *array;
+  guint i;
+
+  g_return_if_fail (GD_IS_FRAME_RENDERER (self));
+  g_return_if_fail (source_images != NULL || n_images == 0);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+  g_return_if_fail (surface_func != NULL);
+
+  array = g_ptr_array_new_full (n_images, (GDestroyNotify) cairo_surface_destroy);
+  for (i = 0; i < n_images; i++)
+    g_ptr_array_add (array, cairo_surface_reference (source_images[i]));
+
+  gd_frame_renderer_render_batch_async (self,
+                                        array,
+                                        FALSE,
+                                        cancellable,
+                                        G_CALLBACK (surface_func),
+                                        surface_data,
+                                        surface_data_destroy,
+                                        callback,
+                                        user_data,
+                                        gd_frame_renderer_render_surfaces_async);
+}
+
+/**
+ * gd_frame_renderer_render_pixbufs_async:
+ * @self:
+ * @source_images: (array length=n_images):
+ * @n_images:
+ * @cancellable: (nullable):
+ * @pixbuf_func: (scope notified): called with each framed pixbuf
+ * @pixbuf_data:
+ * @pixbuf_data_destroy:
+ * @callback:
+ * @user_data:
+ *
+ * Like gd_frame_renderer_render_surfaces_async(), but for #GdkPixbufs.
+ */
+void
+gd_frame_renderer_render_pixbufs_async (GdFrameRenderer            *self,
+                                        GdkPixbuf                 **source_images,
+                                        guint                       n_images,
+                                        GCancellable               *cancellable,
+                                        GdFrameRendererPixbufFunc   pixbuf_func,
+                                        gpointer                    pixbuf_data,
+                                        GDestroyNotify              pixbuf_data_destroy,
+                                        GAsyncReadyCallback         callback,
+                                        gpointer                    user_data)
+{
+  GPtrArray *array;
+  guint i;
+
+  g_return_if_fail (GD_IS_FRAME_RENDERER (self));
+  g_return_if_fail (source_images != NULL || n_images == 0);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+  g_return_if_fail (pixbuf_func != NULL);
+
+  array = g_ptr_array_new_full (n_images, g_object_unref);
+  for (i = 0; i < n_images; i++)
+    g_ptr_array_add (array, g_object_ref (source_images[i]));
+
+  gd_frame_renderer_render_batch_async (self,
+                                        array,
+                                        TRUE,
+                                        cancellable,
+                                        G_CALLBACK (pixbuf_func),
+                                        pixbuf_data,
+                                        pixbuf_data_destroy,
+                                        callback,
+                                        user_data,
+                                        gd_frame_renderer_render_pixbufs_async);
+}
+
+gboolean
+gd_frame_renderer_render_finish (GdFrameRenderer *self, GAsyncResult *res, GError **error)
+{
+  g_return_val_if_fail (GD_IS_FRAME_RENDERER (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (res)) == gd_frame_renderer_render_surfaces_async
+                        || g_task_get_source_tag (G_TASK (res)) == gd_frame_renderer_render_pixbufs_async,
+                        FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GD_FRAME_RENDERER_H__
+#define __GD_FRAME_RENDERER_H__
+
+#include <cairo.h>
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GD_TYPE_FRAME_RENDERER gd_frame_renderer_get_type()
+G_DECLARE_FINAL_TYPE (GdFrameRenderer, gd_frame_renderer, GD, FRAME_RENDERER, GObject)
+
+typedef void (* GdFrameRendererPixbufFunc)  (GdFrameRenderer *self,
+                                             guint            index,
+                                             GdkPixbuf       *framed_image,
+                                             gpointer         user_data);
+typedef void (* GdFrameRendererSurfaceFunc) (GdFrameRenderer *self,
+                                             guint            index,
+                                             cairo_surface_t *framed_image,
+                                             gpointer         user_data);
+
+GdFrameRenderer  * gd_frame_renderer_new          (const gchar      *frame_image_url,
+                                                   const GtkBorder  *slice_width,
+                                                   const GtkBorder  *border_width,
+                                                   GError          **error);
+
+cairo_surface_t  * gd_frame_renderer_render       (GdFrameRenderer *self, cairo_surface_t *source_image);
+GdkPixbuf        * gd_frame_renderer_render_pixbuf (GdFrameRenderer *self, GdkPixbuf *source_image);
+
+void               gd_frame_renderer_render_pixbufs_async  (GdFrameRenderer             *self,
+                                                            GdkPixbuf                  **source_images,
+                                                            guint                        n_images,
+                                                            GCancellable                *cancellable,
+                                                            GdFrameRendererPixbufFunc    pixbuf_func,
+                                                            gpointer                     pixbuf_data,
+                                                            GDestroyNotify               pixbuf_data_destroy,
+                                                            GAsyncReadyCallback          callback,
+                                                            gpointer                     user_data);
+void               gd_frame_renderer_render_surfaces_async (GdFrameRenderer             *self,
+                                                            cairo_surface_t            **source_images,
+                                                            guint                        n_images,
+                                                            GCancellable                *cancellable,
+                                                            GdFrameRendererSurfaceFunc   surface_func,
+                                                            gpointer                     surface_data,
+                                                            GDestroyNotify               surface_data_destroy,
+                                                            GAsyncReadyCallback          callback,
+                                                            gpointer                     user_data);
+gboolean           gd_frame_renderer_render_finish         (GdFrameRenderer             *self,
+                                                            GAsyncResult                *res,
+                                                            GError                     **error);
+
+G_END_DECLS
+
+#endif /* __GD_FRAME_RENDERER_H__ */
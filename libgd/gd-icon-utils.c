@@ -20,6 +20,8 @@
  */
 
 #include "gd-icon-utils.h"
+#include "gd-image-scaler.h"
+#include "gd-symbolic-icon-factory.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <string.h>
@@ -42,6 +44,16 @@ gd_copy_image_surface (cairo_surface_t *surface)
   gdouble scale_x;
   gdouble scale_y;
 
+  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE
+      && cairo_image_surface_get_format (surface) == CAIRO_FORMAT_ARGB32)
+    {
+      copy = gd_image_scaler_scale_surface (surface,
+                                            cairo_image_surface_get_width (surface),
+                                            cairo_image_surface_get_height (surface),
+                                            GD_IMAGE_SCALER_FILTER_GOOD);
+      goto out;
+    }
+
   copy = cairo_surface_create_similar_image (surface, CAIRO_FORMAT_ARGB32,
                                              cairo_image_surface_get_width (surface),
                                              cairo_image_surface_get_height (surface));
@@ -53,9 +65,145 @@ gd_copy_image_surface (cairo_surface_t *surface)
   cairo_paint (cr);
   cairo_destroy (cr);
 
+ out:
+  return copy;
+}
+
+/**
+ * gd_copy_image_surface_for_window:
+ * @surface: an image surface
+ * @window: the #GdkWindow that the copy is going to be drawn to
+ *
+ * Copies @surface into a surface created by
+ * gdk_window_create_similar_surface(). Unlike @surface, the copy
+ * doesn't have to be uploaded to the windowing system every time it
+ * is drawn.
+ *
+ * Returns: (transfer full):
+ */
+cairo_surface_t *
+gd_copy_image_surface_for_window (cairo_surface_t *surface, GdkWindow *window)
+{
+  cairo_surface_t *copy;
+  cairo_t *cr;
+  gdouble scale_x;
+  gdouble scale_y;
+  gint height;
+  gint width;
+
+  g_return_val_if_fail (surface != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+  g_return_val_if_fail (GDK_IS_WINDOW (window), NULL);
+
+  cairo_surface_get_device_scale (surface, &scale_x, &scale_y);
+  height = (gint) ceil ((gdouble) cairo_image_surface_get_height (surface) / scale_y);
+  width = (gint) ceil ((gdouble) cairo_image_surface_get_width (surface) / scale_x);
+
+  copy = gdk_window_create_similar_surface (window, CAIRO_CONTENT_COLOR_ALPHA, width, height);
+
+  cr = cairo_create (copy);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
   return copy;
 }
 
+/**
+ * gd_create_surface_from_pixbuf:
+ * @pixbuf:
+ * @scale: the device scale of the new surface
+ *
+ * Like gdk_cairo_surface_create_from_pixbuf() without a window, but
+ * converts the pixels in a single pass with SIMD where the CPU has it,
+ * and reads them without copying the pixbuf. It is safe to call from
+ * any thread.
+ *
+ * Returns: (transfer full): A %CAIRO_FORMAT_ARGB32 surface, or a
+ * %CAIRO_FORMAT_RGB24 one if @pixbuf has no alpha channel.
+ */
+cairo_surface_t *
+gd_create_surface_from_pixbuf (GdkPixbuf *pixbuf, gint scale)
+{
+  cairo_surface_t *surface;
+  gboolean has_alpha;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+  g_return_val_if_fail (scale > 0, NULL);
+
+  has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+
+  if (gdk_pixbuf_get_bits_per_sample (pixbuf) != 8
+      || gdk_pixbuf_get_n_channels (pixbuf) != (has_alpha ? 4 : 3))
+    return gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+
+  surface = cairo_image_surface_create (has_alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                        gdk_pixbuf_get_width (pixbuf),
+                                        gdk_pixbuf_get_height (pixbuf));
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    goto out;
+
+  cairo_surface_flush (surface);
+  gd_image_scaler_premultiply (gdk_pixbuf_read_pixels (pixbuf),
+                               gdk_pixbuf_get_rowstride (pixbuf),
+                               has_alpha,
+                               cairo_image_surface_get_data (surface),
+                               cairo_image_surface_get_stride (surface),
+                               gdk_pixbuf_get_width (pixbuf),
+                               gdk_pixbuf_get_height (pixbuf));
+  cairo_surface_mark_dirty (surface);
+
+  cairo_surface_set_device_scale (surface, (gdouble) scale, (gdouble) scale);
+
+ out:
+  return surface;
+}
+
+/**
+ * gd_create_pixbuf_from_surface:
+ * @surface: an image surface
+ *
+ * Like gdk_pixbuf_get_from_surface() for the whole of @surface, with
+ * the same conversion as gd_create_surface_from_pixbuf().
+ *
+ * Returns: (transfer full) (nullable):
+ */
+GdkPixbuf *
+gd_create_pixbuf_from_surface (cairo_surface_t *surface)
+{
+  GdkPixbuf *pixbuf;
+  gint height;
+  gint width;
+
+  g_return_val_if_fail (surface != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+
+  height = cairo_image_surface_get_height (surface);
+  width = cairo_image_surface_get_width (surface);
+
+  if (cairo_image_surface_get_format (surface) != CAIRO_FORMAT_ARGB32)
+    {
+      pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, width, height);
+      goto out;
+    }
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+  if (pixbuf == NULL)
+    goto out;
+
+  cairo_surface_flush (surface);
+  gd_image_scaler_unpremultiply (cairo_image_surface_get_data (surface),
+                                 cairo_image_surface_get_stride (surface),
+                                 gdk_pixbuf_get_pixels (pixbuf),
+                                 gdk_pixbuf_get_rowstride (pixbuf),
+                                 width,
+                                 height);
+
+ out:
+  return pixbuf;
+}
+
 /**
  * gd_create_surface_with_counter:
  * @widget:
@@ -168,28 +316,40 @@ gd_create_surface_with_counter (GtkWidget *widget, cairo_surface_t *base, gint n
   return surface;
 }
 
-/**
- * gd_create_symbolic_icon_for_scale:
- * @name:
- * @base_size:
- * @scale:
- *
- * Returns: (transfer full):
+/* Creates the style context that _gd_create_symbolic_surface_for_style()
+ * expects.
  */
-GIcon *
-gd_create_symbolic_icon_for_scale (const gchar *name,
-                                   gint base_size,
-                                   gint scale)
+GtkStyleContext *
+_gd_create_symbolic_icon_style (void)
+{
+  GtkStyleContext *style;
+  GtkWidgetPath *path;
+
+  style = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_ICON_VIEW);
+  gtk_style_context_set_path (style, path);
+  gtk_widget_path_unref (path);
+
+  gtk_style_context_add_class (style, "documents-icon-bg");
+
+  return style;
+}
+
+cairo_surface_t *
+_gd_create_symbolic_surface_for_style (GtkStyleContext *style,
+                                       GtkIconTheme *theme,
+                                       const gchar *name,
+                                       gint base_size,
+                                       gint scale)
 {
   gchar *symbolic_name;
-  GIcon *icon, *retval = NULL;
+  GIcon *icon;
   cairo_surface_t *icon_surface;
-  cairo_surface_t *surface;
+  cairo_surface_t *surface, *retval = NULL;
   cairo_t *cr;
-  GtkStyleContext *style;
-  GtkWidgetPath *path;
   GdkPixbuf *pixbuf;
-  GtkIconTheme *theme;
   GtkIconInfo *info;
   gint bg_size;
   gint emblem_size;
@@ -206,22 +366,12 @@ gd_create_symbolic_icon_for_scale (const gchar *name,
   cairo_surface_set_device_scale (surface, (gdouble) scale, (gdouble) scale);
   cr = cairo_create (surface);
 
-  style = gtk_style_context_new ();
-
-  path = gtk_widget_path_new ();
-  gtk_widget_path_append_type (path, GTK_TYPE_ICON_VIEW);
-  gtk_style_context_set_path (style, path);
-  gtk_widget_path_unref (path);
-
-  gtk_style_context_add_class (style, "documents-icon-bg");
-
   gtk_render_background (style, cr, (total_size - bg_size) / 2, (total_size - bg_size) / 2, bg_size, bg_size);
 
   symbolic_name = g_strconcat (name, "-symbolic", NULL);
   icon = g_themed_icon_new_with_default_fallbacks (symbolic_name);
   g_free (symbolic_name);
 
-  theme = gtk_icon_theme_get_default();
   info = gtk_icon_theme_lookup_by_gicon_for_scale (theme, icon, emblem_size, scale,
                                                    GTK_ICON_LOOKUP_FORCE_SIZE);
   g_object_unref (icon);
@@ -235,22 +385,58 @@ gd_create_symbolic_icon_for_scale (const gchar *name,
   if (pixbuf == NULL)
     goto out;
 
-  icon_surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+  icon_surface = gd_create_surface_from_pixbuf (pixbuf, scale);
   g_object_unref (pixbuf);
 
   gtk_render_icon_surface (style, cr, icon_surface, (total_size - emblem_size) / 2,  (total_size - emblem_size) / 2);
   cairo_surface_destroy (icon_surface);
 
-  retval = G_ICON (gdk_pixbuf_get_from_surface (surface, 0, 0, total_size_scaled, total_size_scaled));
+  retval = cairo_surface_reference (surface);
 
  out:
-  g_object_unref (style);
   cairo_surface_destroy (surface);
   cairo_destroy (cr);
 
   return retval;
 }
 
+/**
+ * gd_create_symbolic_icon_for_scale:
+ * @name:
+ * @base_size:
+ * @scale:
+ *
+ * The icons come from the default #GdSymbolicIconFactory, and are
+ * shared with other callers.
+ *
+ * Returns: (transfer full):
+ */
+GIcon *
+gd_create_symbolic_icon_for_scale (const gchar *name,
+                                   gint base_size,
+                                   gint scale)
+{
+  return gd_symbolic_icon_factory_lookup (gd_symbolic_icon_factory_get_default (), name, base_size, scale);
+}
+
+/**
+ * gd_create_symbolic_surface_for_scale:
+ * @name:
+ * @base_size:
+ * @scale:
+ *
+ * Like gd_create_symbolic_icon_for_scale(), for drawing with cairo.
+ *
+ * Returns: (transfer full) (nullable):
+ */
+cairo_surface_t *
+gd_create_symbolic_surface_for_scale (const gchar *name,
+                                      gint base_size,
+                                      gint scale)
+{
+  return gd_symbolic_icon_factory_lookup_surface (gd_symbolic_icon_factory_get_default (), name, base_size, scale);
+}
+
 /**
  * gd_create_symbolic_icon:
  * @name:
@@ -265,6 +451,50 @@ gd_create_symbolic_icon (const gchar *name,
   return gd_create_symbolic_icon_for_scale (name, base_size, 1);
 }
 
+static GdFrameRenderer *
+gd_embed_get_frame_renderer (const gchar *frame_image_url,
+                             GtkBorder *slice_width,
+                             GtkBorder *border_width,
+                             GError **error)
+{
+  static GHashTable *renderers = NULL;
+  static GMutex renderers_mutex;
+  GdFrameRenderer *renderer;
+  gchar *key;
+
+  /* Callers keep embedding thumbnails into the same handful of frames,
+   * so the frame is only loaded and sliced the first time around.
+   */
+  key = g_strdup_printf ("%s %d %d %d %d / %d %d %d %d",
+                         frame_image_url,
+                         slice_width->top, slice_width->right, slice_width->bottom, slice_width->left,
+                         border_width->top, border_width->right, border_width->bottom, border_width->left);
+
+  g_mutex_lock (&renderers_mutex);
+
+  if (renderers == NULL)
+    renderers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  renderer = g_hash_table_lookup (renderers, key);
+  if (renderer != NULL)
+    {
+      g_object_ref (renderer);
+      g_free (key);
+    }
+  else
+    {
+      renderer = gd_frame_renderer_new (frame_image_url, slice_width, border_width, error);
+      if (renderer != NULL)
+        g_hash_table_insert (renderers, key, g_object_ref (renderer));
+      else
+        g_free (key);
+    }
+
+  g_mutex_unlock (&renderers_mutex);
+
+  return renderer;
+}
+
 /**
  * gd_embed_surface_in_frame:
  * @source_image:
@@ -280,79 +510,150 @@ gd_embed_surface_in_frame (cairo_surface_t *source_image,
                            GtkBorder *slice_width,
                            GtkBorder *border_width)
 {
-  cairo_surface_t *surface;
-  cairo_t *cr;
-  int source_width, source_height;
-  gchar *css_str;
-  GtkCssProvider *provider;
-  GtkStyleContext *context;
+  GdFrameRenderer *renderer;
   GError *error = NULL;
-  GtkWidgetPath *path;
-  gdouble scale_x, scale_y;
-
-  cairo_surface_get_device_scale (source_image, &scale_x, &scale_y);
-
-  source_width = cairo_image_surface_get_width (source_image) / (gint) floor (scale_x),
-  source_height = cairo_image_surface_get_height (source_image) / (gint) floor (scale_y);
-
-  css_str = g_strdup_printf (".embedded-image { border-image: url(\"%s\") %d %d %d %d / %dpx %dpx %dpx %dpx }",
-                             frame_image_url,
-                             slice_width->top, slice_width->right, slice_width->bottom, slice_width->left,
-                             border_width->top, border_width->right, border_width->bottom, border_width->left);
-  provider = gtk_css_provider_new ();
-  gtk_css_provider_load_from_data (provider, css_str, -1, &error);
+  cairo_surface_t *surface;
 
+  renderer = gd_embed_get_frame_renderer (frame_image_url, slice_width, border_width, &error);
   if (error != NULL)
     {
       g_warning ("Unable to create the thumbnail frame image: %s", error->message);
       g_error_free (error);
-      g_free (css_str);
 
-      return g_object_ref (source_image);
+      return cairo_surface_reference (source_image);
     }
 
-  surface = cairo_surface_create_similar (source_image,
-                                          CAIRO_CONTENT_COLOR_ALPHA,
-                                          source_width, source_height);
-  cr = cairo_create (surface);
+  surface = gd_frame_renderer_render (renderer, source_image);
+  g_object_unref (renderer);
 
-  context = gtk_style_context_new ();
-  path = gtk_widget_path_new ();
-  gtk_widget_path_append_type (path, GTK_TYPE_ICON_VIEW);
+  return surface;
+}
 
-  gtk_style_context_set_path (context, path);
-  gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (provider),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-
-  cairo_save (cr);
-  cairo_rectangle (cr,
-		   border_width->left,
-		   border_width->top,
-		   source_width - border_width->left - border_width->right,
-		   source_height - border_width->top - border_width->bottom);
-  cairo_clip (cr);
-  gtk_render_icon_surface (context, cr,
-                           source_image,
-                           0, 0);
-  cairo_restore (cr);
+/**
+ * gd_embed_surfaces_in_frame_async:
+ * @source_images: (array length=n_images):
+ * @n_images:
+ * @frame_image_url:
+ * @slice_width:
+ * @border_width:
+ * @cancellable: (nullable):
+ * @surface_func: (scope notified): called on the main context with
+ *   each framed surface and its index in @source_images
+ * @surface_data:
+ * @surface_data_destroy:
+ * @callback:
+ * @user_data:
+ *
+ * Like gd_embed_surface_in_frame(), but for a whole batch of images,
+ * which are framed on worker threads.
+ */
+void
+gd_embed_surfaces_in_frame_async (cairo_surface_t **source_images,
+                                  guint n_images,
+                                  const gchar *frame_image_url,
+                                  GtkBorder *slice_width,
+                                  GtkBorder *border_width,
+                                  GCancellable *cancellable,
+                                  GdFrameRendererSurfaceFunc surface_func,
+                                  gpointer surface_data,
+                                  GDestroyNotify surface_data_destroy,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data)
+{
+  GdFrameRenderer *renderer;
+  GError *error = NULL;
 
-  gtk_style_context_save (context);
-  gtk_style_context_add_class (context, "embedded-image");
+  renderer = gd_embed_get_frame_renderer (frame_image_url, slice_width, border_width, &error);
+  if (error != NULL)
+    {
+      if (surface_data_destroy != NULL)
+        surface_data_destroy (surface_data);
 
-  gtk_render_frame (context, cr,
-                    0, 0,
-                    source_width, source_height);
+      g_task_report_error (NULL, callback, user_data, gd_embed_surfaces_in_frame_async, error);
+      return;
+    }
 
-  gtk_style_context_restore (context);
-  cairo_destroy (cr);
+  gd_frame_renderer_render_surfaces_async (renderer,
+                                           source_images,
+                                           n_images,
+                                           cancellable,
+                                           surface_func,
+                                           surface_data,
+                                           surface_data_destroy,
+                                           callback,
+                                           user_data);
+  g_object_unref (renderer);
+}
 
-  gtk_widget_path_unref (path);
-  g_object_unref (provider);
-  g_object_unref (context);
-  g_free (css_str);
+/**
+ * gd_embed_images_in_frame_async:
+ * @source_images: (array length=n_images):
+ * @n_images:
+ * @frame_image_url:
+ * @slice_width:
+ * @border_width:
+ * @cancellable: (nullable):
+ * @pixbuf_func: (scope notified):
+ * @pixbuf_data:
+ * @pixbuf_data_destroy:
+ * @callback:
+ * @user_data:
+ *
+ * Like gd_embed_surfaces_in_frame_async(), but for #GdkPixbufs.
+ */
+void
+gd_embed_images_in_frame_async (GdkPixbuf **source_images,
+                                guint n_images,
+                                const gchar *frame_image_url,
+                                GtkBorder *slice_width,
+                                GtkBorder *border_width,
+                                GCancellable *cancellable,
+                                GdFrameRendererPixbufFunc pixbuf_func,
+                                gpointer pixbuf_data,
+                                GDestroyNotify pixbuf_data_destroy,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
+  GdFrameRenderer *renderer;
+  GError *error = NULL;
 
-  return surface;
+  renderer = gd_embed_get_frame_renderer (frame_image_url, slice_width, border_width, &error);
+  if (error != NULL)
+    {
+      if (pixbuf_data_destroy != NULL)
+        pixbuf_data_destroy (pixbuf_data);
+
+      g_task_report_error (NULL, callback, user_data, gd_embed_images_in_frame_async, error);
+      return;
+    }
+
+  gd_frame_renderer_render_pixbufs_async (renderer,
+                                          source_images,
+                                          n_images,
+                                          cancellable,
+                                          pixbuf_func,
+                                          pixbuf_data,
+                                          pixbuf_data_destroy,
+                                          callback,
+                                          user_data);
+  g_object_unref (renderer);
+}
+
+/**
+ * gd_embed_in_frame_finish:
+ * @res:
+ * @error:
+ *
+ * Finishes gd_embed_surfaces_in_frame_async() or
+ * gd_embed_images_in_frame_async().
+ */
+gboolean
+gd_embed_in_frame_finish (GAsyncResult *res,
+                          GError **error)
+{
+  g_return_val_if_fail (G_IS_TASK (res), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 /**
@@ -373,22 +674,97 @@ gd_embed_image_in_frame (GdkPixbuf *source_image,
   cairo_surface_t *surface, *embedded_surface;
   GdkPixbuf *retval;
 
-  surface = gdk_cairo_surface_create_from_pixbuf (source_image,
-                                                  0, NULL);
-
-  /* Force the device scale to 1.0, since pixbufs are always in unscaled
-   * dimensions.
-   */
-  cairo_surface_set_device_scale (surface, 1.0, 1.0);
+  /* Pixbufs are always in unscaled dimensions. */
+  surface = gd_create_surface_from_pixbuf (source_image, 1);
   embedded_surface = gd_embed_surface_in_frame (surface, frame_image_url,
                                                 slice_width, border_width);
-  retval = gdk_pixbuf_get_from_surface (embedded_surface,
-                                        0, 0,
-                                        cairo_image_surface_get_width (embedded_surface),
-                                        cairo_image_surface_get_height (embedded_surface));
+  retval = gd_create_pixbuf_from_surface (embedded_surface);
 
   cairo_surface_destroy (embedded_surface);
   cairo_surface_destroy (surface);
 
   return retval;
 }
+
+/**
+ * gd_zoom_image_surface:
+ * @surface: an image surface
+ * @width_zoomed: the width of the result in device pixels
+ * @height_zoomed: the height of the result in device pixels
+ *
+ * Scales with gd_image_scaler_get_default_filter().
+ *
+ * Returns: (transfer full): a copy of @surface scaled to the given size
+ */
+cairo_surface_t *
+gd_zoom_image_surface (cairo_surface_t *surface, gint width_zoomed, gint height_zoomed)
+{
+  g_return_val_if_fail (surface != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+
+  return gd_image_scaler_scale_surface (surface,
+                                        width_zoomed,
+                                        height_zoomed,
+                                        gd_image_scaler_get_default_filter ());
+}
+
+/**
+ * gd_zoom_image_size_to_fit:
+ * @width:
+ * @height:
+ * @max_width:
+ * @max_height:
+ * @out_width: (out):
+ * @out_height: (out):
+ *
+ * Computes the size that @width x @height has to be zoomed to in order
+ * to fill @max_width x @max_height without changing its aspect ratio.
+ * Sizes that don't fit to begin with are left as they are.
+ */
+void
+gd_zoom_image_size_to_fit (gint width,
+                           gint height,
+                           gint max_width,
+                           gint max_height,
+                           gint *out_width,
+                           gint *out_height)
+{
+  gdouble zoom;
+  gint height_zoomed;
+  gint width_zoomed;
+
+  if (height > width && max_height > height)
+    {
+      zoom = (gdouble) max_height / (gdouble) height;
+      height_zoomed = max_height;
+      width_zoomed = (gint) (zoom * (gdouble) width + 0.5);
+
+      if (max_width < width_zoomed)
+        {
+          zoom = (gdouble) max_width / (gdouble) width_zoomed;
+          height_zoomed = (gint) (zoom * (gdouble) height_zoomed + 0.5);
+          width_zoomed = max_width;
+        }
+    }
+  else if (height <= width && max_width > width)
+    {
+      zoom = (gdouble) max_width / (gdouble) width;
+      height_zoomed = (gint) (zoom * (gdouble) height + 0.5);
+      width_zoomed = max_width;
+
+      if (max_height < height_zoomed)
+        {
+          zoom = (gdouble) max_height / (gdouble) height_zoomed;
+          height_zoomed = max_height;
+          width_zoomed = (gint) (zoom * (gdouble) width_zoomed + 0.5);
+        }
+    }
+  else
+    {
+      height_zoomed = height;
+      width_zoomed = width;
+    }
+
+  *out_width = width_zoomed;
+  *out_height = height_zoomed;
+}
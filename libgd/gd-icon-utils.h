@@ -25,7 +25,15 @@
 #include <cairo.h>
 #include <gtk/gtk.h>
 
+#include "gd-frame-renderer.h"
+
 cairo_surface_t *gd_copy_image_surface (cairo_surface_t *surface);
+cairo_surface_t *gd_copy_image_surface_for_window (cairo_surface_t *surface,
+                                                   GdkWindow *window);
+
+GdkPixbuf *gd_create_pixbuf_from_surface (cairo_surface_t *surface);
+cairo_surface_t *gd_create_surface_from_pixbuf (GdkPixbuf *pixbuf,
+                                                gint scale);
 
 cairo_surface_t *gd_create_surface_with_counter (GtkWidget *widget,
                                                  cairo_surface_t *base,
@@ -36,6 +44,9 @@ GIcon *gd_create_symbolic_icon (const gchar *name,
 GIcon *gd_create_symbolic_icon_for_scale (const gchar *name,
                                           gint base_size,
                                           gint scale);
+cairo_surface_t *gd_create_symbolic_surface_for_scale (const gchar *name,
+                                                       gint base_size,
+                                                       gint scale);
 
 GdkPixbuf *gd_embed_image_in_frame (GdkPixbuf *source_image,
                                     const gchar *frame_image_url,
@@ -46,4 +57,47 @@ cairo_surface_t *gd_embed_surface_in_frame (cairo_surface_t *source_image,
                                             GtkBorder *slice_width,
                                             GtkBorder *border_width);
 
+void gd_embed_images_in_frame_async (GdkPixbuf **source_images,
+                                     guint n_images,
+                                     const gchar *frame_image_url,
+                                     GtkBorder *slice_width,
+                                     GtkBorder *border_width,
+                                     GCancellable *cancellable,
+                                     GdFrameRendererPixbufFunc pixbuf_func,
+                                     gpointer pixbuf_data,
+                                     GDestroyNotify pixbuf_data_destroy,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data);
+void gd_embed_surfaces_in_frame_async (cairo_surface_t **source_images,
+                                       guint n_images,
+                                       const gchar *frame_image_url,
+                                       GtkBorder *slice_width,
+                                       GtkBorder *border_width,
+                                       GCancellable *cancellable,
+                                       GdFrameRendererSurfaceFunc surface_func,
+                                       gpointer surface_data,
+                                       GDestroyNotify surface_data_destroy,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data);
+gboolean gd_embed_in_frame_finish (GAsyncResult *res,
+                                   GError **error);
+
+cairo_surface_t *gd_zoom_image_surface (cairo_surface_t *surface,
+                                        gint width_zoomed,
+                                        gint height_zoomed);
+void gd_zoom_image_size_to_fit (gint width,
+                                gint height,
+                                gint max_width,
+                                gint max_height,
+                                gint *out_width,
+                                gint *out_height);
+
+/* private */
+GtkStyleContext *_gd_create_symbolic_icon_style (void);
+cairo_surface_t *_gd_create_symbolic_surface_for_style (GtkStyleContext *style,
+                                                       GtkIconTheme *theme,
+                                                       const gchar *name,
+                                                       gint base_size,
+                                                       gint scale);
+
 #endif /* __GD_CREATE_SYMBOLIC_ICON_H__ */
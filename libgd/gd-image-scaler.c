@@ -0,0 +1,1147 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gd-image-scaler.h"
+
+#include <string.h>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define IMAGE_SCALER_X86 1
+#include <immintrin.h>
+#endif
+
+/* Scales images with 32 bits per pixel, like the ones in
+ * CAIRO_FORMAT_ARGB32 and CAIRO_FORMAT_RGB24 surfaces. The pixels are
+ * premultiplied, so all four channels can be treated alike and the
+ * byte order does not matter.
+ *
+ * Downscaling averages the source pixels covered by each destination
+ * pixel, and upscaling interpolates between the four nearest ones.
+ * Both are done separably: the source rows that contribute to a
+ * destination row are first combined into one, which is then
+ * resampled horizontally. The row passes have SSE2 and AVX2 versions,
+ * which are picked at runtime. They give the same results as the
+ * plain C ones.
+ *
+ * The same backends also convert between these pixels and the
+ * unpremultiplied RGBA ones of a GdkPixbuf.
+ */
+
+/* Beyond this many source pixels per destination pixel, the sums in
+ * the box filter could overflow a signed 32 bit integer.
+ */
+#define IMAGE_SCALER_MAX_BOX_AREA (G_MAXINT32 / 255)
+
+typedef struct _GdImageScalerBackend GdImageScalerBackend;
+
+struct _GdImageScalerBackend
+{
+  const gchar *name;
+  void (* box_accumulate)    (guint32 *accum, const guint8 *row, gint n_bytes);
+  void (* box_resolve)       (guint8 *dest, const guint32 *accum, const gint *x_bounds, gint dest_width, gint n_rows);
+  void (* bilinear_blend)    (guint16 *blend, const guint8 *row0, const guint8 *row1, gint n_bytes, guint weight);
+  void (* bilinear_resolve)  (guint8 *dest,
+                              const guint16 *blend,
+                              const gint *x_pairs,
+                              const guint16 *x_weights,
+                              gint dest_width);
+  void (* premultiply)       (guint32 *dest, const guint8 *src, gint width);
+  void (* unpremultiply)     (guint8 *dest, const guint32 *src, gint width);
+};
+
+static gint default_filter = GD_IMAGE_SCALER_FILTER_GOOD;
+
+static void
+gd_image_scaler_box_accumulate_c (guint32 *accum, const guint8 *row, gint n_bytes)
+{
+  gint i;
+
+  for (i = 0; i < n_bytes; i++)
+    accum[i] += row[i];
+}
+
+static void
+gd_image_scaler_box_resolve_c (guint8 *dest, const guint32 *accum, const gint *x_bounds, gint dest_width, gint n_rows)
+{
+  gint c;
+  gint dx;
+  gint x;
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      gfloat inv;
+
+      inv = 1.0f / (gfloat) ((x_bounds[dx + 1] - x_bounds[dx]) * n_rows);
+
+      for (c = 0; c < 4; c++)
+        {
+          guint32 sum = 0;
+
+          for (x = x_bounds[dx]; x < x_bounds[dx + 1]; x++)
+            sum += accum[x * 4 + c];
+
+          dest[dx * 4 + c] = (guint8) ((gfloat) (gint32) sum * inv + 0.5f);
+        }
+    }
+}
+
+/* For boxes too large for gd_image_scaler_box_resolve_c. */
+static void
+gd_image_scaler_box_resolve_wide (guint8 *dest, const guint32 *accum, const gint *x_bounds, gint dest_width, gint n_rows)
+{
+  gint c;
+  gint dx;
+  gint x;
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      guint64 count;
+
+      count = (guint64) (x_bounds[dx + 1] - x_bounds[dx]) * (guint64) n_rows;
+
+      for (c = 0; c < 4; c++)
+        {
+          guint64 sum = 0;
+
+          for (x = x_bounds[dx]; x < x_bounds[dx + 1]; x++)
+            sum += accum[x * 4 + c];
+
+          dest[dx * 4 + c] = (guint8) ((sum + count / 2) / count);
+        }
+    }
+}
+
+static void
+gd_image_scaler_bilinear_blend_c (guint16 *blend, const guint8 *row0, const guint8 *row1, gint n_bytes, guint weight)
+{
+  gint i;
+
+  for (i = 0; i < n_bytes; i++)
+    blend[i] = (guint16) ((row0[i] * (256 - weight) + row1[i] * weight + 128) >> 8);
+}
+
+static void
+gd_image_scaler_bilinear_resolve_c (guint8 *dest,
+                                    const guint16 *blend,
+                                    const gint *x_pairs,
+                                    const guint16 *x_weights,
+                                    gint dest_width)
+{
+  gint c;
+  gint dx;
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      const guint16 *a = blend + x_pairs[2 * dx] * 4;
+      const guint16 *b = blend + x_pairs[2 * dx + 1] * 4;
+      guint weight = x_weights[dx];
+
+      for (c = 0; c < 4; c++)
+        dest[dx * 4 + c] = (guint8) ((a[c] * (256 - weight) + b[c] * weight + 128) >> 8);
+    }
+}
+
+/* These round the same way as GDK, so pixbufs and surfaces converted
+ * here are identical to the ones from gdk_cairo_surface_create_from_pixbuf()
+ * and gdk_pixbuf_get_from_surface().
+ */
+static inline guint
+gd_image_scaler_multiply (guint c, guint a)
+{
+  guint t = c * a + 0x80;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static inline guint
+gd_image_scaler_divide (guint c, guint a)
+{
+  return MIN ((c * 255 + a / 2) / a, 255);
+}
+
+static void
+gd_image_scaler_premultiply_c (guint32 *dest, const guint8 *src, gint width)
+{
+  gint x;
+
+  for (x = 0; x < width; x++)
+    {
+      const guint8 *p = src + x * 4;
+      guint a = p[3];
+
+      dest[x] = a << 24
+        | gd_image_scaler_multiply (p[0], a) << 16
+        | gd_image_scaler_multiply (p[1], a) << 8
+        | gd_image_scaler_multiply (p[2], a);
+    }
+}
+
+static void
+gd_image_scaler_unpremultiply_c (guint8 *dest, const guint32 *src, gint width)
+{
+  gint x;
+
+  for (x = 0; x < width; x++)
+    {
+      guint8 *p = dest + x * 4;
+      guint32 pixel = src[x];
+      guint a = pixel >> 24;
+
+      if (a == 0)
+        {
+          p[0] = p[1] = p[2] = 0;
+        }
+      else
+        {
+          p[0] = (guint8) gd_image_scaler_divide ((pixel >> 16) & 0xff, a);
+          p[1] = (guint8) gd_image_scaler_divide ((pixel >> 8) & 0xff, a);
+          p[2] = (guint8) gd_image_scaler_divide (pixel & 0xff, a);
+        }
+
+      p[3] = (guint8) a;
+    }
+}
+
+static const GdImageScalerBackend backend_c =
+{
+  "c",
+  gd_image_scaler_box_accumulate_c,
+  gd_image_scaler_box_resolve_c,
+  gd_image_scaler_bilinear_blend_c,
+  gd_image_scaler_bilinear_resolve_c,
+  gd_image_scaler_premultiply_c,
+  gd_image_scaler_unpremultiply_c
+};
+
+#ifdef IMAGE_SCALER_X86
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_box_accumulate_sse2 (guint32 *accum, const guint8 *row, gint n_bytes)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  gint i;
+
+  for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+      __m128i *a = (__m128i *) (accum + i);
+      __m128i hi;
+      __m128i lo;
+      __m128i v;
+
+      v = _mm_loadu_si128 ((const __m128i *) (row + i));
+      lo = _mm_unpacklo_epi8 (v, zero);
+      hi = _mm_unpackhi_epi8 (v, zero);
+
+      _mm_storeu_si128 (a, _mm_add_epi32 (_mm_loadu_si128 (a), _mm_unpacklo_epi16 (lo, zero)));
+      _mm_storeu_si128 (a + 1, _mm_add_epi32 (_mm_loadu_si128 (a + 1), _mm_unpackhi_epi16 (lo, zero)));
+      _mm_storeu_si128 (a + 2, _mm_add_epi32 (_mm_loadu_si128 (a + 2), _mm_unpacklo_epi16 (hi, zero)));
+      _mm_storeu_si128 (a + 3, _mm_add_epi32 (_mm_loadu_si128 (a + 3), _mm_unpackhi_epi16 (hi, zero)));
+    }
+
+  gd_image_scaler_box_accumulate_c (accum + i, row + i, n_bytes - i);
+}
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_box_resolve_sse2 (guint8 *dest, const guint32 *accum, const gint *x_bounds, gint dest_width, gint n_rows)
+{
+  const __m128 half = _mm_set1_ps (0.5f);
+  gint dx;
+  gint x;
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      __m128 f;
+      __m128i sum = _mm_setzero_si128 ();
+      gfloat inv;
+      guint32 pixel;
+
+      for (x = x_bounds[dx]; x < x_bounds[dx + 1]; x++)
+        sum = _mm_add_epi32 (sum, _mm_loadu_si128 ((const __m128i *) (accum + x * 4)));
+
+      inv = 1.0f / (gfloat) ((x_bounds[dx + 1] - x_bounds[dx]) * n_rows);
+      f = _mm_add_ps (_mm_mul_ps (_mm_cvtepi32_ps (sum), _mm_set1_ps (inv)), half);
+
+      sum = _mm_cvttps_epi32 (f);
+      sum = _mm_packs_epi32 (sum, sum);
+      sum = _mm_packus_epi16 (sum, sum);
+
+      pixel = (guint32) _mm_cvtsi128_si32 (sum);
+      memcpy (dest + dx * 4, &pixel, sizeof (pixel));
+    }
+}
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_bilinear_blend_sse2 (guint16 *blend,
+                                     const guint8 *row0,
+                                     const guint8 *row1,
+                                     gint n_bytes,
+                                     guint weight)
+{
+  const __m128i round = _mm_set1_epi16 (128);
+  const __m128i w0 = _mm_set1_epi16 ((gshort) (256 - weight));
+  const __m128i w1 = _mm_set1_epi16 ((gshort) weight);
+  const __m128i zero = _mm_setzero_si128 ();
+  gint i;
+
+  for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+      __m128i hi;
+      __m128i lo;
+      __m128i r0;
+      __m128i r1;
+
+      r0 = _mm_loadu_si128 ((const __m128i *) (row0 + i));
+      r1 = _mm_loadu_si128 ((const __m128i *) (row1 + i));
+
+      lo = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (r0, zero), w0),
+                          _mm_mullo_epi16 (_mm_unpacklo_epi8 (r1, zero), w1));
+      hi = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (r0, zero), w0),
+                          _mm_mullo_epi16 (_mm_unpackhi_epi8 (r1, zero), w1));
+
+      _mm_storeu_si128 ((__m128i *) (blend + i), _mm_srli_epi16 (_mm_add_epi16 (lo, round), 8));
+      _mm_storeu_si128 ((__m128i *) (blend + i + 8), _mm_srli_epi16 (_mm_add_epi16 (hi, round), 8));
+    }
+
+  gd_image_scaler_bilinear_blend_c (blend + i, row0 + i, row1 + i, n_bytes - i, weight);
+}
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_bilinear_resolve_sse2 (guint8 *dest,
+                                       const guint16 *blend,
+                                       const gint *x_pairs,
+                                       const guint16 *x_weights,
+                                       gint dest_width)
+{
+  const __m128i round = _mm_set1_epi16 (128);
+  gint dx;
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      __m128i a;
+      __m128i b;
+      __m128i v;
+      __m128i weights;
+      gshort w0;
+      gshort w1;
+      guint32 pixel;
+
+      a = _mm_loadl_epi64 ((const __m128i *) (blend + x_pairs[2 * dx] * 4));
+      b = _mm_loadl_epi64 ((const __m128i *) (blend + x_pairs[2 * dx + 1] * 4));
+      v = _mm_unpacklo_epi64 (a, b);
+
+      w1 = (gshort) x_weights[dx];
+      w0 = (gshort) (256 - w1);
+      weights = _mm_set_epi16 (w1, w1, w1, w1, w0, w0, w0, w0);
+
+      v = _mm_mullo_epi16 (v, weights);
+      v = _mm_add_epi16 (v, _mm_srli_si128 (v, 8));
+      v = _mm_srli_epi16 (_mm_add_epi16 (v, round), 8);
+      v = _mm_packus_epi16 (v, v);
+
+      pixel = (guint32) _mm_cvtsi128_si32 (v);
+      memcpy (dest + dx * 4, &pixel, sizeof (pixel));
+    }
+}
+
+__attribute__ ((target ("avx2"))) static void
+gd_image_scaler_box_accumulate_avx2 (guint32 *accum, const guint8 *row, gint n_bytes)
+{
+  gint i;
+
+  for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+      __m256i *a = (__m256i *) (accum + i);
+      __m256i hi;
+      __m256i lo;
+
+      lo = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (row + i)));
+      hi = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (row + i + 8)));
+
+      _mm256_storeu_si256 (a, _mm256_add_epi32 (_mm256_loadu_si256 (a), lo));
+      _mm256_storeu_si256 (a + 1, _mm256_add_epi32 (_mm256_loadu_si256 (a + 1), hi));
+    }
+
+  gd_image_scaler_box_accumulate_c (accum + i, row + i, n_bytes - i);
+}
+
+__attribute__ ((target ("avx2"))) static void
+gd_image_scaler_bilinear_blend_avx2 (guint16 *blend,
+                                     const guint8 *row0,
+                                     const guint8 *row1,
+                                     gint n_bytes,
+                                     guint weight)
+{
+  const __m256i round = _mm256_set1_epi16 (128);
+  const __m256i w0 = _mm256_set1_epi16 ((gshort) (256 - weight));
+  const __m256i w1 = _mm256_set1_epi16 ((gshort) weight);
+  gint i;
+
+  for (i = 0; i + 16 <= n_bytes; i += 16)
+    {
+      __m256i r0;
+      __m256i r1;
+      __m256i v;
+
+      r0 = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (row0 + i)));
+      r1 = _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (row1 + i)));
+
+      v = _mm256_add_epi16 (_mm256_mullo_epi16 (r0, w0), _mm256_mullo_epi16 (r1, w1));
+      v = _mm256_srli_epi16 (_mm256_add_epi16 (v, round), 8);
+
+      _mm256_storeu_si256 ((__m256i *) (blend + i), v);
+    }
+
+  gd_image_scaler_bilinear_blend_c (blend + i, row0 + i, row1 + i, n_bytes - i, weight);
+}
+
+/* Premultiplies two RGBA pixels, widened to 16 bits per channel, and
+ * swaps red and blue. The alpha channel is multiplied by 255, which
+ * leaves it unchanged.
+ */
+__attribute__ ((target ("sse2"))) static inline __m128i
+gd_image_scaler_premultiply_pair_sse2 (__m128i v)
+{
+  const __m128i opaque = _mm_set_epi16 (255, 0, 0, 0, 255, 0, 0, 0);
+  const __m128i color = _mm_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1);
+  const __m128i round = _mm_set1_epi16 (0x80);
+  __m128i a;
+  __m128i t;
+
+  a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+  a = _mm_or_si128 (_mm_and_si128 (a, color), opaque);
+  v = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2)), _MM_SHUFFLE (3, 0, 1, 2));
+
+  t = _mm_add_epi16 (_mm_mullo_epi16 (v, a), round);
+  return _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+}
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_premultiply_sse2 (guint32 *dest, const guint8 *src, gint width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  gint x;
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i hi;
+      __m128i lo;
+      __m128i v;
+
+      v = _mm_loadu_si128 ((const __m128i *) (src + x * 4));
+      lo = gd_image_scaler_premultiply_pair_sse2 (_mm_unpacklo_epi8 (v, zero));
+      hi = gd_image_scaler_premultiply_pair_sse2 (_mm_unpackhi_epi8 (v, zero));
+
+      _mm_storeu_si128 ((__m128i *) (dest + x), _mm_packus_epi16 (lo, hi));
+    }
+
+  gd_image_scaler_premultiply_c (dest + x, src + x * 4, width - x);
+}
+
+/* The quotient is at most 255.5, and at least 1 / 255 away from the
+ * next integer unless it is one, so truncating the correctly rounded
+ * float gives the same result as the integer division.
+ */
+__attribute__ ((target ("sse2"))) static inline __m128i
+gd_image_scaler_divide_sse2 (__m128i c, __m128i half_a, __m128 a)
+{
+  __m128 q;
+
+  c = _mm_add_epi32 (_mm_sub_epi32 (_mm_slli_epi32 (c, 8), c), half_a);
+  q = _mm_min_ps (_mm_div_ps (_mm_cvtepi32_ps (c), a), _mm_set1_ps (255.0f));
+  return _mm_cvttps_epi32 (q);
+}
+
+__attribute__ ((target ("sse2"))) static void
+gd_image_scaler_unpremultiply_sse2 (guint8 *dest, const guint32 *src, gint width)
+{
+  const __m128i mask = _mm_set1_epi32 (0xff);
+  gint x;
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i half_a;
+      __m128i pixel;
+      __m128i a;
+      __m128i b;
+      __m128i g;
+      __m128i r;
+      __m128i v;
+      __m128 af;
+
+      v = _mm_loadu_si128 ((const __m128i *) (src + x));
+      a = _mm_srli_epi32 (v, 24);
+      af = _mm_cvtepi32_ps (a);
+      half_a = _mm_srli_epi32 (a, 1);
+
+      r = gd_image_scaler_divide_sse2 (_mm_and_si128 (_mm_srli_epi32 (v, 16), mask), half_a, af);
+      g = gd_image_scaler_divide_sse2 (_mm_and_si128 (_mm_srli_epi32 (v, 8), mask), half_a, af);
+      b = gd_image_scaler_divide_sse2 (_mm_and_si128 (v, mask), half_a, af);
+
+      pixel = _mm_or_si128 (_mm_or_si128 (r, _mm_slli_epi32 (g, 8)),
+                            _mm_or_si128 (_mm_slli_epi32 (b, 16), _mm_slli_epi32 (a, 24)));
+      pixel = _mm_andnot_si128 (_mm_cmpeq_epi32 (a, _mm_setzero_si128 ()), pixel);
+
+      _mm_storeu_si128 ((__m128i *) (dest + x * 4), pixel);
+    }
+
+  gd_image_scaler_unpremultiply_c (dest + x * 4, src + x, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static inline __m256i
+gd_image_scaler_premultiply_pair_avx2 (__m256i v)
+{
+  const __m256i opaque = _mm256_set_epi16 (255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+  const __m256i color = _mm256_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+  const __m256i round = _mm256_set1_epi16 (0x80);
+  __m256i a;
+  __m256i t;
+
+  a = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (v, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+  a = _mm256_or_si256 (_mm256_and_si256 (a, color), opaque);
+  v = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (v, _MM_SHUFFLE (3, 0, 1, 2)), _MM_SHUFFLE (3, 0, 1, 2));
+
+  t = _mm256_add_epi16 (_mm256_mullo_epi16 (v, a), round);
+  return _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+}
+
+/* Unpacking and packing both work within 128 bit lanes, so the pixels
+ * come out in the order they went in.
+ */
+__attribute__ ((target ("avx2"))) static void
+gd_image_scaler_premultiply_avx2 (guint32 *dest, const guint8 *src, gint width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  gint x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256i hi;
+      __m256i lo;
+      __m256i v;
+
+      v = _mm256_loadu_si256 ((const __m256i *) (src + x * 4));
+      lo = gd_image_scaler_premultiply_pair_avx2 (_mm256_unpacklo_epi8 (v, zero));
+      hi = gd_image_scaler_premultiply_pair_avx2 (_mm256_unpackhi_epi8 (v, zero));
+
+      _mm256_storeu_si256 ((__m256i *) (dest + x), _mm256_packus_epi16 (lo, hi));
+    }
+
+  gd_image_scaler_premultiply_sse2 (dest + x, src + x * 4, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static inline __m256i
+gd_image_scaler_divide_avx2 (__m256i c, __m256i half_a, __m256 a)
+{
+  __m256 q;
+
+  c = _mm256_add_epi32 (_mm256_sub_epi32 (_mm256_slli_epi32 (c, 8), c), half_a);
+  q = _mm256_min_ps (_mm256_div_ps (_mm256_cvtepi32_ps (c), a), _mm256_set1_ps (255.0f));
+  return _mm256_cvttps_epi32 (q);
+}
+
+__attribute__ ((target ("avx2"))) static void
+gd_image_scaler_unpremultiply_avx2 (guint8 *dest, const guint32 *src, gint width)
+{
+  const __m256i mask = _mm256_set1_epi32 (0xff);
+  gint x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256i half_a;
+      __m256i pixel;
+      __m256i a;
+      __m256i b;
+      __m256i g;
+      __m256i r;
+      __m256i v;
+      __m256 af;
+
+      v = _mm256_loadu_si256 ((const __m256i *) (src + x));
+      a = _mm256_srli_epi32 (v, 24);
+      af = _mm256_cvtepi32_ps (a);
+      half_a = _mm256_srli_epi32 (a, 1);
+
+      r = gd_image_scaler_divide_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (v, 16), mask), half_a, af);
+      g = gd_image_scaler_divide_avx2 (_mm256_and_si256 (_mm256_srli_epi32 (v, 8), mask), half_a, af);
+      b = gd_image_scaler_divide_avx2 (_mm256_and_si256 (v, mask), half_a, af);
+
+      pixel = _mm256_or_si256 (_mm256_or_si256 (r, _mm256_slli_epi32 (g, 8)),
+                               _mm256_or_si256 (_mm256_slli_epi32 (b, 16), _mm256_slli_epi32 (a, 24)));
+      pixel = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (a, _mm256_setzero_si256 ()), pixel);
+
+      _mm256_storeu_si256 ((__m256i *) (dest + x * 4), pixel);
+    }
+
+  gd_image_scaler_unpremultiply_sse2 (dest + x * 4, src + x, width - x);
+}
+
+static const GdImageScalerBackend backend_sse2 =
+{
+  "sse2",
+  gd_image_scaler_box_accumulate_sse2,
+  gd_image_scaler_box_resolve_sse2,
+  gd_image_scaler_bilinear_blend_sse2,
+  gd_image_scaler_bilinear_resolve_sse2,
+  gd_image_scaler_premultiply_sse2,
+  gd_image_scaler_unpremultiply_sse2
+};
+
+/* The horizontal passes work on one pixel, or 128 bits, at a time, so
+ * there is nothing for AVX2 to add to them.
+ */
+static const GdImageScalerBackend backend_avx2 =
+{
+  "avx2",
+  gd_image_scaler_box_accumulate_avx2,
+  gd_image_scaler_box_resolve_sse2,
+  gd_image_scaler_bilinear_blend_avx2,
+  gd_image_scaler_bilinear_resolve_sse2,
+  gd_image_scaler_premultiply_avx2,
+  gd_image_scaler_unpremultiply_avx2
+};
+
+#endif /* IMAGE_SCALER_X86 */
+
+/* The best backend that the CPU supports. GD_IMAGE_SCALER_BACKEND can
+ * be set to "c", "sse2" or "avx2" to pick a lesser one, which is
+ * mostly useful to compare them.
+ */
+static const GdImageScalerBackend *
+gd_image_scaler_get_backend_vtable (void)
+{
+  static const GdImageScalerBackend *backend;
+
+  if (g_once_init_enter (&backend))
+    {
+      const GdImageScalerBackend *candidates[3];
+      const GdImageScalerBackend *selected;
+      const gchar *requested;
+      guint i;
+      guint n_candidates = 0;
+
+      candidates[n_candidates++] = &backend_c;
+
+#ifdef IMAGE_SCALER_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("sse2"))
+        {
+          candidates[n_candidates++] = &backend_sse2;
+          if (__builtin_cpu_supports ("avx2"))
+            candidates[n_candidates++] = &backend_avx2;
+        }
+#endif
+
+      selected = candidates[n_candidates - 1];
+
+      requested = g_getenv ("GD_IMAGE_SCALER_BACKEND");
+      for (i = 0; requested != NULL && i < n_candidates; i++)
+        {
+          if (g_strcmp0 (requested, candidates[i]->name) == 0)
+            selected = candidates[i];
+        }
+
+      g_once_init_leave (&backend, selected);
+    }
+
+  return backend;
+}
+
+static void
+gd_image_scaler_paint_cairo (cairo_surface_t *dest, cairo_surface_t *src)
+{
+  cairo_t *cr;
+  cairo_pattern_t *pattern;
+  gdouble zoom_x;
+  gdouble zoom_y;
+
+  cr = cairo_create (dest);
+
+  pattern = cairo_get_source (cr);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REFLECT);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+
+  zoom_x = (gdouble) cairo_image_surface_get_width (dest) / (gdouble) cairo_image_surface_get_width (src);
+  zoom_y = (gdouble) cairo_image_surface_get_height (dest) / (gdouble) cairo_image_surface_get_height (src);
+  cairo_scale (cr, zoom_x, zoom_y);
+  cairo_set_source_surface (cr, src, 0, 0);
+
+  cairo_paint (cr);
+  cairo_destroy (cr);
+}
+
+static void
+gd_image_scaler_scale_box (const GdImageScalerBackend *backend,
+                           const guint8 *src,
+                           gint src_width,
+                           gint src_height,
+                           gint src_stride,
+                           guint8 *dest,
+                           gint dest_width,
+                           gint dest_height,
+                           gint dest_stride)
+{
+  guint32 *accum;
+  gint *x_bounds;
+  gint64 max_area;
+  gint dx;
+  gint dy;
+  gint y;
+  void (* box_resolve) (guint8 *, const guint32 *, const gint *, gint, gint);
+
+  accum = g_new (guint32, (gsize) src_width * 4);
+  x_bounds = g_new (gint, dest_width + 1);
+
+  for (dx = 0; dx <= dest_width; dx++)
+    x_bounds[dx] = (gint) ((gint64) dx * src_width / dest_width);
+
+  max_area = (gint64) (src_width / dest_width + 1) * (gint64) (src_height / dest_height + 1);
+  box_resolve = max_area <= IMAGE_SCALER_MAX_BOX_AREA ? backend->box_resolve : gd_image_scaler_box_resolve_wide;
+
+  for (dy = 0; dy < dest_height; dy++)
+    {
+      gint y0;
+      gint y1;
+
+      y0 = (gint) ((gint64) dy * src_height / dest_height);
+      y1 = (gint) ((gint64) (dy + 1) * src_height / dest_height);
+
+      memset (accum, 0, (gsize) src_width * 4 * sizeof (guint32));
+      for (y = y0; y < y1; y++)
+        backend->box_accumulate (accum, src + (gsize) y * src_stride, src_width * 4);
+
+      box_resolve (dest + (gsize) dy * dest_stride, accum, x_bounds, dest_width, y1 - y0);
+    }
+
+  g_free (accum);
+  g_free (x_bounds);
+}
+
+/* Maps the center of destination pixel @index back to the source, in
+ * 1/256ths of a pixel.
+ */
+static void
+gd_image_scaler_bilinear_map (gint src_size, gint dest_size, gint index, gint *out_i0, gint *out_i1, guint *out_weight)
+{
+  gint64 position;
+  gint i0;
+  guint weight;
+
+  position = ((2 * (gint64) index + 1) * src_size * 256) / (2 * (gint64) dest_size) - 128;
+  if (position < 0)
+    position = 0;
+
+  i0 = (gint) (position >> 8);
+  weight = (guint) (position & 0xff);
+  if (i0 >= src_size - 1)
+    {
+      i0 = src_size - 1;
+      weight = 0;
+    }
+
+  *out_i0 = i0;
+  *out_i1 = MIN (i0 + 1, src_size - 1);
+  *out_weight = weight;
+}
+
+static void
+gd_image_scaler_scale_bilinear (const GdImageScalerBackend *backend,
+                                const guint8 *src,
+                                gint src_width,
+                                gint src_height,
+                                gint src_stride,
+                                guint8 *dest,
+                                gint dest_width,
+                                gint dest_height,
+                                gint dest_stride)
+{
+  guint16 *blend;
+  guint16 *x_weights;
+  gint *x_pairs;
+  gint dx;
+  gint dy;
+  gint last_y0 = -1;
+  gint last_y1 = -1;
+  guint last_weight = 0;
+
+  blend = g_new (guint16, (gsize) src_width * 4);
+  x_pairs = g_new (gint, 2 * (gsize) dest_width);
+  x_weights = g_new (guint16, dest_width);
+
+  for (dx = 0; dx < dest_width; dx++)
+    {
+      guint weight;
+
+      gd_image_scaler_bilinear_map (src_width, dest_width, dx, &x_pairs[2 * dx], &x_pairs[2 * dx + 1], &weight);
+      x_weights[dx] = (guint16) weight;
+    }
+
+  for (dy = 0; dy < dest_height; dy++)
+    {
+      gint y0;
+      gint y1;
+      guint weight;
+
+      gd_image_scaler_bilinear_map (src_height, dest_height, dy, &y0, &y1, &weight);
+
+      /* Upscaling often maps consecutive rows to the same place. */
+      if (y0 != last_y0 || y1 != last_y1 || weight != last_weight)
+        {
+          backend->bilinear_blend (blend,
+                                   src + (gsize) y0 * src_stride,
+                                   src + (gsize) y1 * src_stride,
+                                   src_width * 4,
+                                   weight);
+          last_y0 = y0;
+          last_y1 = y1;
+          last_weight = weight;
+        }
+
+      backend->bilinear_resolve (dest + (gsize) dy * dest_stride, blend, x_pairs, x_weights, dest_width);
+    }
+
+  g_free (blend);
+  g_free (x_pairs);
+  g_free (x_weights);
+}
+
+static void
+gd_image_scaler_scale_nearest (const guint8 *src,
+                               gint src_width,
+                               gint src_height,
+                               gint src_stride,
+                               guint8 *dest,
+                               gint dest_width,
+                               gint dest_height,
+                               gint dest_stride)
+{
+  gint *x_map;
+  gint dx;
+  gint dy;
+
+  x_map = g_new (gint, dest_width);
+  for (dx = 0; dx < dest_width; dx++)
+    x_map[dx] = (gint) ((2 * (gint64) dx + 1) * src_width / (2 * (gint64) dest_width));
+
+  for (dy = 0; dy < dest_height; dy++)
+    {
+      const guint8 *src_row;
+      guint8 *dest_row;
+      gint y;
+
+      y = (gint) ((2 * (gint64) dy + 1) * src_height / (2 * (gint64) dest_height));
+      src_row = src + (gsize) y * src_stride;
+      dest_row = dest + (gsize) dy * dest_stride;
+
+      for (dx = 0; dx < dest_width; dx++)
+        memcpy (dest_row + dx * 4, src_row + x_map[dx] * 4, 4);
+    }
+
+  g_free (x_map);
+}
+
+/**
+ * gd_image_scaler_get_backend:
+ *
+ * Returns: The name of the implementation used by the scaler: "avx2",
+ * "sse2" or "c".
+ */
+const gchar *
+gd_image_scaler_get_backend (void)
+{
+  return gd_image_scaler_get_backend_vtable ()->name;
+}
+
+/**
+ * gd_image_scaler_get_default_filter:
+ *
+ * Returns: The filter used by gd_zoom_image_surface().
+ */
+GdImageScalerFilter
+gd_image_scaler_get_default_filter (void)
+{
+  return (GdImageScalerFilter) g_atomic_int_get (&default_filter);
+}
+
+/**
+ * gd_image_scaler_set_default_filter:
+ * @filter:
+ *
+ * Sets the filter used by gd_zoom_image_surface(). The default is
+ * %GD_IMAGE_SCALER_FILTER_GOOD.
+ */
+void
+gd_image_scaler_set_default_filter (GdImageScalerFilter filter)
+{
+  g_return_if_fail (filter <= GD_IMAGE_SCALER_FILTER_GOOD);
+  g_atomic_int_set (&default_filter, (gint) filter);
+}
+
+/**
+ * gd_image_scaler_scale:
+ * @src: the source pixels
+ * @src_width:
+ * @src_height:
+ * @src_stride:
+ * @dest: the destination pixels
+ * @dest_width:
+ * @dest_height:
+ * @dest_stride:
+ * @filter:
+ *
+ * Scales premultiplied pixels with 32 bits each, in the layout of
+ * %CAIRO_FORMAT_ARGB32, from @src to @dest.
+ */
+void
+gd_image_scaler_scale (const guint8        *src,
+                       gint                 src_width,
+                       gint                 src_height,
+                       gint                 src_stride,
+                       guint8              *dest,
+                       gint                 dest_width,
+                       gint                 dest_height,
+                       gint                 dest_stride,
+                       GdImageScalerFilter  filter)
+{
+  const GdImageScalerBackend *backend;
+  gint y;
+
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (dest != NULL);
+  g_return_if_fail (src_width > 0 && src_height > 0);
+  g_return_if_fail (dest_width > 0 && dest_height > 0);
+
+  if (filter == GD_IMAGE_SCALER_FILTER_CAIRO)
+    {
+      cairo_surface_t *dest_surface;
+      cairo_surface_t *src_surface;
+
+      src_surface = cairo_image_surface_create_for_data ((guint8 *) src,
+                                                         CAIRO_FORMAT_ARGB32,
+                                                         src_width,
+                                                         src_height,
+                                                         src_stride);
+      dest_surface = cairo_image_surface_create_for_data (dest,
+                                                          CAIRO_FORMAT_ARGB32,
+                                                          dest_width,
+                                                          dest_height,
+                                                          dest_stride);
+      gd_image_scaler_paint_cairo (dest_surface, src_surface);
+      cairo_surface_destroy (dest_surface);
+      cairo_surface_destroy (src_surface);
+      return;
+    }
+
+  if (src_width == dest_width && src_height == dest_height)
+    {
+      for (y = 0; y < src_height; y++)
+        memcpy (dest + (gsize) y * dest_stride, src + (gsize) y * src_stride, (gsize) src_width * 4);
+      return;
+    }
+
+  if (filter == GD_IMAGE_SCALER_FILTER_FAST)
+    {
+      gd_image_scaler_scale_nearest (src, src_width, src_height, src_stride,
+                                     dest, dest_width, dest_height, dest_stride);
+      return;
+    }
+
+  backend = gd_image_scaler_get_backend_vtable ();
+
+  if (dest_width <= src_width && dest_height <= src_height)
+    {
+      gd_image_scaler_scale_box (backend,
+                                 src, src_width, src_height, src_stride,
+                                 dest, dest_width, dest_height, dest_stride);
+    }
+  else if (dest_width >= src_width && dest_height >= src_height)
+    {
+      gd_image_scaler_scale_bilinear (backend,
+                                      src, src_width, src_height, src_stride,
+                                      dest, dest_width, dest_height, dest_stride);
+    }
+  else
+    {
+      guint8 *tmp;
+      gint tmp_width;
+      gint tmp_height;
+      gint tmp_stride;
+
+      /* One axis shrinks and the other grows. Box filter the shrinking
+       * axis first so that it does not alias, then stretch the other
+       * one; each pass leaves the other axis untouched.
+       */
+      tmp_width = MIN (src_width, dest_width);
+      tmp_height = MIN (src_height, dest_height);
+      tmp_stride = tmp_width * 4;
+      tmp = g_malloc ((gsize) tmp_stride * tmp_height);
+
+      gd_image_scaler_scale_box (backend,
+                                 src, src_width, src_height, src_stride,
+                                 tmp, tmp_width, tmp_height, tmp_stride);
+      gd_image_scaler_scale_bilinear (backend,
+                                      tmp, tmp_width, tmp_height, tmp_stride,
+                                      dest, dest_width, dest_height, dest_stride);
+
+      g_free (tmp);
+    }
+}
+
+/**
+ * gd_image_scaler_scale_surface:
+ * @surface: an image surface
+ * @width:
+ * @height:
+ * @filter:
+ *
+ * Surfaces that are not in %CAIRO_FORMAT_ARGB32 or %CAIRO_FORMAT_RGB24
+ * are always scaled with cairo.
+ *
+ * Returns: (transfer full): A copy of @surface scaled to @width x
+ * @height, with the same format and device scale.
+ */
+cairo_surface_t *
+gd_image_scaler_scale_surface (cairo_surface_t     *surface,
+                               gint                 width,
+                               gint                 height,
+                               GdImageScalerFilter  filter)
+{
+  cairo_format_t format;
+  cairo_surface_t *scaled;
+  gdouble scale_x;
+  gdouble scale_y;
+
+  g_return_val_if_fail (surface != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  format = cairo_image_surface_get_format (surface);
+  scaled = cairo_surface_create_similar_image (surface, format, width, height);
+  cairo_surface_get_device_scale (surface, &scale_x, &scale_y);
+  cairo_surface_set_device_scale (scaled, scale_x, scale_y);
+
+  if (filter == GD_IMAGE_SCALER_FILTER_CAIRO
+      || (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24))
+    {
+      gd_image_scaler_paint_cairo (scaled, surface);
+      goto out;
+    }
+
+  cairo_surface_flush (surface);
+  cairo_surface_flush (scaled);
+
+  gd_image_scaler_scale (cairo_image_surface_get_data (surface),
+                         cairo_image_surface_get_width (surface),
+                         cairo_image_surface_get_height (surface),
+                         cairo_image_surface_get_stride (surface),
+                         cairo_image_surface_get_data (scaled),
+                         width,
+                         height,
+                         cairo_image_surface_get_stride (scaled),
+                         filter);
+
+  cairo_surface_mark_dirty (scaled);
+
+ out:
+  return scaled;
+}
+
+/**
+ * gd_image_scaler_premultiply:
+ * @src: pixels in the layout of a #GdkPixbuf with 8 bits per channel
+ * @src_stride:
+ * @has_alpha: whether @src has an alpha channel
+ * @dest: the destination pixels
+ * @dest_stride:
+ * @width:
+ * @height:
+ *
+ * Converts @src to premultiplied pixels in the layout of
+ * %CAIRO_FORMAT_ARGB32, like gdk_cairo_surface_create_from_pixbuf()
+ * does.
+ */
+void
+gd_image_scaler_premultiply (const guint8 *src,
+                             gint          src_stride,
+                             gboolean      has_alpha,
+                             guint8       *dest,
+                             gint          dest_stride,
+                             gint          width,
+                             gint          height)
+{
+  const GdImageScalerBackend *backend;
+  gint x;
+  gint y;
+
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (dest != NULL);
+
+  backend = gd_image_scaler_get_backend_vtable ();
+
+  for (y = 0; y < height; y++)
+    {
+      const guint8 *src_row = src + (gsize) y * src_stride;
+      guint32 *dest_row = (guint32 *) (dest + (gsize) y * dest_stride);
+
+      if (has_alpha)
+        {
+          backend->premultiply (dest_row, src_row, width);
+          continue;
+        }
+
+      for (x = 0; x < width; x++)
+        {
+          const guint8 *p = src_row + x * 3;
+          dest_row[x] = 0xff000000 | (guint32) p[0] << 16 | (guint32) p[1] << 8 | p[2];
+        }
+    }
+}
+
+/**
+ * gd_image_scaler_unpremultiply:
+ * @src: premultiplied pixels in the layout of %CAIRO_FORMAT_ARGB32
+ * @src_stride:
+ * @dest: pixels in the layout of a #GdkPixbuf with an alpha channel
+ * @dest_stride:
+ * @width:
+ * @height:
+ *
+ * The reverse of gd_image_scaler_premultiply(), like
+ * gdk_pixbuf_get_from_surface() does.
+ */
+void
+gd_image_scaler_unpremultiply (const guint8 *src,
+                               gint          src_stride,
+                               guint8       *dest,
+                               gint          dest_stride,
+                               gint          width,
+                               gint          height)
+{
+  const GdImageScalerBackend *backend;
+  gint y;
+
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (dest != NULL);
+
+  backend = gd_image_scaler_get_backend_vtable ();
+
+  for (y = 0; y < height; y++)
+    backend->unpremultiply (dest + (gsize) y * dest_stride,
+                            (const guint32 *) (src + (gsize) y * src_stride),
+                            width);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GD_IMAGE_SCALER_H__
+#define __GD_IMAGE_SCALER_H__
+
+#include <cairo.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GD_IMAGE_SCALER_FILTER_CAIRO,
+  GD_IMAGE_SCALER_FILTER_FAST,
+  GD_IMAGE_SCALER_FILTER_GOOD
+} GdImageScalerFilter;
+
+const gchar          * gd_image_scaler_get_backend          (void);
+GdImageScalerFilter    gd_image_scaler_get_default_filter   (void);
+void                   gd_image_scaler_set_default_filter   (GdImageScalerFilter filter);
+
+void                   gd_image_scaler_scale                (const guint8        *src,
+                                                             gint                 src_width,
+                                                             gint                 src_height,
+                                                             gint                 src_stride,
+                                                             guint8              *dest,
+                                                             gint                 dest_width,
+                                                             gint                 dest_height,
+                                                             gint                 dest_stride,
+                                                             GdImageScalerFilter  filter);
+cairo_surface_t      * gd_image_scaler_scale_surface        (cairo_surface_t     *surface,
+                                                             gint                 width,
+                                                             gint                 height,
+                                                             GdImageScalerFilter  filter);
+
+void                   gd_image_scaler_premultiply          (const guint8        *src,
+                                                             gint                 src_stride,
+                                                             gboolean             has_alpha,
+                                                             guint8              *dest,
+                                                             gint                 dest_stride,
+                                                             gint                 width,
+                                                             gint                 height);
+void                   gd_image_scaler_unpremultiply        (const guint8        *src,
+                                                             gint                 src_stride,
+                                                             guint8              *dest,
+                                                             gint                 dest_stride,
+                                                             gint                 width,
+                                                             gint                 height);
+
+G_END_DECLS
+
+#endif /* __GD_IMAGE_SCALER_H__ */
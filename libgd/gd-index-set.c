@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gd-index-set.h"
+
+/* A set of unsigned integers, stored as a sorted array of disjoint,
+ * non-adjacent runs. Selections tend to be made of a few contiguous
+ * ranges, so this stays small even when a lot of items are selected.
+ */
+
+typedef struct _GdIndexSetRun GdIndexSetRun;
+
+struct _GdIndexSetRun
+{
+  guint start;
+  guint end;
+};
+
+struct _GdIndexSet
+{
+  GArray *runs;
+  guint n_items;
+};
+
+G_DEFINE_BOXED_TYPE (GdIndexSet, gd_index_set, gd_index_set_copy, gd_index_set_free)
+
+#define RUN(set, i) (&g_array_index ((set)->runs, GdIndexSetRun, (i)))
+
+/* Returns the position of the first run that ends after @value, which
+ * is the run containing @value if there is one.
+ */
+static guint
+gd_index_set_find_run (GdIndexSet *set, guint value)
+{
+  guint high = set->runs->len;
+  guint low = 0;
+
+  while (low < high)
+    {
+      guint mid = low + (high - low) / 2;
+
+      if (RUN (set, mid)->end > value)
+        high = mid;
+      else
+        low = mid + 1;
+    }
+
+  return low;
+}
+
+/**
+ * gd_index_set_new:
+ *
+ * Returns: (transfer full): A new empty #GdIndexSet.
+ */
+GdIndexSet *
+gd_index_set_new (void)
+{
+  GdIndexSet *set;
+
+  set = g_slice_new0 (GdIndexSet);
+  set->runs = g_array_new (FALSE, FALSE, sizeof (GdIndexSetRun));
+  return set;
+}
+
+/**
+ * gd_index_set_copy:
+ * @set:
+ *
+ * Returns: (transfer full): A copy of @set.
+ */
+GdIndexSet *
+gd_index_set_copy (GdIndexSet *set)
+{
+  GdIndexSet *copy;
+
+  g_return_val_if_fail (set != NULL, NULL);
+
+  copy = gd_index_set_new ();
+  g_array_append_vals (copy->runs, set->runs->data, set->runs->len);
+  copy->n_items = set->n_items;
+  return copy;
+}
+
+void
+gd_index_set_free (GdIndexSet *set)
+{
+  if (set == NULL)
+    return;
+
+  g_array_unref (set->runs);
+  g_slice_free (GdIndexSet, set);
+}
+
+void
+gd_index_set_add (GdIndexSet *set, guint index)
+{
+  gd_index_set_add_range (set, index, 1);
+}
+
+void
+gd_index_set_add_range (GdIndexSet *set, guint start, guint n_items)
+{
+  GdIndexSetRun merged;
+  guint end;
+  guint i;
+  guint j;
+
+  g_return_if_fail (set != NULL);
+  g_return_if_fail (n_items <= G_MAXUINT - start);
+
+  if (n_items == 0)
+    return;
+
+  end = start + n_items;
+  merged.start = start;
+  merged.end = end;
+
+  /* Swallow every run that overlaps or touches the new one. */
+  i = start > 0 ? gd_index_set_find_run (set, start - 1) : 0;
+  for (j = i; j < set->runs->len && RUN (set, j)->start <= end; j++)
+    {
+      GdIndexSetRun *run = RUN (set, j);
+
+      merged.start = MIN (merged.start, run->start);
+      merged.end = MAX (merged.end, run->end);
+      set->n_items -= run->end - run->start;
+    }
+
+  g_array_remove_range (set->runs, i, j - i);
+  g_array_insert_val (set->runs, i, merged);
+  set->n_items += merged.end - merged.start;
+}
+
+void
+gd_index_set_clear (GdIndexSet *set)
+{
+  g_return_if_fail (set != NULL);
+
+  g_array_set_size (set->runs, 0);
+  set->n_items = 0;
+}
+
+gboolean
+gd_index_set_contains (GdIndexSet *set, guint index)
+{
+  guint i;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+
+  i = gd_index_set_find_run (set, index);
+  return i < set->runs->len && RUN (set, i)->start <= index;
+}
+
+/**
+ * gd_index_set_get_next:
+ * @set:
+ * @index:
+ * @out_next: (out) (allow-none):
+ *
+ * Returns: %TRUE if @set contains an index greater than @index, in
+ * which case the smallest one is returned in @out_next.
+ */
+gboolean
+gd_index_set_get_next (GdIndexSet *set, guint index, guint *out_next)
+{
+  guint i;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+
+  if (index == G_MAXUINT)
+    return FALSE;
+
+  i = gd_index_set_find_run (set, index + 1);
+  if (i >= set->runs->len)
+    return FALSE;
+
+  if (out_next != NULL)
+    *out_next = MAX (RUN (set, i)->start, index + 1);
+
+  return TRUE;
+}
+
+/**
+ * gd_index_set_get_previous:
+ * @set:
+ * @index:
+ * @out_previous: (out) (allow-none):
+ *
+ * Returns: %TRUE if @set contains an index smaller than @index, in
+ * which case the largest one is returned in @out_previous.
+ */
+gboolean
+gd_index_set_get_previous (GdIndexSet *set, guint index, guint *out_previous)
+{
+  guint previous;
+  guint i;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+
+  if (index == 0)
+    return FALSE;
+
+  i = gd_index_set_find_run (set, index - 1);
+  if (i < set->runs->len && RUN (set, i)->start <= index - 1)
+    previous = index - 1;
+  else if (i > 0)
+    previous = RUN (set, i - 1)->end - 1;
+  else
+    return FALSE;
+
+  if (out_previous != NULL)
+    *out_previous = previous;
+
+  return TRUE;
+}
+
+/**
+ * gd_index_set_get_size:
+ * @set:
+ *
+ * Returns: The number of indices in @set. This takes constant time.
+ */
+guint
+gd_index_set_get_size (GdIndexSet *set)
+{
+  g_return_val_if_fail (set != NULL, 0);
+  return set->n_items;
+}
+
+/**
+ * gd_index_set_invert:
+ * @set:
+ * @n_items: the size of the list that @set refers to
+ *
+ * Replaces @set with the indices below @n_items that it doesn't
+ * contain. This takes time proportional to the number of runs, not
+ * to @n_items.
+ */
+void
+gd_index_set_invert (GdIndexSet *set, guint n_items)
+{
+  GArray *runs;
+  guint i;
+  guint previous_end = 0;
+
+  g_return_if_fail (set != NULL);
+
+  runs = g_array_sized_new (FALSE, FALSE, sizeof (GdIndexSetRun), set->runs->len + 1);
+  set->n_items = 0;
+
+  for (i = 0; i < set->runs->len && RUN (set, i)->start < n_items; i++)
+    {
+      if (RUN (set, i)->start > previous_end)
+        {
+          GdIndexSetRun gap = { previous_end, RUN (set, i)->start };
+
+          g_array_append_val (runs, gap);
+          set->n_items += gap.end - gap.start;
+        }
+
+      previous_end = RUN (set, i)->end;
+    }
+
+  if (previous_end < n_items)
+    {
+      GdIndexSetRun gap = { previous_end, n_items };
+
+      g_array_append_val (runs, gap);
+      set->n_items += gap.end - gap.start;
+    }
+
+  g_array_unref (set->runs);
+  set->runs = runs;
+}
+
+gboolean
+gd_index_set_is_empty (GdIndexSet *set)
+{
+  g_return_val_if_fail (set != NULL, TRUE);
+  return set->n_items == 0;
+}
+
+/**
+ * gd_index_set_permute:
+ * @set:
+ * @new_order: (array length=n_items): the old index of each new index,
+ *   as in #GtkTreeModel::rows-reordered
+ * @n_items: the size of the list that @set refers to
+ *
+ * Updates @set for a list whose items have been reordered.
+ */
+void
+gd_index_set_permute (GdIndexSet *set, const gint *new_order, guint n_items)
+{
+  GdIndexSet *old;
+  guint i;
+
+  g_return_if_fail (set != NULL);
+  g_return_if_fail (new_order != NULL || n_items == 0);
+
+  old = gd_index_set_copy (set);
+  gd_index_set_clear (set);
+
+  /* The new indices come in ascending order, so every one of them
+   * either extends the last run or starts a new one.
+   */
+  for (i = 0; i < n_items; i++)
+    {
+      GdIndexSetRun *last;
+
+      if (new_order[i] < 0 || !gd_index_set_contains (old, (guint) new_order[i]))
+        continue;
+
+      last = set->runs->len > 0 ? RUN (set, set->runs->len - 1) : NULL;
+      if (last != NULL && last->end == i)
+        {
+          last->end++;
+        }
+      else
+        {
+          GdIndexSetRun run = { i, i + 1 };
+          g_array_append_val (set->runs, run);
+        }
+
+      set->n_items++;
+    }
+
+  gd_index_set_free (old);
+}
+
+void
+gd_index_set_remove (GdIndexSet *set, guint index)
+{
+  gd_index_set_remove_range (set, index, 1);
+}
+
+void
+gd_index_set_remove_range (GdIndexSet *set, guint start, guint n_items)
+{
+  GdIndexSetRun pieces[2];
+  guint end;
+  guint i;
+  guint j;
+  guint n_pieces = 0;
+
+  g_return_if_fail (set != NULL);
+
+  if (n_items == 0)
+    return;
+
+  end = n_items > G_MAXUINT - start ? G_MAXUINT : start + n_items;
+
+  i = gd_index_set_find_run (set, start);
+  for (j = i; j < set->runs->len && RUN (set, j)->start < end; j++)
+    set->n_items -= RUN (set, j)->end - RUN (set, j)->start;
+
+  if (i == j)
+    return;
+
+  /* Keep whatever sticks out on either side. */
+  if (RUN (set, i)->start < start)
+    {
+      pieces[n_pieces].start = RUN (set, i)->start;
+      pieces[n_pieces].end = start;
+      n_pieces++;
+    }
+
+  if (RUN (set, j - 1)->end > end)
+    {
+      pieces[n_pieces].start = end;
+      pieces[n_pieces].end = RUN (set, j - 1)->end;
+      n_pieces++;
+    }
+
+  g_array_remove_range (set->runs, i, j - i);
+  g_array_insert_vals (set->runs, i, pieces, n_pieces);
+
+  for (j = 0; j < n_pieces; j++)
+    set->n_items += pieces[j].end - pieces[j].start;
+}
+
+/**
+ * gd_index_set_splice:
+ * @set:
+ * @position:
+ * @removed:
+ * @added:
+ *
+ * Updates @set for a change of a list, as described by
+ * #GListModel::items-changed. Indices of removed items are dropped,
+ * and those after them are moved. Added items are not part of the set.
+ */
+void
+gd_index_set_splice (GdIndexSet *set, guint position, guint removed, guint added)
+{
+  gint delta;
+  guint i;
+  guint j;
+
+  g_return_if_fail (set != NULL);
+
+  gd_index_set_remove_range (set, position, removed);
+
+  delta = (gint) added - (gint) removed;
+  if (delta == 0)
+    return;
+
+  i = gd_index_set_find_run (set, position);
+  if (i >= set->runs->len)
+    return;
+
+  /* A run can only straddle @position if nothing was removed. */
+  if (RUN (set, i)->start < position)
+    {
+      GdIndexSetRun tail;
+
+      tail.start = position;
+      tail.end = RUN (set, i)->end;
+      RUN (set, i)->end = position;
+      g_array_insert_val (set->runs, i + 1, tail);
+      i++;
+    }
+
+  for (j = i; j < set->runs->len; j++)
+    {
+      RUN (set, j)->start = (guint) ((gint) RUN (set, j)->start + delta);
+      RUN (set, j)->end = (guint) ((gint) RUN (set, j)->end + delta);
+    }
+
+  /* Runs on both sides of removed items might now touch. */
+  if (i > 0 && RUN (set, i - 1)->end >= RUN (set, i)->start)
+    {
+      RUN (set, i - 1)->end = RUN (set, i)->end;
+      g_array_remove_index (set->runs, i);
+    }
+}
+
+/**
+ * gd_index_set_to_array:
+ * @set:
+ * @out_n_indices: (out):
+ *
+ * Returns: (array length=out_n_indices) (transfer full): The indices
+ * in @set, sorted in ascending order.
+ */
+guint *
+gd_index_set_to_array (GdIndexSet *set, guint *out_n_indices)
+{
+  guint *indices;
+  guint i;
+  guint n = 0;
+
+  g_return_val_if_fail (set != NULL, NULL);
+
+  indices = g_new (guint, set->n_items);
+  for (i = 0; i < set->runs->len; i++)
+    {
+      guint index;
+
+      for (index = RUN (set, i)->start; index < RUN (set, i)->end; index++)
+        indices[n++] = index;
+    }
+
+  if (out_n_indices != NULL)
+    *out_n_indices = n;
+
+  return indices;
+}
+
+/**
+ * gd_index_set_iter_init:
+ * @iter: an uninitialized #GdIndexSetIter
+ * @set:
+ *
+ * Prepares @iter to walk @set in ascending order without allocating
+ * any memory. @set must not be modified while @iter is in use.
+ */
+void
+gd_index_set_iter_init (GdIndexSetIter *iter, GdIndexSet *set)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (set != NULL);
+
+  iter->set = set;
+  iter->run = 0;
+  iter->index = 0;
+}
+
+/**
+ * gd_index_set_iter_next:
+ * @iter:
+ * @out_index: (out) (allow-none):
+ *
+ * Returns: %FALSE if the end of the set has been reached.
+ */
+gboolean
+gd_index_set_iter_next (GdIndexSetIter *iter, guint *out_index)
+{
+  GdIndexSetRun *run;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (iter->run >= iter->set->runs->len)
+    return FALSE;
+
+  run = RUN (iter->set, iter->run);
+  if (iter->index < run->start)
+    iter->index = run->start;
+
+  if (out_index != NULL)
+    *out_index = iter->index;
+
+  iter->index++;
+  if (iter->index >= run->end)
+    iter->run++;
+
+  return TRUE;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GD_INDEX_SET_H__
+#define __GD_INDEX_SET_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GD_TYPE_INDEX_SET (gd_index_set_get_type ())
+
+typedef struct _GdIndexSet GdIndexSet;
+typedef struct _GdIndexSetIter GdIndexSetIter;
+
+struct _GdIndexSetIter
+{
+  /*< private >*/
+  GdIndexSet *set;
+  guint run;
+  guint index;
+};
+
+GType             gd_index_set_get_type         (void) G_GNUC_CONST;
+
+GdIndexSet      * gd_index_set_new              (void);
+GdIndexSet      * gd_index_set_copy             (GdIndexSet *set);
+void              gd_index_set_free             (GdIndexSet *set);
+
+void              gd_index_set_add              (GdIndexSet *set, guint index);
+void              gd_index_set_add_range        (GdIndexSet *set, guint start, guint n_items);
+void              gd_index_set_clear            (GdIndexSet *set);
+gboolean          gd_index_set_contains         (GdIndexSet *set, guint index);
+gboolean          gd_index_set_get_next         (GdIndexSet *set, guint index, guint *out_next);
+gboolean          gd_index_set_get_previous     (GdIndexSet *set, guint index, guint *out_previous);
+guint             gd_index_set_get_size         (GdIndexSet *set);
+void              gd_index_set_invert           (GdIndexSet *set, guint n_items);
+gboolean          gd_index_set_is_empty         (GdIndexSet *set);
+void              gd_index_set_permute          (GdIndexSet *set, const gint *new_order, guint n_items);
+void              gd_index_set_remove           (GdIndexSet *set, guint index);
+void              gd_index_set_remove_range     (GdIndexSet *set, guint start, guint n_items);
+void              gd_index_set_splice           (GdIndexSet *set, guint position, guint removed, guint added);
+guint           * gd_index_set_to_array         (GdIndexSet *set, guint *out_n_indices);
+
+void              gd_index_set_iter_init        (GdIndexSetIter *iter, GdIndexSet *set);
+gboolean          gd_index_set_iter_next        (GdIndexSetIter *iter, guint *out_index);
+
+G_END_DECLS
+
+#endif /* __GD_INDEX_SET_H__ */
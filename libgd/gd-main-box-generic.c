@@ -22,6 +22,8 @@
 #include "gd-main-box-generic.h"
 #include "gd-main-box-item.h"
 
+#include <string.h>
+
 enum
 {
   ITEM_ACTIVATED,
@@ -34,11 +36,19 @@ static guint signals[NUM_SIGNALS] = { 0, };
 
 G_DEFINE_INTERFACE (GdMainBoxGeneric, gd_main_box_generic, GTK_TYPE_WIDGET)
 
+static gboolean
+gd_main_box_generic_set_range_selected (GdMainBoxGeneric *self, guint position, guint n_items, gboolean selected)
+{
+  GdMainBoxGenericInterface *iface;
+
+  iface = GD_MAIN_BOX_GENERIC_GET_IFACE (self);
+
+  return (* iface->set_range_selected) (self, position, n_items, selected);
+}
+
 static void
 gd_main_box_generic_mark_range_as_selected (GdMainBoxGeneric *self, gint first_element, gint last_element)
 {
-  gint i;
-
   if (first_element > last_element)
     {
       gint tmp;
@@ -48,85 +58,275 @@ gd_main_box_generic_mark_range_as_selected (GdMainBoxGeneric *self, gint first_e
       last_element = tmp;
     }
 
-  for (i = first_element; i <= last_element; i++)
-    {
-      GdMainBoxChild *child;
+  /* The callers emit GdMainBoxGeneric::selection-changed. */
+  gd_main_box_generic_set_range_selected (self,
+                                          (guint) first_element,
+                                          (guint) (last_element - first_element + 1),
+                                          TRUE);
+}
 
-      child = gd_main_box_generic_get_child_at_index (self, i);
-      gd_main_box_generic_select_child (self, child);
+/* Maps the IDs of the items in the model to their positions, so that
+ * extending a selection doesn't have to search the model. The entry of
+ * every item is kept in model order, so that the positions can be
+ * shifted when items are added or removed in the middle. The ID of an
+ * item that is already gone can't be read from the model any more.
+ *
+ * Like a linear search, the first of any duplicates wins.
+ *
+ * Keeping the positions exact costs O(n) for every change: the items
+ * after the change are walked to shift their entries, though without
+ * any hashing, and removing the first of several duplicates searches
+ * for the next one. Lookups are O(1).
+ */
+typedef struct
+{
+  gchar *id;
+  guint n_items;
+  guint position;
+} IdIndexEntry;
+
+typedef struct
+{
+  GHashTable *entries;
+  GListModel *model;
+  GPtrArray *items;
+} IdIndex;
+
+static void
+id_index_entry_free (IdIndexEntry *entry)
+{
+  g_free (entry->id);
+  g_slice_free (IdIndexEntry, entry);
+}
+
+static guint
+id_index_find_first (IdIndex *index, IdIndexEntry *entry)
+{
+  guint i;
+
+  for (i = 0; i < index->items->len; i++)
+    {
+      if (g_ptr_array_index (index->items, i) == entry)
+        break;
     }
+
+  return i;
 }
 
 static void
-gd_main_box_generic_select_range (GdMainBoxGeneric *self, GdMainBoxChild *child)
+id_index_items_changed (GListModel *model, guint position, guint removed, guint added, IdIndex *index)
 {
-  GListModel *model;
-  const gchar *last_selected_id;
-  gint index;
-  gint other_index = -1;
+  GPtrArray *orphans;
+  gint delta;
+  guint i;
+  guint j;
   guint n_items;
 
-  model = gd_main_box_generic_get_model (self);
-  n_items = g_list_model_get_n_items (model);
-
-  last_selected_id = gd_main_box_generic_get_last_selected_id (self);
-  index = gd_main_box_child_get_index (child);
+  orphans = g_ptr_array_new_with_free_func (g_free);
 
-  if (last_selected_id != NULL)
+  for (i = position; i < position + removed; i++)
     {
-      guint i;
+      IdIndexEntry *entry;
 
-      for (i = 0; i < n_items; i++)
+      entry = g_ptr_array_index (index->items, i);
+      if (entry == NULL)
+        continue;
+
+      entry->n_items--;
+      if (entry->n_items == 0)
+        {
+          g_hash_table_remove (index->entries, entry->id);
+        }
+      else if (entry->position == i)
         {
-          GdMainBoxItem *item;
-          const gchar *id;
+          /* A duplicate that comes later takes over. */
+          entry->position = G_MAXUINT;
+          g_ptr_array_add (orphans, g_strdup (entry->id));
+        }
+    }
 
-          item = GD_MAIN_BOX_ITEM (g_list_model_get_object (model, i));
-          id = gd_main_box_item_get_id (item);
+  g_ptr_array_remove_range (index->items, position, removed);
 
-	  if (g_strcmp0 (id, last_selected_id) == 0)
-            {
-              other_index = (gint) i;
-              g_object_unref (item);
-              break;
-            }
+  n_items = index->items->len;
+  g_ptr_array_set_size (index->items, n_items + added);
+  memmove (index->items->pdata + position + added,
+           index->items->pdata + position,
+           (n_items - position) * sizeof (gpointer));
 
-          g_object_unref (item);
-	}
+  /* Shift the items that follow. This goes against the direction of
+   * the shift, so that an entry that was already moved can't be taken
+   * for a later duplicate at its old position.
+   */
+  delta = (gint) added - (gint) removed;
+  for (j = 0; delta != 0 && j < index->items->len - position - added; j++)
+    {
+      IdIndexEntry *entry;
+
+      i = delta > 0 ? index->items->len - 1 - j : position + added + j;
+
+      entry = g_ptr_array_index (index->items, i);
+      if (entry == NULL)
+        continue;
+
+      if (entry->position == (guint) ((gint) i - delta))
+        entry->position = i;
     }
 
-  if (other_index == -1)
+  for (i = position; i < position + added; i++)
     {
-      gint i;
+      IdIndexEntry *entry;
+      GdMainBoxItem *item;
+      const gchar *id;
 
-      for (i = index - 1; i >= 0; i--)
+      item = GD_MAIN_BOX_ITEM (g_list_model_get_object (model, i));
+      id = gd_main_box_item_get_id (item);
+
+      if (id == NULL)
+        {
+          g_ptr_array_index (index->items, i) = NULL;
+          g_object_unref (item);
+          continue;
+        }
+
+      entry = g_hash_table_lookup (index->entries, id);
+      if (entry == NULL)
+        {
+          entry = g_slice_new0 (IdIndexEntry);
+          entry->id = g_strdup (id);
+          entry->position = i;
+          g_hash_table_insert (index->entries, entry->id, entry);
+        }
+      else if (entry->position != G_MAXUINT && i < entry->position)
         {
-          GdMainBoxChild *other;
-
-          other = gd_main_box_generic_get_child_at_index (self, i);
-          if (gd_main_box_child_get_selected (other))
-            {
-              other_index = i;
-              break;
-	    }
-	}
+          entry->position = i;
+        }
+
+      entry->n_items++;
+      g_ptr_array_index (index->items, i) = entry;
+      g_object_unref (item);
     }
 
-  if (other_index == -1)
+  for (i = 0; i < orphans->len; i++)
     {
-      gint i;
+      IdIndexEntry *entry;
+      const gchar *id;
+
+      id = g_ptr_array_index (orphans, i);
+      /* The last of the duplicates might have been removed too. */
+      entry = g_hash_table_lookup (index->entries, id);
+      if (entry != NULL && entry->position == G_MAXUINT)
+        entry->position = id_index_find_first (index, entry);
+    }
 
-      for (i = index + 1; i < (gint) n_items; i++)
-        {
-          GdMainBoxChild *other;
-
-          other = gd_main_box_generic_get_child_at_index (self, i);
-          if (gd_main_box_child_get_selected (other))
-            {
-              other_index = i;
-              break;
-            }
-        }
+  g_ptr_array_unref (orphans);
+}
+
+static void
+id_index_set_model (IdIndex *index, GListModel *model)
+{
+  if (index->model != NULL)
+    g_signal_handlers_disconnect_by_func (index->model, id_index_items_changed, index);
+
+  g_set_object (&index->model, model);
+  g_hash_table_remove_all (index->entries);
+  g_ptr_array_set_size (index->items, 0);
+
+  if (index->model != NULL)
+    {
+      g_signal_connect (index->model, "items-changed", G_CALLBACK (id_index_items_changed), index);
+      id_index_items_changed (index->model, 0, 0, g_list_model_get_n_items (index->model), index);
+    }
+}
+
+static void
+id_index_destroy (IdIndex *index)
+{
+  id_index_set_model (index, NULL);
+  g_hash_table_unref (index->entries);
+  g_ptr_array_unref (index->items);
+  g_slice_free (IdIndex, index);
+}
+
+static IdIndex *
+get_id_index (GdMainBoxGeneric *self)
+{
+  IdIndex *index;
+
+  index = g_object_get_data (G_OBJECT (self), "gd-main-box-generic-id-index");
+  if (index == NULL)
+    {
+      index = g_slice_new0 (IdIndex);
+      index->entries = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              NULL,
+                                              (GDestroyNotify) id_index_entry_free);
+      index->items = g_ptr_array_new ();
+      g_object_set_data_full (G_OBJECT (self), "gd-main-box-generic-id-index",
+                              index, (GDestroyNotify) id_index_destroy);
+    }
+
+  return index;
+}
+
+static gint
+gd_main_box_generic_get_position_for_id (GdMainBoxGeneric *self, const gchar *id)
+{
+  GListModel *model;
+  IdIndexEntry *entry;
+  IdIndex *index;
+  gint ret_val = -1;
+
+  model = gd_main_box_generic_get_model (self);
+  if (model == NULL)
+    goto out;
+
+  /* Implementations reset the index when their model is replaced; see
+   * _gd_main_box_generic_set_id_index_model().
+   */
+  index = get_id_index (self);
+  if (index->model != model)
+    id_index_set_model (index, model);
+
+  entry = g_hash_table_lookup (index->entries, id);
+  if (entry == NULL)
+    goto out;
+
+  ret_val = (gint) entry->position;
+
+ out:
+  return ret_val;
+}
+
+static void
+gd_main_box_generic_select_range_for_child (GdMainBoxGeneric *self, GdMainBoxChild *child)
+{
+  GdIndexSet *selection;
+  const gchar *last_selected_id;
+  gint index;
+  gint other_index = -1;
+  guint other;
+
+  /* Getting the selection brings the children in sync with the model
+   * first, so that the index of @child can be compared with the
+   * positions that the ID index has.
+   */
+  selection = gd_main_box_generic_get_selection (self);
+
+  last_selected_id = gd_main_box_generic_get_last_selected_id (self);
+  index = gd_main_box_child_get_index (child);
+  if (index < 0)
+    return;
+
+  if (last_selected_id != NULL)
+    other_index = gd_main_box_generic_get_position_for_id (self, last_selected_id);
+
+  /* Otherwise, extend the range from the closest selected item. */
+  if (other_index == -1)
+    {
+      if (gd_index_set_get_previous (selection, (guint) index, &other))
+        other_index = (gint) other;
+      else if (gd_index_set_get_next (selection, (guint) index, &other))
+        other_index = (gint) other;
     }
 
   if (other_index == -1)
@@ -203,6 +403,33 @@ gd_main_box_generic_default_init (GdMainBoxGenericInterface *iface)
                                 G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
   g_object_interface_install_property (iface, pspec);
 
+  /**
+   * GdMainBoxGeneric:coalesce-updates:
+   *
+   * Whether changes to the #GdMainBoxGeneric:model are collected and
+   * applied once per frame, instead of as soon as they happen.
+   */
+  pspec = g_param_spec_boolean ("coalesce-updates",
+                                "Coalesce Updates",
+                                "Whether model changes are applied once per frame",
+                                TRUE,
+                                G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_interface_install_property (iface, pspec);
+
+  /**
+   * GdMainBoxGeneric:preserve-selection:
+   *
+   * Whether the selection is remembered by #GdMainBoxItem:id, and
+   * carried over to items with the same ID when the
+   * #GdMainBoxGeneric:model is replaced or changes.
+   */
+  pspec = g_param_spec_boolean ("preserve-selection",
+                                "Preserve Selection",
+                                "Whether the selection is kept across model changes by item ID",
+                                FALSE,
+                                G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_interface_install_property (iface, pspec);
+
   signals[ITEM_ACTIVATED] = g_signal_new ("item-activated",
                                           GD_TYPE_MAIN_BOX_GENERIC,
                                           G_SIGNAL_RUN_LAST,
@@ -290,6 +517,23 @@ gd_main_box_generic_get_model (GdMainBoxGeneric *self)
   return (* iface->get_model) (self);
 }
 
+/**
+ * gd_main_box_generic_get_n_selected:
+ * @self:
+ *
+ * Returns: The number of selected items. This takes constant time.
+ */
+guint
+gd_main_box_generic_get_n_selected (GdMainBoxGeneric *self)
+{
+  GdIndexSet *selection;
+
+  g_return_val_if_fail (GD_IS_MAIN_BOX_GENERIC (self), 0);
+
+  selection = gd_main_box_generic_get_selection (self);
+  return gd_index_set_get_size (selection);
+}
+
 /**
  * gd_main_box_generic_get_selected_children:
  * @self:
@@ -309,6 +553,48 @@ gd_main_box_generic_get_selected_children (GdMainBoxGeneric *self)
   return (* iface->get_selected_children) (self);
 }
 
+/**
+ * gd_main_box_generic_get_selected_indices:
+ * @self:
+ * @out_n_indices: (out):
+ *
+ * Returns: (array length=out_n_indices) (transfer full): The positions
+ * of the selected items in the model, in ascending order
+ */
+guint *
+gd_main_box_generic_get_selected_indices (GdMainBoxGeneric *self, guint *out_n_indices)
+{
+  GdIndexSet *selection;
+
+  g_return_val_if_fail (GD_IS_MAIN_BOX_GENERIC (self), NULL);
+
+  selection = gd_main_box_generic_get_selection (self);
+  return gd_index_set_to_array (selection, out_n_indices);
+}
+
+/**
+ * gd_main_box_generic_get_selection:
+ * @self:
+ *
+ * Unlike gd_main_box_generic_get_selected_children(), this covers
+ * items that don't have a child at the moment. Use
+ * gd_index_set_iter_init() to walk it without allocating.
+ *
+ * Returns: (transfer none): The positions of the selected items in
+ * the model
+ */
+GdIndexSet *
+gd_main_box_generic_get_selection (GdMainBoxGeneric *self)
+{
+  GdMainBoxGenericInterface *iface;
+
+  g_return_val_if_fail (GD_IS_MAIN_BOX_GENERIC (self), NULL);
+
+  iface = GD_MAIN_BOX_GENERIC_GET_IFACE (self);
+
+  return (* iface->get_selection) (self);
+}
+
 /**
  * gd_main_box_generic_get_selection_mode:
  * @self:
@@ -387,6 +673,24 @@ gd_main_box_generic_select_child (GdMainBoxGeneric *self, GdMainBoxChild *child)
   (* iface->select_child) (self, child);
 }
 
+/**
+ * gd_main_box_generic_select_range:
+ * @self:
+ * @position: the position of the first item in the model
+ * @n_items: the number of items to select
+ *
+ * Selects @n_items items starting at @position in one go, and emits
+ * #GdMainBoxGeneric::selection-changed at most once.
+ */
+void
+gd_main_box_generic_select_range (GdMainBoxGeneric *self, guint position, guint n_items)
+{
+  g_return_if_fail (GD_IS_MAIN_BOX_GENERIC (self));
+
+  if (gd_main_box_generic_set_range_selected (self, position, n_items, TRUE))
+    g_signal_emit (self, signals[SELECTION_CHANGED], 0);
+}
+
 /**
  * gd_main_box_generic_set_model:
  * @self:
@@ -466,6 +770,24 @@ gd_main_box_generic_unselect_child (GdMainBoxGeneric *self, GdMainBoxChild *chil
   (* iface->unselect_child) (self, child);
 }
 
+/**
+ * gd_main_box_generic_unselect_range:
+ * @self:
+ * @position: the position of the first item in the model
+ * @n_items: the number of items to unselect
+ *
+ * Unselects @n_items items starting at @position in one go, and emits
+ * #GdMainBoxGeneric::selection-changed at most once.
+ */
+void
+gd_main_box_generic_unselect_range (GdMainBoxGeneric *self, guint position, guint n_items)
+{
+  g_return_if_fail (GD_IS_MAIN_BOX_GENERIC (self));
+
+  if (gd_main_box_generic_set_range_selected (self, position, n_items, FALSE))
+    g_signal_emit (self, signals[SELECTION_CHANGED], 0);
+}
+
 void
 gd_main_box_generic_toggle_selection_for_child (GdMainBoxGeneric *self,
                                                 GdMainBoxChild *child,
@@ -484,8 +806,43 @@ gd_main_box_generic_toggle_selection_for_child (GdMainBoxGeneric *self,
   else
     {
       if (select_range)
-        gd_main_box_generic_select_range (self, child);
+        gd_main_box_generic_select_range_for_child (self, child);
       else
         gd_main_box_generic_select_child (self, child);
     }
 }
+
+/* Called by the implementations whenever their model is replaced, after
+ * they connected to GListModel::items-changed, so that the index still
+ * has the IDs of the removed items when their own handler runs.
+ */
+void
+_gd_main_box_generic_set_id_index_model (GdMainBoxGeneric *self, GListModel *model)
+{
+  IdIndex *index;
+
+  g_return_if_fail (GD_IS_MAIN_BOX_GENERIC (self));
+
+  index = get_id_index (self);
+  id_index_set_model (index, model);
+}
+
+/* Returns the ID of the item at @position as the index last saw it, or
+ * %NULL. Inside a GListModel::items-changed handler that runs before
+ * the index's own, this is still the ID of a removed item.
+ */
+const gchar *
+_gd_main_box_generic_get_id_at (GdMainBoxGeneric *self, guint position)
+{
+  IdIndexEntry *entry;
+  IdIndex *index;
+
+  g_return_val_if_fail (GD_IS_MAIN_BOX_GENERIC (self), NULL);
+
+  index = get_id_index (self);
+  if (position >= index->items->len)
+    return NULL;
+
+  entry = g_ptr_array_index (index->items, position);
+  return entry != NULL ? entry->id : NULL;
+}
@@ -25,6 +25,7 @@
 #include <gio/gio.h>
 #include <gtk/gtk.h>
 
+#include "gd-index-set.h"
 #include "gd-main-box-child.h"
 
 G_BEGIN_DECLS
@@ -41,8 +42,13 @@ struct _GdMainBoxGenericInterface
   const gchar     * (* get_last_selected_id)   (GdMainBoxGeneric *self);
   GListModel      * (* get_model)              (GdMainBoxGeneric *self);
   GList           * (* get_selected_children)  (GdMainBoxGeneric *self);
+  GdIndexSet      * (* get_selection)          (GdMainBoxGeneric *self);
   void              (* select_all)             (GdMainBoxGeneric *self);
   void              (* select_child)           (GdMainBoxGeneric *self, GdMainBoxChild *child);
+  gboolean          (* set_range_selected)     (GdMainBoxGeneric *self,
+                                                guint             position,
+                                                guint             n_items,
+                                                gboolean          selected);
   void              (* unselect_all)           (GdMainBoxGeneric *self);
   void              (* unselect_child)         (GdMainBoxGeneric *self, GdMainBoxChild *child);
 };
@@ -50,12 +56,16 @@ struct _GdMainBoxGenericInterface
 GdMainBoxChild  * gd_main_box_generic_get_child_at_index       (GdMainBoxGeneric *self, gint index);
 const gchar     * gd_main_box_generic_get_last_selected_id     (GdMainBoxGeneric *self);
 GListModel      * gd_main_box_generic_get_model                (GdMainBoxGeneric *self);
+guint             gd_main_box_generic_get_n_selected           (GdMainBoxGeneric *self);
 GList           * gd_main_box_generic_get_selected_children    (GdMainBoxGeneric *self);
+guint           * gd_main_box_generic_get_selected_indices     (GdMainBoxGeneric *self, guint *out_n_indices);
+GdIndexSet      * gd_main_box_generic_get_selection            (GdMainBoxGeneric *self);
 gboolean          gd_main_box_generic_get_selection_mode       (GdMainBoxGeneric *self);
 gboolean          gd_main_box_generic_get_show_primary_text    (GdMainBoxGeneric *self);
 gboolean          gd_main_box_generic_get_show_secondary_text  (GdMainBoxGeneric *self);
 void              gd_main_box_generic_select_all               (GdMainBoxGeneric *self);
 void              gd_main_box_generic_select_child             (GdMainBoxGeneric *self, GdMainBoxChild *child);
+void              gd_main_box_generic_select_range             (GdMainBoxGeneric *self, guint position, guint n_items);
 void              gd_main_box_generic_set_model                (GdMainBoxGeneric *self, GListModel *model);
 void              gd_main_box_generic_set_selection_mode       (GdMainBoxGeneric *self, gboolean selection_mode);
 void              gd_main_box_generic_set_show_primary_text    (GdMainBoxGeneric *self, gboolean show_primary_text);
@@ -63,11 +73,16 @@ void              gd_main_box_generic_set_show_secondary_text  (GdMainBoxGeneric
                                                                 gboolean show_secondary_text);
 void              gd_main_box_generic_unselect_all             (GdMainBoxGeneric *self);
 void              gd_main_box_generic_unselect_child           (GdMainBoxGeneric *self, GdMainBoxChild *child);
+void              gd_main_box_generic_unselect_range           (GdMainBoxGeneric *self, guint position, guint n_items);
 
 void              gd_main_box_generic_toggle_selection_for_child   (GdMainBoxGeneric  *self,
                                                                     GdMainBoxChild    *child,
                                                                     gboolean           select_range);
 
+/* private */
+const gchar     * _gd_main_box_generic_get_id_at               (GdMainBoxGeneric *self, guint position);
+void              _gd_main_box_generic_set_id_index_model      (GdMainBoxGeneric *self, GListModel *model);
+
 G_END_DECLS
 
 #endif /* __GD_MAIN_BOX_GENERIC_H__ */
@@ -34,6 +34,8 @@ struct _GdMainBoxPrivate
   GdMainBoxType current_type;
   GtkWidget *current_box;
   GtkWidget *frame;
+  gboolean coalesce_updates;
+  gboolean preserve_selection;
   gboolean selection_mode;
   gboolean show_primary_text;
   gboolean show_secondary_text;
@@ -46,6 +48,8 @@ enum
   PROP_SHOW_PRIMARY_TEXT,
   PROP_SHOW_SECONDARY_TEXT,
   PROP_MODEL,
+  PROP_COALESCE_UPDATES,
+  PROP_PRESERVE_SELECTION,
   NUM_PROPERTIES
 };
 
@@ -149,6 +153,12 @@ gd_main_box_rebuild (GdMainBox *self)
   g_object_bind_property (self, "show-secondary-text",
                           priv->current_box, "show-secondary-text",
                           G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self, "coalesce-updates",
+                          priv->current_box, "coalesce-updates",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self, "preserve-selection",
+                          priv->current_box, "preserve-selection",
+                          G_BINDING_SYNC_CREATE);
   gtk_container_add (GTK_CONTAINER (priv->frame), priv->current_box);
 
   g_signal_connect_swapped (priv->current_box,
@@ -222,6 +232,12 @@ gd_main_box_get_property (GObject *object, guint property_id, GValue *value, GPa
     case PROP_MODEL:
       g_value_set_object (value, gd_main_box_get_model (self));
       break;
+    case PROP_COALESCE_UPDATES:
+      g_value_set_boolean (value, gd_main_box_get_coalesce_updates (self));
+      break;
+    case PROP_PRESERVE_SELECTION:
+      g_value_set_boolean (value, gd_main_box_get_preserve_selection (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -250,6 +266,12 @@ gd_main_box_set_property (GObject *object, guint property_id, const GValue *valu
     case PROP_MODEL:
       gd_main_box_set_model (self, g_value_get_object (value));
       break;
+    case PROP_COALESCE_UPDATES:
+      gd_main_box_set_coalesce_updates (self, g_value_get_boolean (value));
+      break;
+    case PROP_PRESERVE_SELECTION:
+      gd_main_box_set_preserve_selection (self, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -314,6 +336,24 @@ gd_main_box_class_init (GdMainBoxClass *klass)
                                                                G_PARAM_CONSTRUCT |
                                                                G_PARAM_STATIC_STRINGS);
 
+  properties[PROP_COALESCE_UPDATES] = g_param_spec_boolean ("coalesce-updates",
+                                                            "Coalesce updates",
+                                                            "Whether model changes are applied once per frame",
+                                                            TRUE,
+                                                            G_PARAM_EXPLICIT_NOTIFY |
+                                                            G_PARAM_READWRITE |
+                                                            G_PARAM_CONSTRUCT |
+                                                            G_PARAM_STATIC_STRINGS);
+
+  properties[PROP_PRESERVE_SELECTION] = g_param_spec_boolean ("preserve-selection",
+                                                              "Preserve selection",
+                                                              "Whether the selection is kept across model changes by item ID",
+                                                              FALSE,
+                                                              G_PARAM_EXPLICIT_NOTIFY |
+                                                              G_PARAM_READWRITE |
+                                                              G_PARAM_CONSTRUCT |
+                                                              G_PARAM_STATIC_STRINGS);
+
   signals[ITEM_ACTIVATED] = g_signal_new ("item-activated",
                                           GD_TYPE_MAIN_BOX,
                                           G_SIGNAL_RUN_LAST,
@@ -378,6 +418,24 @@ gd_main_box_set_box_type (GdMainBox *self, GdMainBoxType type)
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_BOX_TYPE]);
 }
 
+gboolean
+gd_main_box_get_coalesce_updates (GdMainBox *self)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+  return priv->coalesce_updates;
+}
+
+gboolean
+gd_main_box_get_preserve_selection (GdMainBox *self)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+  return priv->preserve_selection;
+}
+
 gboolean
 gd_main_box_get_selection_mode (GdMainBox *self)
 {
@@ -405,6 +463,34 @@ gd_main_box_get_show_secondary_text (GdMainBox *self)
   return priv->show_secondary_text;
 }
 
+void
+gd_main_box_set_coalesce_updates (GdMainBox *self, gboolean coalesce_updates)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+
+  if (coalesce_updates == priv->coalesce_updates)
+    return;
+
+  priv->coalesce_updates = coalesce_updates;
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_COALESCE_UPDATES]);
+}
+
+void
+gd_main_box_set_preserve_selection (GdMainBox *self, gboolean preserve_selection)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+
+  if (preserve_selection == priv->preserve_selection)
+    return;
+
+  priv->preserve_selection = preserve_selection;
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PRESERVE_SELECTION]);
+}
+
 void
 gd_main_box_set_selection_mode (GdMainBox *self, gboolean selection_mode)
 {
@@ -508,27 +594,40 @@ GList *
 gd_main_box_get_selection (GdMainBox *self)
 {
   GdMainBoxPrivate *priv;
-  GList *l;
-  GList *selected_children;
+  GdIndexSet *selected_indices;
+  GdIndexSetIter iter;
   GList *selection = NULL;
+  GListModel *model;
+  guint position;
 
   priv = gd_main_box_get_instance_private (self);
 
-  selected_children = gd_main_box_generic_get_selected_children (GD_MAIN_BOX_GENERIC (priv->current_box));
-  for (l = selected_children; l != NULL; l = l->next)
-    {
-      GdMainBoxChild *child = GD_MAIN_BOX_CHILD (l->data);
-      GdMainBoxItem *item;
+  model = gd_main_box_generic_get_model (GD_MAIN_BOX_GENERIC (priv->current_box));
+  selected_indices = gd_main_box_generic_get_selection (GD_MAIN_BOX_GENERIC (priv->current_box));
 
-      item = gd_main_box_child_get_item (child);
-      selection = g_list_prepend (selection, g_object_ref (item));
-    }
+  gd_index_set_iter_init (&iter, selected_indices);
+  while (gd_index_set_iter_next (&iter, &position))
+    selection = g_list_prepend (selection, g_list_model_get_object (model, position));
 
   selection = g_list_reverse (selection);
-  g_list_free (selected_children);
   return selection;
 }
 
+/**
+ * gd_main_box_get_n_selected:
+ * @self:
+ *
+ * Returns: The number of selected items. This takes constant time.
+ */
+guint
+gd_main_box_get_n_selected (GdMainBox *self)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+  return gd_main_box_generic_get_n_selected (GD_MAIN_BOX_GENERIC (priv->current_box));
+}
+
 void
 gd_main_box_select_all (GdMainBox *self)
 {
@@ -538,6 +637,15 @@ gd_main_box_select_all (GdMainBox *self)
   gd_main_box_generic_select_all (GD_MAIN_BOX_GENERIC (priv->current_box));
 }
 
+void
+gd_main_box_select_range (GdMainBox *self, guint position, guint n_items)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+  gd_main_box_generic_select_range (GD_MAIN_BOX_GENERIC (priv->current_box), position, n_items);
+}
+
 void
 gd_main_box_unselect_all (GdMainBox *self)
 {
@@ -546,3 +654,12 @@ gd_main_box_unselect_all (GdMainBox *self)
   priv = gd_main_box_get_instance_private (self);
   gd_main_box_generic_unselect_all (GD_MAIN_BOX_GENERIC (priv->current_box));
 }
+
+void
+gd_main_box_unselect_range (GdMainBox *self, guint position, guint n_items)
+{
+  GdMainBoxPrivate *priv;
+
+  priv = gd_main_box_get_instance_private (self);
+  gd_main_box_generic_unselect_range (GD_MAIN_BOX_GENERIC (priv->current_box), position, n_items);
+}
@@ -43,18 +43,25 @@ struct _GdMainBoxClass
 
 GtkWidget      * gd_main_box_new                      (GdMainBoxType type);
 GdMainBoxType    gd_main_box_get_box_type             (GdMainBox *self);
+gboolean         gd_main_box_get_coalesce_updates     (GdMainBox *self);
 GListModel     * gd_main_box_get_model                (GdMainBox *self);
+guint            gd_main_box_get_n_selected           (GdMainBox *self);
+gboolean         gd_main_box_get_preserve_selection   (GdMainBox *self);
 GList          * gd_main_box_get_selection            (GdMainBox *self);
 gboolean         gd_main_box_get_selection_mode       (GdMainBox *self);
 gboolean         gd_main_box_get_show_primary_text    (GdMainBox *self);
 gboolean         gd_main_box_get_show_secondary_text  (GdMainBox *self);
 void             gd_main_box_select_all               (GdMainBox *self);
+void             gd_main_box_select_range             (GdMainBox *self, guint position, guint n_items);
 void             gd_main_box_set_box_type             (GdMainBox *self, GdMainBoxType type);
+void             gd_main_box_set_coalesce_updates     (GdMainBox *self, gboolean coalesce_updates);
 void             gd_main_box_set_model                (GdMainBox *self, GListModel *model);
+void             gd_main_box_set_preserve_selection   (GdMainBox *self, gboolean preserve_selection);
 void             gd_main_box_set_selection_mode       (GdMainBox *self, gboolean selection_mode);
 void             gd_main_box_set_show_primary_text    (GdMainBox *self, gboolean show_primary_text);
 void             gd_main_box_set_show_secondary_text  (GdMainBox *self, gboolean show_secondary_text);
 void             gd_main_box_unselect_all             (GdMainBox *self);
+void             gd_main_box_unselect_range           (GdMainBox *self, guint position, guint n_items);
 
 G_END_DECLS
 
@@ -20,21 +20,48 @@
  */
 
 #include "gd-main-box-child.h"
+#include "gd-main-icon-box.h"
 #include "gd-main-icon-box-child.h"
 #include "gd-main-icon-box-icon.h"
 
 #include <gio/gio.h>
 #include <glib.h>
 
+#define MAIN_ICON_BOX_CHILD_SPINNER_SIZE 32
+
 typedef struct _GdMainIconBoxChildPrivate GdMainIconBoxChildPrivate;
+typedef struct _GdMainIconBoxChildStyle GdMainIconBoxChildStyle;
 
 struct _GdMainIconBoxChildPrivate
 {
   GdMainBoxItem *item;
+  GdMainIconBox *pulsing_box;
+  GdMainIconBoxIconZoom *zoom;
+  GdkRectangle icon_area;
   GtkWidget *check_button;
+  GtkWidget *icon;
+  GtkWidget *overlay;
+  GtkWidget *primary_label;
+  GtkWidget *secondary_label;
+  GtkWidget *spinner;
+  PangoLayout *primary_layout;
+  PangoLayout *secondary_layout;
+  gboolean flat;
   gboolean selection_mode;
   gboolean show_primary_text;
   gboolean show_secondary_text;
+  gint text_y;
+  guint pulse_tick_id;
+};
+
+/* Shared by all the flat children of a GdMainIconBox. */
+struct _GdMainIconBoxChildStyle
+{
+  GtkStyleContext *check;
+  GtkStyleContext *spinner;
+  gdouble dim_label_opacity;
+  gint check_height;
+  gint check_width;
 };
 
 enum
@@ -43,6 +70,7 @@ enum
   PROP_SELECTION_MODE,
   PROP_SHOW_PRIMARY_TEXT,
   PROP_SHOW_SECONDARY_TEXT,
+  PROP_FLAT,
   NUM_PROPERTIES
 };
 
@@ -51,19 +79,466 @@ G_DEFINE_TYPE_WITH_CODE (GdMainIconBoxChild, gd_main_icon_box_child, GTK_TYPE_FL
                          G_ADD_PRIVATE (GdMainIconBoxChild)
                          G_IMPLEMENT_INTERFACE (GD_TYPE_MAIN_BOX_CHILD, gd_main_box_child_interface_init))
 
-static gboolean
-gd_main_icon_box_child_bind_text_to_visible (GBinding *binding,
-                                             const GValue *from_value,
-                                             GValue *to_value,
-                                             gpointer user_data)
+static void
+gd_main_icon_box_child_sync_label (GtkWidget *label, const gchar *text)
+{
+  gboolean visible;
+
+  if (label == NULL)
+    return;
+
+  visible = text != NULL && text[0] != '\0' ? TRUE : FALSE;
+  gtk_label_set_label (GTK_LABEL (label), text);
+  gtk_widget_set_visible (label, visible);
+}
+
+static void
+gd_main_icon_box_child_style_free (GdMainIconBoxChildStyle *style)
+{
+  g_object_unref (style->check);
+  g_object_unref (style->spinner);
+  g_slice_free (GdMainIconBoxChildStyle, style);
+}
+
+static GtkStyleContext *
+gd_main_icon_box_child_style_create_context (GtkWidget *widget, GtkWidgetPath *path)
+{
+  GtkStyleContext *context;
+
+  context = gtk_style_context_new ();
+  gtk_style_context_set_path (context, path);
+  gtk_style_context_set_screen (context, gtk_widget_get_screen (widget));
+  gtk_style_context_set_scale (context, gtk_widget_get_scale_factor (widget));
+  gtk_widget_path_unref (path);
+
+  return context;
+}
+
+static GtkWidgetPath *
+gd_main_icon_box_child_style_append_node (GtkWidgetPath *base, GType type, const gchar *name)
+{
+  GtkWidgetPath *path;
+  gint pos;
+
+  path = gtk_widget_path_copy (base);
+  pos = gtk_widget_path_append_type (path, type);
+  gtk_widget_path_iter_set_object_name (path, pos, name);
+
+  return path;
+}
+
+static void
+gd_main_icon_box_child_style_reset (GtkWidget *parent)
+{
+  g_signal_handlers_disconnect_by_func (parent, gd_main_icon_box_child_style_reset, NULL);
+  g_object_set_data (G_OBJECT (parent), "gd-main-icon-box-child-style", NULL);
+}
+
+/* Style lookups for the nodes that a flat child draws itself are
+ * done once per parent instead of once per child.
+ */
+static GdMainIconBoxChildStyle *
+gd_main_icon_box_child_get_style (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildStyle *style;
+  GtkStyleContext *dim_label;
+  GtkWidget *owner;
+  GtkWidgetPath *base;
+  GtkWidgetPath *path;
+  gint i;
+  gint pos;
+
+  owner = gtk_widget_get_parent (GTK_WIDGET (self));
+  if (owner == NULL)
+    owner = GTK_WIDGET (self);
+
+  style = g_object_get_data (G_OBJECT (owner), "gd-main-icon-box-child-style");
+  if (style != NULL)
+    goto out;
+
+  style = g_slice_new0 (GdMainIconBoxChildStyle);
+
+  /* The state is applied when drawing. */
+  base = gtk_widget_path_copy (gtk_widget_get_path (GTK_WIDGET (self)));
+  for (i = 0; i < gtk_widget_path_length (base); i++)
+    gtk_widget_path_iter_set_state (base, i, 0);
+
+  path = gd_main_icon_box_child_style_append_node (base, GTK_TYPE_CHECK_BUTTON, "checkbutton");
+  pos = gtk_widget_path_append_type (path, G_TYPE_NONE);
+  gtk_widget_path_iter_set_object_name (path, pos, "check");
+  style->check = gd_main_icon_box_child_style_create_context (GTK_WIDGET (self), path);
+  gtk_style_context_get (style->check, GTK_STATE_FLAG_NORMAL,
+                         "min-width", &style->check_width,
+                         "min-height", &style->check_height,
+                         NULL);
+  if (style->check_width <= 0)
+    style->check_width = 16;
+  if (style->check_height <= 0)
+    style->check_height = 16;
+
+  path = gd_main_icon_box_child_style_append_node (base, GTK_TYPE_SPINNER, "spinner");
+  style->spinner = gd_main_icon_box_child_style_create_context (GTK_WIDGET (self), path);
+
+  path = gd_main_icon_box_child_style_append_node (base, GTK_TYPE_LABEL, "label");
+  gtk_widget_path_iter_add_class (path, -1, "dim-label");
+  dim_label = gd_main_icon_box_child_style_create_context (GTK_WIDGET (self), path);
+  gtk_style_context_get (dim_label, GTK_STATE_FLAG_NORMAL, "opacity", &style->dim_label_opacity, NULL);
+  g_object_unref (dim_label);
+
+  gtk_widget_path_unref (base);
+
+  g_object_set_data_full (G_OBJECT (owner),
+                          "gd-main-icon-box-child-style",
+                          style,
+                          (GDestroyNotify) gd_main_icon_box_child_style_free);
+  g_signal_connect (owner, "style-updated", G_CALLBACK (gd_main_icon_box_child_style_reset), NULL);
+
+ out:
+  return style;
+}
+
+static void
+gd_main_icon_box_child_sync_layout (GdMainIconBoxChild *self,
+                                    PangoLayout **layout,
+                                    gboolean show_text,
+                                    const gchar *text,
+                                    PangoEllipsizeMode ellipsize)
+{
+  if (!show_text || text == NULL || text[0] == '\0')
+    {
+      g_clear_object (layout);
+      goto out;
+    }
+
+  if (*layout == NULL)
+    {
+      *layout = gtk_widget_create_pango_layout (GTK_WIDGET (self), NULL);
+      pango_layout_set_alignment (*layout, PANGO_ALIGN_CENTER);
+      pango_layout_set_ellipsize (*layout, ellipsize);
+    }
+
+  pango_layout_set_text (*layout, text, -1);
+
+ out:
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+static gint
+gd_main_icon_box_child_get_icon_size (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+  cairo_surface_t *surface;
+  gint height_scaled;
+  gint width_scaled;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->item == NULL)
+    return 0;
+
+  surface = gd_main_box_item_get_icon (priv->item);
+  if (surface == NULL || cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE)
+    return 0;
+
+  height_scaled = cairo_image_surface_get_height (surface);
+  width_scaled = cairo_image_surface_get_width (surface);
+
+  return MAX (height_scaled, width_scaled) / gtk_widget_get_scale_factor (GTK_WIDGET (self));
+}
+
+static gint
+gd_main_icon_box_child_get_layout_height (PangoLayout *layout)
+{
+  gint height;
+
+  if (layout == NULL)
+    return 0;
+
+  pango_layout_get_pixel_size (layout, NULL, &height);
+  return height;
+}
+
+static void
+gd_main_icon_box_child_get_content_border (GtkWidget *widget, GtkBorder *out_border)
+{
+  GtkBorder border;
+  GtkBorder padding;
+  GtkStateFlags state;
+  GtkStyleContext *context;
+
+  context = gtk_widget_get_style_context (widget);
+  state = gtk_style_context_get_state (context);
+  gtk_style_context_get_border (context, state, &border);
+  gtk_style_context_get_padding (context, state, &padding);
+
+  out_border->bottom = border.bottom + padding.bottom;
+  out_border->left = border.left + padding.left;
+  out_border->right = border.right + padding.right;
+  out_border->top = border.top + padding.top;
+}
+
+static void
+gd_main_icon_box_child_flat_measure (GdMainIconBoxChild *self,
+                                     GtkOrientation orientation,
+                                     gint *minimum,
+                                     gint *natural)
+{
+  GdMainIconBoxChildPrivate *priv;
+  GtkBorder border;
+  gint icon_size;
+  gint min = 0;
+  gint nat = 0;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  gd_main_icon_box_child_get_content_border (GTK_WIDGET (self), &border);
+  icon_size = gd_main_icon_box_child_get_icon_size (self);
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      PangoLayout *layouts[] = { priv->primary_layout, priv->secondary_layout };
+      guint i;
+
+      /* The text is ellipsized, so it only adds to the natural width. */
+      min = icon_size;
+      nat = icon_size;
+
+      for (i = 0; i < G_N_ELEMENTS (layouts); i++)
+        {
+          gint layout_width;
+          gint width;
+
+          if (layouts[i] == NULL)
+            continue;
+
+          /* Draw uses the width from the last allocation, and a child
+           * can be measured again without being allocated again.
+           */
+          layout_width = pango_layout_get_width (layouts[i]);
+          pango_layout_set_width (layouts[i], -1);
+          pango_layout_get_pixel_size (layouts[i], &width, NULL);
+          pango_layout_set_width (layouts[i], layout_width);
+          nat = MAX (nat, width);
+        }
+
+      min += border.left + border.right;
+      nat += border.left + border.right;
+    }
+  else
+    {
+      min = icon_size
+            + gd_main_icon_box_child_get_layout_height (priv->primary_layout)
+            + gd_main_icon_box_child_get_layout_height (priv->secondary_layout);
+      min += border.top + border.bottom;
+      nat = min;
+    }
+
+  if (minimum != NULL)
+    *minimum = min;
+
+  if (natural != NULL)
+    *natural = nat;
+}
+
+static void
+gd_main_icon_box_child_flat_allocate (GdMainIconBoxChild *self, GtkAllocation *allocation)
+{
+  GdMainIconBoxChildPrivate *priv;
+  GtkBorder border;
+  gint content_height;
+  gint content_width;
+  gint icon_size;
+  gint text_height;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  gd_main_icon_box_child_get_content_border (GTK_WIDGET (self), &border);
+  content_height = MAX (allocation->height - border.top - border.bottom, 0);
+  content_width = MAX (allocation->width - border.left - border.right, 0);
+
+  /* Laid out like the vertical GtkGrid of the non-flat children, which
+   * is centered in the child.
+   */
+  icon_size = gd_main_icon_box_child_get_icon_size (self);
+  text_height = gd_main_icon_box_child_get_layout_height (priv->primary_layout)
+                + gd_main_icon_box_child_get_layout_height (priv->secondary_layout);
+
+  priv->icon_area.x = border.left;
+  priv->icon_area.y = border.top + MAX (content_height - icon_size - text_height, 0) / 2;
+  priv->icon_area.width = content_width;
+  priv->icon_area.height = icon_size;
+  priv->text_y = priv->icon_area.y + icon_size;
+
+  if (priv->primary_layout != NULL)
+    pango_layout_set_width (priv->primary_layout, content_width * PANGO_SCALE);
+  if (priv->secondary_layout != NULL)
+    pango_layout_set_width (priv->secondary_layout, content_width * PANGO_SCALE);
+
+  _gd_main_icon_box_icon_zoom_allocate (priv->zoom, &priv->icon_area);
+}
+
+/* The angle comes from the GdMainIconBox, so that the spinners of
+ * all the children move in step, and with a single clock.
+ */
+static void
+gd_main_icon_box_child_render_spinner (GdMainIconBoxChild *self, cairo_t *cr, gdouble x, gdouble y)
+{
+  GdMainIconBoxChildPrivate *priv;
+  GdMainIconBoxChildStyle *style;
+  gdouble size;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  style = gd_main_icon_box_child_get_style (self);
+  size = (gdouble) MAIN_ICON_BOX_CHILD_SPINNER_SIZE;
+
+  cairo_save (cr);
+  cairo_translate (cr, x, y);
+  if (priv->pulsing_box != NULL)
+    cairo_rotate (cr, _gd_main_icon_box_get_spinner_angle (priv->pulsing_box));
+  gtk_style_context_set_state (style->spinner, GTK_STATE_FLAG_CHECKED);
+  gtk_render_activity (style->spinner, cr, -size / 2.0, -size / 2.0, size, size);
+  cairo_restore (cr);
+}
+
+static void
+gd_main_icon_box_child_flat_draw (GdMainIconBoxChild *self, cairo_t *cr)
+{
+  GdMainIconBoxChildPrivate *priv;
+  GdMainIconBoxChildStyle *style;
+  GtkStyleContext *context;
+  gint y;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  style = gd_main_icon_box_child_get_style (self);
+
+  _gd_main_icon_box_icon_zoom_draw (priv->zoom, cr);
+
+  if (priv->item != NULL && gd_main_box_item_get_pulse (priv->item))
+    {
+      gd_main_icon_box_child_render_spinner (self,
+                                             cr,
+                                             priv->icon_area.x + priv->icon_area.width / 2.0,
+                                             priv->icon_area.y + priv->icon_area.height / 2.0);
+    }
+
+  if (priv->selection_mode)
+    {
+      GtkStateFlags state = GTK_STATE_FLAG_NORMAL;
+      gint x;
+
+      if (gtk_flow_box_child_is_selected (GTK_FLOW_BOX_CHILD (self)))
+        state |= GTK_STATE_FLAG_CHECKED;
+
+      x = priv->icon_area.x + priv->icon_area.width - style->check_width;
+      y = priv->icon_area.y + priv->icon_area.height - style->check_height;
+
+      gtk_style_context_set_state (style->check, state);
+      gtk_render_background (style->check, cr, x, y, style->check_width, style->check_height);
+      gtk_render_frame (style->check, cr, x, y, style->check_width, style->check_height);
+      gtk_render_check (style->check, cr, x, y, style->check_width, style->check_height);
+    }
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (self));
+  y = priv->text_y;
+
+  if (priv->primary_layout != NULL)
+    {
+      gtk_render_layout (context, cr, priv->icon_area.x, y, priv->primary_layout);
+      y += gd_main_icon_box_child_get_layout_height (priv->primary_layout);
+    }
+
+  if (priv->secondary_layout != NULL)
+    {
+      cairo_push_group (cr);
+      gtk_render_layout (context, cr, priv->icon_area.x, y, priv->secondary_layout);
+      cairo_pop_group_to_source (cr);
+      cairo_paint_with_alpha (cr, style->dim_label_opacity);
+    }
+}
+
+static void
+gd_main_icon_box_child_update_pulsing (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+  GtkWidget *parent;
+  gboolean pulsing;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  /* Only the mapped children take part in the shared animation, and
+   * only while there is a spinner to draw.
+   */
+  parent = gtk_widget_get_parent (GTK_WIDGET (self));
+  pulsing = GD_IS_MAIN_ICON_BOX (parent)
+            && gtk_widget_get_mapped (GTK_WIDGET (self))
+            && priv->item != NULL
+            && gd_main_box_item_get_pulse (priv->item)
+            && (priv->flat || priv->spinner != NULL);
+
+  if (pulsing == (priv->pulsing_box != NULL))
+    return;
+
+  if (pulsing)
+    {
+      priv->pulsing_box = GD_MAIN_ICON_BOX (parent);
+      _gd_main_icon_box_add_pulsing_child (priv->pulsing_box, self);
+    }
+  else
+    {
+      _gd_main_icon_box_remove_pulsing_child (priv->pulsing_box, self);
+      priv->pulsing_box = NULL;
+    }
+}
+
+static void
+gd_main_icon_box_child_notify_primary_text (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+  const gchar *text = NULL;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->item != NULL)
+    text = gd_main_box_item_get_primary_text (priv->item);
+
+  if (priv->flat)
+    gd_main_icon_box_child_sync_layout (self, &priv->primary_layout, priv->show_primary_text, text, PANGO_ELLIPSIZE_MIDDLE);
+  else
+    gd_main_icon_box_child_sync_label (priv->primary_label, text);
+}
+
+static void
+gd_main_icon_box_child_notify_secondary_text (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+  const gchar *text = NULL;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->item != NULL)
+    text = gd_main_box_item_get_secondary_text (priv->item);
+
+  if (priv->flat)
+    gd_main_icon_box_child_sync_layout (self, &priv->secondary_layout, priv->show_secondary_text, text, PANGO_ELLIPSIZE_END);
+  else
+    gd_main_icon_box_child_sync_label (priv->secondary_label, text);
+}
+
+static void
+gd_main_icon_box_child_notify_icon (GdMainIconBoxChild *self)
 {
-  gboolean to_visible;
-  const gchar *from_text;
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
 
-  from_text = g_value_get_string (from_value);
-  to_visible = from_text != NULL && from_text[0] != '\0' ? TRUE : FALSE;
-  g_value_set_boolean (to_value, to_visible);
-  return TRUE;
+  /* GdMainIconBoxIcon takes care of it otherwise. */
+  if (!priv->flat)
+    return;
+
+  _gd_main_icon_box_icon_zoom_set_icon (priv->zoom, gd_main_box_item_get_icon (priv->item));
+  gtk_widget_queue_resize (GTK_WIDGET (self));
 }
 
 static void
@@ -84,17 +559,156 @@ gd_main_icon_box_check_button_toggled (GdMainIconBoxChild *self)
     gtk_flow_box_unselect_child (GTK_FLOW_BOX (parent), GTK_FLOW_BOX_CHILD (self));
 }
 
+/* Most of the time the children are never put in selection mode, so
+ * the check button is only created once a mapped child is. Leaving
+ * selection mode hides it, and the GdMainIconBox releases the hidden
+ * check buttons of all its children at once if it does not come back
+ * to selection mode within a grace period.
+ */
+static void
+gd_main_icon_box_child_sync_check_button (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->overlay == NULL)
+    return;
+
+  if (!priv->selection_mode)
+    {
+      if (priv->check_button != NULL)
+        gtk_widget_hide (priv->check_button);
+      return;
+    }
+
+  if (priv->check_button == NULL)
+    {
+      if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+        return;
+
+      priv->check_button = gtk_check_button_new ();
+      gtk_widget_set_can_focus (priv->check_button, FALSE);
+      gtk_widget_set_halign (priv->check_button, GTK_ALIGN_END);
+      gtk_widget_set_valign (priv->check_button, GTK_ALIGN_END);
+      gtk_widget_set_no_show_all (priv->check_button, TRUE);
+      gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (priv->check_button),
+                                    gtk_flow_box_child_is_selected (GTK_FLOW_BOX_CHILD (self)));
+      gtk_overlay_add_overlay (GTK_OVERLAY (priv->overlay), priv->check_button);
+      g_signal_connect_swapped (priv->check_button,
+                                "toggled",
+                                G_CALLBACK (gd_main_icon_box_check_button_toggled),
+                                self);
+    }
+
+  gtk_widget_show (priv->check_button);
+}
+
+static gboolean
+gd_main_icon_box_child_spinner_draw (GdMainIconBoxChild *self, cairo_t *cr, GtkWidget *spinner)
+{
+  gd_main_icon_box_child_render_spinner (self,
+                                         cr,
+                                         gtk_widget_get_allocated_width (spinner) / 2.0,
+                                         gtk_widget_get_allocated_height (spinner) / 2.0);
+  return GDK_EVENT_STOP;
+}
+
+static void
+gd_main_icon_box_child_sync_spinner (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+  gboolean pulse;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->pulse_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->pulse_tick_id);
+      priv->pulse_tick_id = 0;
+    }
+
+  if (priv->overlay == NULL)
+    return;
+
+  pulse = priv->item != NULL && gd_main_box_item_get_pulse (priv->item);
+  if (pulse == (priv->spinner != NULL))
+    return;
+
+  /* Only the spinner comes and goes. The rest of the children stay. */
+  if (pulse)
+    {
+      priv->spinner = gtk_drawing_area_new ();
+      gtk_widget_set_halign (priv->spinner, GTK_ALIGN_CENTER);
+      gtk_widget_set_size_request (priv->spinner,
+                                   MAIN_ICON_BOX_CHILD_SPINNER_SIZE,
+                                   MAIN_ICON_BOX_CHILD_SPINNER_SIZE);
+      gtk_widget_set_valign (priv->spinner, GTK_ALIGN_CENTER);
+      g_signal_connect_swapped (priv->spinner,
+                                "draw",
+                                G_CALLBACK (gd_main_icon_box_child_spinner_draw),
+                                self);
+      gtk_widget_show (priv->spinner);
+      gtk_overlay_add_overlay (GTK_OVERLAY (priv->overlay), priv->spinner);
+    }
+  else
+    {
+      gtk_widget_destroy (priv->spinner);
+      priv->spinner = NULL;
+    }
+
+  gd_main_icon_box_child_update_pulsing (self);
+}
+
+static gboolean
+gd_main_icon_box_child_pulse_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  priv->pulse_tick_id = 0;
+  gd_main_icon_box_child_sync_spinner (self);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 gd_main_icon_box_child_update_layout (GdMainIconBoxChild *self)
 {
   GdMainIconBoxChildPrivate *priv;
   GtkWidget *grid;
-  GtkWidget *icon;
   GtkWidget *overlay;
 
   priv = gd_main_icon_box_child_get_instance_private (self);
 
   gtk_container_foreach (GTK_CONTAINER (self), (GtkCallback) gtk_widget_destroy, NULL);
+  priv->check_button = NULL;
+  priv->icon = NULL;
+  priv->overlay = NULL;
+  priv->primary_label = NULL;
+  priv->secondary_label = NULL;
+  priv->spinner = NULL;
+
+  g_clear_object (&priv->primary_layout);
+  g_clear_object (&priv->secondary_layout);
+  _gd_main_icon_box_icon_zoom_set_icon (priv->zoom,
+                                        priv->flat && priv->item != NULL
+                                        ? gd_main_box_item_get_icon (priv->item)
+                                        : NULL);
+  gd_main_icon_box_child_update_pulsing (self);
+
+  /* A flat child has no widgets of its own, and draws everything
+   * from its item.
+   */
+  if (priv->flat)
+    {
+      gd_main_icon_box_child_notify_primary_text (self);
+      gd_main_icon_box_child_notify_secondary_text (self);
+      gtk_widget_queue_resize (GTK_WIDGET (self));
+      return;
+    }
 
   grid = gtk_grid_new ();
   gtk_widget_set_valign (grid, GTK_ALIGN_CENTER);
@@ -103,85 +717,71 @@ gd_main_icon_box_child_update_layout (GdMainIconBoxChild *self)
 
   overlay = gtk_overlay_new ();
   gtk_container_add (GTK_CONTAINER (grid), overlay);
+  priv->overlay = overlay;
 
-  icon = gd_main_icon_box_icon_new (priv->item);
-  gtk_widget_set_hexpand (icon, TRUE);
-  gtk_container_add (GTK_CONTAINER (overlay), icon);
+  priv->icon = gd_main_icon_box_icon_new (priv->item);
+  gtk_widget_set_hexpand (priv->icon, TRUE);
+  gtk_container_add (GTK_CONTAINER (overlay), priv->icon);
 
-  if (gd_main_box_item_get_pulse (priv->item))
-    {
-      GtkWidget *spinner;
-
-      spinner = gtk_spinner_new ();
-      gtk_widget_set_halign (spinner, GTK_ALIGN_CENTER);
-      gtk_widget_set_size_request (spinner, 32, 32);
-      gtk_widget_set_valign (spinner, GTK_ALIGN_CENTER);
-      gtk_spinner_start (GTK_SPINNER (spinner));
-      gtk_overlay_add_overlay (GTK_OVERLAY (overlay), spinner);
-    }
-
-  priv->check_button = gtk_check_button_new ();
-  gtk_widget_set_can_focus (priv->check_button, FALSE);
-  gtk_widget_set_halign (priv->check_button, GTK_ALIGN_END);
-  gtk_widget_set_valign (priv->check_button, GTK_ALIGN_END);
-  gtk_widget_set_no_show_all (priv->check_button, TRUE);
-  g_object_bind_property (self, "selection-mode", priv->check_button, "visible", G_BINDING_SYNC_CREATE);
-  gtk_overlay_add_overlay (GTK_OVERLAY (overlay), priv->check_button);
-  g_signal_connect_swapped (priv->check_button,
-                            "toggled",
-                            G_CALLBACK (gd_main_icon_box_check_button_toggled),
-                            self);
+  gd_main_icon_box_child_sync_spinner (self);
 
   if (priv->show_primary_text)
     {
-      GtkWidget *primary_label;
-
-      primary_label = gtk_label_new (NULL);
-      gtk_widget_set_no_show_all (primary_label, TRUE);
-      gtk_label_set_ellipsize (GTK_LABEL (primary_label), PANGO_ELLIPSIZE_MIDDLE);
-      g_object_bind_property (priv->item, "primary-text", primary_label, "label", G_BINDING_SYNC_CREATE);
-      g_object_bind_property_full (priv->item,
-                                   "primary-text",
-                                   primary_label,
-                                   "visible",
-                                   G_BINDING_SYNC_CREATE,
-                                   gd_main_icon_box_child_bind_text_to_visible,
-                                   NULL,
-                                   NULL,
-                                   NULL);
-      gtk_container_add (GTK_CONTAINER (grid), primary_label);
+      priv->primary_label = gtk_label_new (NULL);
+      gtk_widget_set_no_show_all (priv->primary_label, TRUE);
+      gtk_label_set_ellipsize (GTK_LABEL (priv->primary_label), PANGO_ELLIPSIZE_MIDDLE);
+      gtk_container_add (GTK_CONTAINER (grid), priv->primary_label);
+      gd_main_icon_box_child_notify_primary_text (self);
     }
 
   if (priv->show_secondary_text)
     {
       GtkStyleContext *context;
-      GtkWidget *secondary_label;
 
-      secondary_label = gtk_label_new (NULL);
-      gtk_widget_set_no_show_all (secondary_label, TRUE);
-      gtk_label_set_ellipsize (GTK_LABEL (secondary_label), PANGO_ELLIPSIZE_END);
-      context = gtk_widget_get_style_context (secondary_label);
+      priv->secondary_label = gtk_label_new (NULL);
+      gtk_widget_set_no_show_all (priv->secondary_label, TRUE);
+      gtk_label_set_ellipsize (GTK_LABEL (priv->secondary_label), PANGO_ELLIPSIZE_END);
+      context = gtk_widget_get_style_context (priv->secondary_label);
       gtk_style_context_add_class (context, "dim-label");
-      g_object_bind_property (priv->item, "secondary-text", secondary_label, "label", G_BINDING_SYNC_CREATE);
-      g_object_bind_property_full (priv->item,
-                                   "secondary-text",
-                                   secondary_label,
-                                   "visible",
-                                   G_BINDING_SYNC_CREATE,
-                                   gd_main_icon_box_child_bind_text_to_visible,
-                                   NULL,
-                                   NULL,
-                                   NULL);
-      gtk_container_add (GTK_CONTAINER (grid), secondary_label);
+      gtk_container_add (GTK_CONTAINER (grid), priv->secondary_label);
+      gd_main_icon_box_child_notify_secondary_text (self);
     }
 
   gtk_widget_show_all (grid);
+  gd_main_icon_box_child_sync_check_button (self);
 }
 
 static void
 gd_main_icon_box_child_notify_pulse (GdMainIconBoxChild *self)
 {
-  gd_main_icon_box_child_update_layout (self);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    {
+      gd_main_icon_box_child_update_pulsing (self);
+      gtk_widget_queue_draw (GTK_WIDGET (self));
+      return;
+    }
+
+  /* Batch imports flip the pulse of a lot of items at once, and an
+   * item can flip back and forth before the next frame. Apply it once
+   * per frame, which also gives a single relayout for all of them.
+   */
+  if (!gtk_widget_get_realized (GTK_WIDGET (self)))
+    {
+      gd_main_icon_box_child_sync_spinner (self);
+      return;
+    }
+
+  if (priv->pulse_tick_id == 0)
+    {
+      priv->pulse_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                          gd_main_icon_box_child_pulse_tick,
+                                                          NULL,
+                                                          NULL);
+    }
 }
 
 static GdMainBoxItem *
@@ -198,9 +798,18 @@ static gint
 gd_main_icon_box_child_get_index (GdMainBoxChild *child)
 {
   GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (child);
+  GtkWidget *parent;
   gint index;
 
   index = gtk_flow_box_child_get_index (GTK_FLOW_BOX_CHILD (self));
+
+  /* A virtualized GdMainIconBox only has children for a window of
+   * its model.
+   */
+  parent = gtk_widget_get_parent (GTK_WIDGET (self));
+  if (index >= 0 && GD_IS_MAIN_ICON_BOX (parent))
+    index += (gint) _gd_main_icon_box_get_window_start (GD_MAIN_ICON_BOX (parent));
+
   return index;
 }
 
@@ -214,6 +823,15 @@ gd_main_icon_box_child_get_selected (GdMainBoxChild *child)
   return selected;
 }
 
+static gboolean
+gd_main_icon_box_child_get_flat (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+  return priv->flat;
+}
+
 static gboolean
 gd_main_icon_box_child_get_selection_mode (GdMainIconBoxChild *self)
 {
@@ -242,39 +860,41 @@ gd_main_icon_box_child_get_show_secondary_text (GdMainIconBoxChild *self)
 }
 
 static void
-gd_main_icon_box_child_set_item (GdMainIconBoxChild *self, GdMainBoxItem *item)
+gd_main_icon_box_child_set_selected (GdMainBoxChild *child, gboolean selected)
 {
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (child);
   GdMainIconBoxChildPrivate *priv;
 
   priv = gd_main_icon_box_child_get_instance_private (self);
 
-  if (priv->item != NULL)
-    g_signal_handlers_disconnect_by_func (priv->item, gd_main_icon_box_child_notify_pulse, self);
-
-  if (!g_set_object (&priv->item, item))
-    return;
-
-  if (priv->item != NULL)
+  if (priv->check_button == NULL)
     {
-      g_signal_connect_object (priv->item,
-                               "notify::pulse",
-                               G_CALLBACK (gd_main_icon_box_child_notify_pulse),
-                               self,
-                               G_CONNECT_SWAPPED);
+      gtk_widget_queue_draw (GTK_WIDGET (self));
+      return;
     }
 
-  g_object_notify (G_OBJECT (self), "item");
-  gtk_widget_queue_draw (GTK_WIDGET (self));
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (priv->check_button), selected);
 }
 
 static void
-gd_main_icon_box_child_set_selected (GdMainBoxChild *child, gboolean selected)
+gd_main_icon_box_child_set_flat (GdMainIconBoxChild *self, gboolean flat)
 {
-  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (child);
   GdMainIconBoxChildPrivate *priv;
+  gboolean has_layout;
 
   priv = gd_main_icon_box_child_get_instance_private (self);
-  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (priv->check_button), selected);
+
+  if (priv->flat == flat)
+    return;
+
+  /* Nothing to rebuild while being constructed. */
+  has_layout = priv->flat || priv->icon != NULL;
+
+  priv->flat = flat;
+  if (has_layout)
+    gd_main_icon_box_child_update_layout (self);
+
+  g_object_notify (G_OBJECT (self), "flat");
 }
 
 static void
@@ -288,6 +908,7 @@ gd_main_icon_box_child_set_selection_mode (GdMainIconBoxChild *self, gboolean se
     return;
 
   priv->selection_mode = selection_mode;
+  gd_main_icon_box_child_sync_check_button (self);
   g_object_notify (G_OBJECT (self), "selection-mode");
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
@@ -322,6 +943,203 @@ gd_main_icon_box_child_set_show_secondary_text (GdMainIconBoxChild *self, gboole
   g_object_notify (G_OBJECT (self), "show-secondary-text");
 }
 
+static gboolean
+gd_main_icon_box_child_draw (GtkWidget *widget, cairo_t *cr)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->draw (widget, cr);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_draw (self, cr);
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+gd_main_icon_box_child_get_preferred_height (GtkWidget *widget, gint *minimum, gint *natural)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_measure (self, GTK_ORIENTATION_VERTICAL, minimum, natural);
+  else
+    GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->get_preferred_height (widget, minimum, natural);
+}
+
+static void
+gd_main_icon_box_child_get_preferred_height_for_width (GtkWidget *widget,
+                                                       gint width,
+                                                       gint *minimum,
+                                                       gint *natural)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_measure (self, GTK_ORIENTATION_VERTICAL, minimum, natural);
+  else
+    GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->get_preferred_height_for_width (widget,
+                                                                                          width,
+                                                                                          minimum,
+                                                                                          natural);
+}
+
+static void
+gd_main_icon_box_child_get_preferred_width (GtkWidget *widget, gint *minimum, gint *natural)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_measure (self, GTK_ORIENTATION_HORIZONTAL, minimum, natural);
+  else
+    GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->get_preferred_width (widget, minimum, natural);
+}
+
+static void
+gd_main_icon_box_child_get_preferred_width_for_height (GtkWidget *widget,
+                                                       gint height,
+                                                       gint *minimum,
+                                                       gint *natural)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_measure (self, GTK_ORIENTATION_HORIZONTAL, minimum, natural);
+  else
+    GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->get_preferred_width_for_height (widget,
+                                                                                          height,
+                                                                                          minimum,
+                                                                                          natural);
+}
+
+static GtkSizeRequestMode
+gd_main_icon_box_child_get_request_mode (GtkWidget *widget)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    return GTK_SIZE_REQUEST_CONSTANT_SIZE;
+
+  return GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->get_request_mode (widget);
+}
+
+static void
+gd_main_icon_box_child_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->size_allocate (widget, allocation);
+
+  if (priv->flat)
+    gd_main_icon_box_child_flat_allocate (self, allocation);
+}
+
+static void
+gd_main_icon_box_child_style_updated (GtkWidget *widget)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->style_updated (widget);
+
+  if (priv->primary_layout != NULL)
+    pango_layout_context_changed (priv->primary_layout);
+  if (priv->secondary_layout != NULL)
+    pango_layout_context_changed (priv->secondary_layout);
+
+  if (priv->flat)
+    gtk_widget_queue_resize (widget);
+}
+
+static void
+gd_main_icon_box_child_map (GtkWidget *widget)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  _gd_main_icon_box_icon_zoom_map (priv->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->map (widget);
+  gd_main_icon_box_child_sync_check_button (self);
+  gd_main_icon_box_child_update_pulsing (self);
+}
+
+static void
+gd_main_icon_box_child_unmap (GtkWidget *widget)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  _gd_main_icon_box_icon_zoom_unmap (priv->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->unmap (widget);
+  gd_main_icon_box_child_update_pulsing (self);
+}
+
+static void
+gd_main_icon_box_child_unrealize (GtkWidget *widget)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  _gd_main_icon_box_icon_zoom_unrealize (priv->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->unrealize (widget);
+}
+
+static void
+gd_main_icon_box_child_state_flags_changed (GtkWidget *widget, GtkStateFlags previous_state)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (widget);
+  GtkStateFlags state;
+  GtkWidget *parent;
+  gboolean selected;
+
+  /* GtkFlowBox marks selected children with GTK_STATE_FLAG_SELECTED.
+   * Following it here means that the check buttons are only updated
+   * for the children whose selection actually changed.
+   */
+  state = gtk_widget_get_state_flags (widget);
+  if (((state ^ previous_state) & GTK_STATE_FLAG_SELECTED) != 0)
+    {
+      selected = (state & GTK_STATE_FLAG_SELECTED) != 0;
+      gd_main_box_child_set_selected (GD_MAIN_BOX_CHILD (self), selected);
+
+      parent = gtk_widget_get_parent (widget);
+      if (GD_IS_MAIN_ICON_BOX (parent))
+        _gd_main_icon_box_track_child_selection (GD_MAIN_ICON_BOX (parent), GTK_FLOW_BOX_CHILD (self), selected);
+    }
+
+  if (GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->state_flags_changed != NULL)
+    GTK_WIDGET_CLASS (gd_main_icon_box_child_parent_class)->state_flags_changed (widget, previous_state);
+}
+
 static void
 gd_main_icon_box_child_constructed (GObject *obj)
 {
@@ -340,11 +1158,39 @@ gd_main_icon_box_child_dispose (GObject *obj)
 
   priv = gd_main_icon_box_child_get_instance_private (self);
 
+  if (priv->pulse_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->pulse_tick_id);
+      priv->pulse_tick_id = 0;
+    }
+
+  if (priv->pulsing_box != NULL)
+    {
+      _gd_main_icon_box_remove_pulsing_child (priv->pulsing_box, self);
+      priv->pulsing_box = NULL;
+    }
+
+  _gd_main_icon_box_icon_zoom_set_icon (priv->zoom, NULL);
   g_clear_object (&priv->item);
+  g_clear_object (&priv->primary_layout);
+  g_clear_object (&priv->secondary_layout);
 
   G_OBJECT_CLASS (gd_main_icon_box_child_parent_class)->dispose (obj);
 }
 
+static void
+gd_main_icon_box_child_finalize (GObject *obj)
+{
+  GdMainIconBoxChild *self = GD_MAIN_ICON_BOX_CHILD (obj);
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  _gd_main_icon_box_icon_zoom_free (priv->zoom);
+
+  G_OBJECT_CLASS (gd_main_icon_box_child_parent_class)->finalize (obj);
+}
+
 static void
 gd_main_icon_box_child_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
 {
@@ -364,6 +1210,9 @@ gd_main_icon_box_child_get_property (GObject *object, guint property_id, GValue
     case PROP_SHOW_SECONDARY_TEXT:
       g_value_set_boolean (value, gd_main_icon_box_child_get_show_secondary_text (self));
       break;
+    case PROP_FLAT:
+      g_value_set_boolean (value, gd_main_icon_box_child_get_flat (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -389,6 +1238,9 @@ gd_main_icon_box_child_set_property (GObject *object, guint property_id, const G
     case PROP_SHOW_SECONDARY_TEXT:
       gd_main_icon_box_child_set_show_secondary_text (self, g_value_get_boolean (value));
       break;
+    case PROP_FLAT:
+      gd_main_icon_box_child_set_flat (self, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -398,8 +1250,12 @@ gd_main_icon_box_child_set_property (GObject *object, guint property_id, const G
 static void
 gd_main_icon_box_child_init (GdMainIconBoxChild *self)
 {
+  GdMainIconBoxChildPrivate *priv;
   GtkStyleContext *context;
 
+  priv = gd_main_icon_box_child_get_instance_private (self);
+  priv->zoom = _gd_main_icon_box_icon_zoom_new (GTK_WIDGET (self));
+
   context = gtk_widget_get_style_context (GTK_WIDGET (self));
   gtk_style_context_add_class (context, "tile");
 }
@@ -408,16 +1264,41 @@ static void
 gd_main_icon_box_child_class_init (GdMainIconBoxChildClass *klass)
 {
   GObjectClass *oclass = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *wclass = GTK_WIDGET_CLASS (klass);
 
   oclass->constructed = gd_main_icon_box_child_constructed;
   oclass->dispose = gd_main_icon_box_child_dispose;
+  oclass->finalize = gd_main_icon_box_child_finalize;
   oclass->get_property = gd_main_icon_box_child_get_property;
   oclass->set_property = gd_main_icon_box_child_set_property;
+  wclass->draw = gd_main_icon_box_child_draw;
+  wclass->get_preferred_height = gd_main_icon_box_child_get_preferred_height;
+  wclass->get_preferred_height_for_width = gd_main_icon_box_child_get_preferred_height_for_width;
+  wclass->get_preferred_width = gd_main_icon_box_child_get_preferred_width;
+  wclass->get_preferred_width_for_height = gd_main_icon_box_child_get_preferred_width_for_height;
+  wclass->get_request_mode = gd_main_icon_box_child_get_request_mode;
+  wclass->map = gd_main_icon_box_child_map;
+  wclass->size_allocate = gd_main_icon_box_child_size_allocate;
+  wclass->state_flags_changed = gd_main_icon_box_child_state_flags_changed;
+  wclass->style_updated = gd_main_icon_box_child_style_updated;
+  wclass->unmap = gd_main_icon_box_child_unmap;
+  wclass->unrealize = gd_main_icon_box_child_unrealize;
 
   g_object_class_override_property (oclass, PROP_ITEM, "item");
   g_object_class_override_property (oclass, PROP_SELECTION_MODE, "selection-mode");
   g_object_class_override_property (oclass, PROP_SHOW_PRIMARY_TEXT, "show-primary-text");
   g_object_class_override_property (oclass, PROP_SHOW_SECONDARY_TEXT, "show-secondary-text");
+
+  g_object_class_install_property (oclass,
+                                   PROP_FLAT,
+                                   g_param_spec_boolean ("flat",
+                                                         "Flat",
+                                                         "Whether to draw the item without any child widgets",
+                                                         FALSE,
+                                                         G_PARAM_CONSTRUCT |
+                                                         G_PARAM_EXPLICIT_NOTIFY |
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -437,3 +1318,113 @@ gd_main_icon_box_child_new (GdMainBoxItem *item, gboolean selection_mode)
                        "selection-mode", selection_mode,
                        NULL);
 }
+
+/**
+ * gd_main_icon_box_child_set_item:
+ * @self:
+ * @item: (allow-none):
+ *
+ * Makes @self render @item. The existing widgets are reused, which is
+ * a lot cheaper than creating a new child.
+ */
+void
+gd_main_icon_box_child_set_item (GdMainIconBoxChild *self, GdMainBoxItem *item)
+{
+  GdMainIconBoxChildPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX_CHILD (self));
+  g_return_if_fail (item == NULL || GD_IS_MAIN_BOX_ITEM (item));
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->item == item)
+    return;
+
+  if (priv->item != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->item, gd_main_icon_box_child_notify_icon, self);
+      g_signal_handlers_disconnect_by_func (priv->item, gd_main_icon_box_child_notify_primary_text, self);
+      g_signal_handlers_disconnect_by_func (priv->item, gd_main_icon_box_child_notify_pulse, self);
+      g_signal_handlers_disconnect_by_func (priv->item, gd_main_icon_box_child_notify_secondary_text, self);
+    }
+
+  g_set_object (&priv->item, item);
+
+  if (priv->item != NULL)
+    {
+      g_signal_connect_object (priv->item,
+                               "notify::icon",
+                               G_CALLBACK (gd_main_icon_box_child_notify_icon),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (priv->item,
+                               "notify::primary-text",
+                               G_CALLBACK (gd_main_icon_box_child_notify_primary_text),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (priv->item,
+                               "notify::pulse",
+                               G_CALLBACK (gd_main_icon_box_child_notify_pulse),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (priv->item,
+                               "notify::secondary-text",
+                               G_CALLBACK (gd_main_icon_box_child_notify_secondary_text),
+                               self,
+                               G_CONNECT_SWAPPED);
+    }
+
+  if (priv->flat)
+    {
+      _gd_main_icon_box_icon_zoom_set_icon (priv->zoom, priv->item != NULL ? gd_main_box_item_get_icon (priv->item) : NULL);
+      gd_main_icon_box_child_notify_primary_text (self);
+      gd_main_icon_box_child_notify_secondary_text (self);
+      gd_main_icon_box_child_update_pulsing (self);
+    }
+  /* Nothing to rebind until the layout has been created. */
+  else if (priv->icon != NULL)
+    {
+      gd_main_icon_box_icon_set_item (GD_MAIN_ICON_BOX_ICON (priv->icon), priv->item);
+      gd_main_icon_box_child_notify_primary_text (self);
+      gd_main_icon_box_child_notify_secondary_text (self);
+      gd_main_icon_box_child_sync_spinner (self);
+    }
+
+  g_object_notify (G_OBJECT (self), "item");
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+void
+_gd_main_icon_box_child_queue_spinner_draw (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->flat)
+    {
+      gtk_widget_queue_draw_area (GTK_WIDGET (self),
+                                  priv->icon_area.x,
+                                  priv->icon_area.y,
+                                  priv->icon_area.width,
+                                  priv->icon_area.height);
+    }
+  else if (priv->spinner != NULL)
+    {
+      gtk_widget_queue_draw (priv->spinner);
+    }
+}
+
+void
+_gd_main_icon_box_child_release_check_button (GdMainIconBoxChild *self)
+{
+  GdMainIconBoxChildPrivate *priv;
+
+  priv = gd_main_icon_box_child_get_instance_private (self);
+
+  if (priv->selection_mode || priv->check_button == NULL)
+    return;
+
+  gtk_widget_destroy (priv->check_button);
+  priv->check_button = NULL;
+}
@@ -36,7 +36,12 @@ struct _GdMainIconBoxChildClass
   GtkFlowBoxChildClass parent_class;
 };
 
-GtkWidget * gd_main_icon_box_child_new (GdMainBoxItem *item, gboolean selection_mode);
+GtkWidget * gd_main_icon_box_child_new        (GdMainBoxItem *item, gboolean selection_mode);
+void        gd_main_icon_box_child_set_item   (GdMainIconBoxChild *self, GdMainBoxItem *item);
+
+/* private */
+void        _gd_main_icon_box_child_queue_spinner_draw  (GdMainIconBoxChild *self);
+void        _gd_main_icon_box_child_release_check_button  (GdMainIconBoxChild *self);
 
 G_END_DECLS
 
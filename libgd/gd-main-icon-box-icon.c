@@ -19,18 +19,65 @@
  *
  */
 
+
+#include "gd-icon-utils.h"
 #include "gd-main-icon-box-icon.h"
+#include "gd-surface-cache.h"
 
 #include <cairo.h>
 #include <glib.h>
 
+/* How long, in milliseconds, the allocation has to stay the same
+ * before the icon is resampled for it.
+ */
+#define MAIN_ICON_BOX_ICON_SETTLE_TIMEOUT 150
+
+#define MAIN_ICON_BOX_ICON_DEFAULT_MAX_ZOOMED_SIZE (128 * 1024 * 1024)
+
+typedef struct _GdMainIconBoxIconUpload GdMainIconBoxIconUpload;
+
 struct _GdMainIconBoxIcon
 {
   GtkDrawingArea parent_instance;
   GdMainBoxItem *item;
+  GdMainIconBoxIconZoom *zoom;
+};
+
+/* Everything needed to show an icon zoomed to fit an area of a widget.
+ * Shared by GdMainIconBoxIcon and the flat GdMainIconBoxChild, which
+ * draws its icon without a widget of its own.
+ */
+struct _GdMainIconBoxIconZoom
+{
+  GCancellable *cancellable;
+  GList link;
+  GdMainIconBoxIconUpload *upload;
+  GdkRectangle area;
+  GtkWidget *widget;
+  cairo_surface_t *icon;
   cairo_surface_t *surface_zoomed;
   gdouble x;
   gdouble y;
+  gint height_pending;
+  gint height_zoomed;
+  gint surface_zoomed_height;
+  gint surface_zoomed_width;
+  gint width_pending;
+  gint width_zoomed;
+  gsize surface_zoomed_size;
+  guint settle_id;
+};
+
+struct _GdMainIconBoxIconUpload
+{
+  GdkScreen *screen;
+  cairo_surface_t *icon;
+  cairo_surface_t *uploaded;
+  gint height;
+  gint scale_factor;
+  gint width;
+  gsize size;
+  guint ref_count;
 };
 
 enum
@@ -41,50 +88,357 @@ enum
 
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
+static void gd_main_icon_box_icon_zoom_cancel (GdMainIconBoxIconZoom *zoom);
+static void gd_main_icon_box_icon_zoom_set_surface (GdMainIconBoxIconZoom *zoom, cairo_surface_t *zoomed);
+static void gd_main_icon_box_icon_upload_unref (GdMainIconBoxIconUpload *upload);
+
+/* The icons that hold a zoomed surface, and the number of bytes in
+ * those surfaces and in the copies uploaded for the window. A surface
+ * that is shared by several icons is only counted once.
+ *
+ * Mapped icons are kept most recently drawn first. Unmapped icons are
+ * kept apart, most recently unmapped first, because they are the first
+ * to go and finding them shouldn't mean walking past all the others.
+ */
+static GQueue unmapped_icons = G_QUEUE_INIT;
+static GQueue zoomed_icons = G_QUEUE_INIT;
+static GHashTable *uploads;
+static GHashTable *zoomed_surfaces;
+static gsize max_zoomed_size = MAIN_ICON_BOX_ICON_DEFAULT_MAX_ZOOMED_SIZE;
+static gsize zoomed_size;
+
 G_DEFINE_TYPE (GdMainIconBoxIcon, gd_main_icon_box_icon, GTK_TYPE_DRAWING_AREA)
 
-static cairo_surface_t *
-gd_zoom_image_surface (cairo_surface_t *surface, gint width_zoomed, gint height_zoomed)
+static GQueue *
+gd_main_icon_box_icon_zoom_get_queue (GdMainIconBoxIconZoom *zoom)
 {
-  cairo_t *cr;
-  cairo_format_t format;
-  cairo_pattern_t *pattern;
-  cairo_surface_t *zoomed = NULL;
-  cairo_surface_type_t surface_type;
-  gdouble scale_x;
-  gdouble scale_y;
-  gdouble zoom_x;
-  gdouble zoom_y;
-  gint height;
-  gint width;
+  return gtk_widget_get_mapped (zoom->widget) ? &zoomed_icons : &unmapped_icons;
+}
 
-  g_return_val_if_fail (surface != NULL, NULL);
+static gboolean
+gd_main_icon_box_icon_zoom_is_in_viewport (GdMainIconBoxIconZoom *zoom)
+{
+  GtkAllocation viewport_allocation;
+  GtkWidget *viewport;
+  gint x;
+  gint y;
 
-  surface_type = cairo_surface_get_type (surface);
-  g_return_val_if_fail (surface_type == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+  if (!gtk_widget_get_mapped (zoom->widget))
+    return FALSE;
 
-  format = cairo_image_surface_get_format (surface);
-  zoomed = cairo_surface_create_similar_image (surface, format, width_zoomed, height_zoomed);
-  cairo_surface_get_device_scale (surface, &scale_x, &scale_y);
-  cairo_surface_set_device_scale (zoomed, scale_x, scale_y);
+  viewport = gtk_widget_get_ancestor (zoom->widget, GTK_TYPE_SCROLLED_WINDOW);
+  if (viewport == NULL)
+    return TRUE;
 
-  cr = cairo_create (zoomed);
+  if (!gtk_widget_translate_coordinates (zoom->widget, viewport, zoom->area.x, zoom->area.y, &x, &y))
+    return FALSE;
 
-  pattern = cairo_get_source (cr);
-  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REFLECT);
-  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  gtk_widget_get_allocation (viewport, &viewport_allocation);
 
-  height = cairo_image_surface_get_height (surface);
-  width = cairo_image_surface_get_width (surface);
-  zoom_x = (double) width_zoomed / (gdouble) width;
-  zoom_y = (double) height_zoomed / (gdouble) height;
-  cairo_scale (cr, zoom_x, zoom_y);
-  cairo_set_source_surface (cr, surface, 0, 0);
+  return x < viewport_allocation.width
+         && y < viewport_allocation.height
+         && x + zoom->area.width > 0
+         && y + zoom->area.height > 0;
+}
 
-  cairo_paint (cr);
-  cairo_destroy (cr);
+static void
+gd_main_icon_box_icon_account_zoomed (cairo_surface_t *surface, gsize size, gboolean add)
+{
+  guint count;
+
+  if (zoomed_surfaces == NULL)
+    zoomed_surfaces = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (zoomed_surfaces, surface));
+  if (add)
+    count++;
+  else
+    count--;
+
+  if (count == 0)
+    g_hash_table_remove (zoomed_surfaces, surface);
+  else
+    g_hash_table_insert (zoomed_surfaces, surface, GUINT_TO_POINTER (count));
+
+  if (add && count == 1)
+    zoomed_size += size;
+  else if (count == 0)
+    zoomed_size -= size;
+}
+
+static void
+gd_main_icon_box_icon_zoom_evict (GdMainIconBoxIconZoom *zoom)
+{
+  gd_main_icon_box_icon_zoom_cancel (zoom);
+  gd_main_icon_box_icon_zoom_set_surface (zoom, NULL);
+}
+
+/* Unmapped icons are evicted first, least recently unmapped first,
+ * followed by the ones that are scrolled out of view, least recently
+ * drawn first. Icons that can be seen are left alone, even if that
+ * means staying over budget.
+ *
+ * Zooming only starts when an icon is drawn, so the mapped icons that
+ * are walked past are mostly the ones on the screen.
+ */
+static void
+gd_main_icon_box_icon_trim_zoomed (GdMainIconBoxIconZoom *keep)
+{
+  GList *l;
+  GList *prev;
+
+  for (l = unmapped_icons.tail; l != NULL && zoomed_size > max_zoomed_size; l = prev)
+    {
+      prev = l->prev;
+      if (l->data != keep)
+        gd_main_icon_box_icon_zoom_evict (l->data);
+    }
+
+  for (l = zoomed_icons.tail; l != NULL && zoomed_size > max_zoomed_size; l = prev)
+    {
+      GdMainIconBoxIconZoom *zoom = l->data;
+
+      prev = l->prev;
+      if (zoom == keep || gd_main_icon_box_icon_zoom_is_in_viewport (zoom))
+        continue;
+
+      gd_main_icon_box_icon_zoom_evict (zoom);
+    }
+}
+
+/* Takes ownership of @zoomed, which has to be an image surface. */
+static void
+gd_main_icon_box_icon_zoom_set_surface (GdMainIconBoxIconZoom *zoom, cairo_surface_t *zoomed)
+{
+  gsize size = 0;
+
+  if (zoomed != NULL)
+    {
+      size = (gsize) cairo_image_surface_get_stride (zoomed) * (gsize) cairo_image_surface_get_height (zoomed);
+      gd_main_icon_box_icon_account_zoomed (zoomed, size, TRUE);
+    }
+
+  if (zoom->surface_zoomed != NULL)
+    {
+      if (zoom->upload != NULL)
+        gd_main_icon_box_icon_upload_unref (g_steal_pointer (&zoom->upload));
+      else
+        gd_main_icon_box_icon_account_zoomed (zoom->surface_zoomed, zoom->surface_zoomed_size, FALSE);
+
+      g_queue_unlink (gd_main_icon_box_icon_zoom_get_queue (zoom), &zoom->link);
+      cairo_surface_destroy (zoom->surface_zoomed);
+      zoom->surface_zoomed = NULL;
+    }
 
-  return zoomed;
+  if (zoomed == NULL)
+    return;
+
+  zoom->surface_zoomed = zoomed;
+  zoom->surface_zoomed_height = cairo_image_surface_get_height (zoomed);
+  zoom->surface_zoomed_size = size;
+  zoom->surface_zoomed_width = cairo_image_surface_get_width (zoomed);
+  g_queue_push_head_link (gd_main_icon_box_icon_zoom_get_queue (zoom), &zoom->link);
+  gd_main_icon_box_icon_trim_zoomed (zoom);
+}
+
+static guint
+gd_main_icon_box_icon_upload_hash (gconstpointer key)
+{
+  const GdMainIconBoxIconUpload *upload = key;
+  guint hash;
+
+  hash = g_direct_hash (upload->icon);
+  hash = hash * 31 + g_direct_hash (upload->screen);
+  hash = hash * 31 + (guint) upload->scale_factor;
+  hash = hash * 31 + (guint) upload->height;
+  hash = hash * 31 + (guint) upload->width;
+
+  return hash;
+}
+
+static gboolean
+gd_main_icon_box_icon_upload_equal (gconstpointer a, gconstpointer b)
+{
+  const GdMainIconBoxIconUpload *upload_a = a;
+  const GdMainIconBoxIconUpload *upload_b = b;
+
+  return upload_a->icon == upload_b->icon
+         && upload_a->screen == upload_b->screen
+         && upload_a->scale_factor == upload_b->scale_factor
+         && upload_a->height == upload_b->height
+         && upload_a->width == upload_b->width;
+}
+
+static void
+gd_main_icon_box_icon_upload_unref (GdMainIconBoxIconUpload *upload)
+{
+  upload->ref_count--;
+  if (upload->ref_count > 0)
+    return;
+
+  g_hash_table_remove (uploads, upload);
+  zoomed_size -= upload->size;
+
+  cairo_surface_destroy (upload->icon);
+  cairo_surface_destroy (upload->uploaded);
+  g_slice_free (GdMainIconBoxIconUpload, upload);
+}
+
+/* Image surfaces are sent to the windowing system every time they are
+ * drawn, which adds up when scrolling through a grid of thumbnails.
+ * Once the zoomed surface has the final size, it is replaced by a copy
+ * that lives next to the window, and the zoomed surface is left to the
+ * surface cache.
+ *
+ * The copies are looked up by the icon that was zoomed, so that all the
+ * icons showing the same image, like placeholders, share one copy. It
+ * holds a reference to that icon, so that the key can't be reused by a
+ * different surface while the copy is around.
+ */
+static void
+gd_main_icon_box_icon_zoom_upload (GdMainIconBoxIconZoom *zoom)
+{
+  GdMainIconBoxIconUpload key;
+  GdMainIconBoxIconUpload *upload;
+  GdkWindow *window;
+
+  window = gtk_widget_get_window (zoom->widget);
+
+  key.icon = zoom->icon;
+  key.screen = gdk_window_get_screen (window);
+  key.scale_factor = gdk_window_get_scale_factor (window);
+  key.height = zoom->surface_zoomed_height;
+  key.width = zoom->surface_zoomed_width;
+
+  if (uploads == NULL)
+    uploads = g_hash_table_new (gd_main_icon_box_icon_upload_hash, gd_main_icon_box_icon_upload_equal);
+
+  upload = g_hash_table_lookup (uploads, &key);
+  if (upload == NULL)
+    {
+      upload = g_slice_dup (GdMainIconBoxIconUpload, &key);
+      upload->icon = cairo_surface_reference (key.icon);
+      upload->uploaded = gd_copy_image_surface_for_window (zoom->surface_zoomed, window);
+      upload->ref_count = 0;
+
+      if (cairo_surface_get_type (upload->uploaded) == CAIRO_SURFACE_TYPE_IMAGE)
+        upload->size = (gsize) cairo_image_surface_get_stride (upload->uploaded)
+                       * (gsize) cairo_image_surface_get_height (upload->uploaded);
+      else
+        upload->size = (gsize) upload->width * (gsize) upload->height * 4;
+
+      g_hash_table_add (uploads, upload);
+      zoomed_size += upload->size;
+    }
+
+  upload->ref_count++;
+
+  gd_main_icon_box_icon_account_zoomed (zoom->surface_zoomed, zoom->surface_zoomed_size, FALSE);
+  cairo_surface_destroy (zoom->surface_zoomed);
+
+  zoom->surface_zoomed = cairo_surface_reference (upload->uploaded);
+  zoom->surface_zoomed_size = upload->size;
+  zoom->upload = upload;
+
+  gd_main_icon_box_icon_trim_zoomed (zoom);
+}
+
+static void
+gd_main_icon_box_icon_zoom_cancel (GdMainIconBoxIconZoom *zoom)
+{
+  if (zoom->settle_id != 0)
+    {
+      g_source_remove (zoom->settle_id);
+      zoom->settle_id = 0;
+    }
+
+  if (zoom->cancellable == NULL)
+    return;
+
+  g_cancellable_cancel (zoom->cancellable);
+  g_clear_object (&zoom->cancellable);
+}
+
+static void
+gd_main_icon_box_icon_zoom_queue_draw (GdMainIconBoxIconZoom *zoom)
+{
+  gtk_widget_queue_draw_area (zoom->widget, zoom->area.x, zoom->area.y, zoom->area.width, zoom->area.height);
+}
+
+/* The widget is kept alive until the worker thread is done, and with
+ * it the zoom, which is only freed when the widget is finalized.
+ */
+static void
+gd_main_icon_box_icon_zoom_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GdMainIconBoxIconZoom *zoom = user_data;
+  GCancellable *cancellable;
+  GError *error = NULL;
+  GtkWidget *widget = zoom->widget;
+  cairo_surface_t *zoomed;
+
+  zoomed = gd_surface_cache_get_zoomed_finish (gd_surface_cache_get_default (), res, &error);
+
+  /* Superseded by a newer allocation, a new icon or an unmap. */
+  cancellable = g_task_get_cancellable (G_TASK (res));
+  if (g_cancellable_is_cancelled (cancellable))
+    goto out;
+
+  g_clear_object (&zoom->cancellable);
+
+  if (error != NULL)
+    {
+      g_warning ("Unable to zoom icon: %s", error->message);
+      goto out;
+    }
+
+  gd_main_icon_box_icon_zoom_set_surface (zoom, g_steal_pointer (&zoomed));
+  gd_main_icon_box_icon_zoom_queue_draw (zoom);
+
+ out:
+  g_clear_error (&error);
+  g_clear_pointer (&zoomed, cairo_surface_destroy);
+  g_object_unref (widget);
+}
+
+static void
+gd_main_icon_box_icon_zoom_start (GdMainIconBoxIconZoom *zoom)
+{
+  cairo_surface_t *zoomed;
+
+  zoomed = gd_surface_cache_lookup (gd_surface_cache_get_default (),
+                                    zoom->icon,
+                                    zoom->width_zoomed,
+                                    zoom->height_zoomed);
+  if (zoomed != NULL)
+    {
+      gd_main_icon_box_icon_zoom_set_surface (zoom, zoomed);
+      return;
+    }
+
+  g_object_ref (zoom->widget);
+
+  zoom->cancellable = g_cancellable_new ();
+  zoom->height_pending = zoom->height_zoomed;
+  zoom->width_pending = zoom->width_zoomed;
+  gd_surface_cache_get_zoomed_async (gd_surface_cache_get_default (),
+                                     zoom->icon,
+                                     zoom->width_zoomed,
+                                     zoom->height_zoomed,
+                                     zoom->cancellable,
+                                     gd_main_icon_box_icon_zoom_ready,
+                                     zoom);
+}
+
+static gboolean
+gd_main_icon_box_icon_zoom_settle_timeout (gpointer user_data)
+{
+  GdMainIconBoxIconZoom *zoom = user_data;
+
+  zoom->settle_id = 0;
+  gd_main_icon_box_icon_zoom_queue_draw (zoom);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
@@ -123,7 +477,7 @@ gd_main_icon_box_icon_get_preferred_size (GdMainIconBoxIcon *self, gint *minimum
 static void
 gd_main_icon_box_icon_notify_icon (GdMainIconBoxIcon *self)
 {
-  g_clear_pointer (&self->surface_zoomed, cairo_surface_destroy);
+  _gd_main_icon_box_icon_zoom_set_icon (self->zoom, gd_main_box_item_get_icon (self->item));
   gtk_widget_queue_resize (GTK_WIDGET (self));
 }
 
@@ -132,15 +486,7 @@ gd_main_icon_box_icon_draw (GtkWidget *widget, cairo_t *cr)
 {
   GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (widget);
 
-  if (self->surface_zoomed == NULL)
-    goto out;
-
-  cairo_save (cr);
-  cairo_set_source_surface (cr, self->surface_zoomed, self->x, self->y);
-  cairo_paint (cr);
-  cairo_restore (cr);
-
- out:
+  _gd_main_icon_box_icon_zoom_draw (self->zoom, cr);
   return GDK_EVENT_PROPAGATE;
 }
 
@@ -159,85 +505,45 @@ gd_main_icon_box_icon_get_preferred_width (GtkWidget *widget, gint *minimum, gin
 }
 
 static void
-gd_main_icon_box_icon_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+gd_main_icon_box_icon_map (GtkWidget *widget)
 {
   GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (widget);
-  cairo_surface_t *surface;
-  cairo_surface_type_t surface_type;
-  gdouble zoom;
-  gint allocation_height_scaled;
-  gint allocation_width_scaled;
-  gint height_scaled;
-  gint height_zoomed_scaled;
-  gint scale_factor;
-  gint width_scaled;
-  gint width_zoomed_scaled;
-
-  GTK_WIDGET_CLASS (gd_main_icon_box_icon_parent_class)->size_allocate (widget, allocation);
 
-  surface = gd_main_box_item_get_icon (self->item);
-  if (surface == NULL)
-    {
-      g_return_if_fail (self->surface_zoomed == NULL);
-      return;
-    }
-
-  surface_type = cairo_surface_get_type (surface);
-  g_return_if_fail (surface_type == CAIRO_SURFACE_TYPE_IMAGE);
+  _gd_main_icon_box_icon_zoom_map (self->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_icon_parent_class)->map (widget);
+}
 
-  scale_factor = gtk_widget_get_scale_factor (GTK_WIDGET (self));
+static void
+gd_main_icon_box_icon_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+  GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (widget);
+  GdkRectangle area;
 
-  allocation_height_scaled = allocation->height * scale_factor;
-  allocation_width_scaled = allocation->width * scale_factor;
+  GTK_WIDGET_CLASS (gd_main_icon_box_icon_parent_class)->size_allocate (widget, allocation);
 
-  if (self->surface_zoomed != NULL)
-    {
-      height_zoomed_scaled = cairo_image_surface_get_height (self->surface_zoomed);
-      width_zoomed_scaled = cairo_image_surface_get_width (self->surface_zoomed);
-      if (height_zoomed_scaled == allocation_height_scaled && width_zoomed_scaled == allocation_width_scaled)
-        return;
-    }
+  area.x = 0;
+  area.y = 0;
+  area.height = allocation->height;
+  area.width = allocation->width;
+  _gd_main_icon_box_icon_zoom_allocate (self->zoom, &area);
+}
 
-  height_scaled = cairo_image_surface_get_height (surface);
-  width_scaled = cairo_image_surface_get_width (surface);
+static void
+gd_main_icon_box_icon_unrealize (GtkWidget *widget)
+{
+  GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (widget);
 
-  if (height_scaled > width_scaled && allocation_height_scaled > height_scaled)
-    {
-      zoom = (gdouble) allocation_height_scaled / (gdouble) height_scaled;
-      height_zoomed_scaled = allocation_height_scaled;
-      width_zoomed_scaled = (gint) (zoom * (gdouble) width_scaled + 0.5);
-
-      if (allocation_width_scaled < width_zoomed_scaled)
-        {
-          zoom = (gdouble) allocation_width_scaled / (gdouble) width_zoomed_scaled;
-          height_zoomed_scaled = (gint) (zoom * (gdouble) height_zoomed_scaled + 0.5);
-          width_zoomed_scaled = allocation_width_scaled;
-        }
-    }
-  else if (height_scaled <= width_scaled && allocation_width_scaled > width_scaled)
-    {
-      zoom = (gdouble) allocation_width_scaled / (gdouble) width_scaled;
-      height_zoomed_scaled = (gint) (zoom * (gdouble) height_scaled + 0.5);
-      width_zoomed_scaled = allocation_width_scaled;
-
-      if (allocation_height_scaled < height_zoomed_scaled)
-        {
-          zoom = (gdouble) allocation_height_scaled / (gdouble) height_zoomed_scaled;
-          height_zoomed_scaled = allocation_height_scaled;
-          width_zoomed_scaled = (gint) (zoom * (gdouble) width_zoomed_scaled + 0.5);
-        }
-    }
-  else
-    {
-      height_zoomed_scaled = height_scaled;
-      width_zoomed_scaled = width_scaled;
-    }
+  _gd_main_icon_box_icon_zoom_unrealize (self->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_icon_parent_class)->unrealize (widget);
+}
 
-  g_clear_pointer (&self->surface_zoomed, cairo_surface_destroy);
-  self->surface_zoomed = gd_zoom_image_surface (surface, width_zoomed_scaled, height_zoomed_scaled);
+static void
+gd_main_icon_box_icon_unmap (GtkWidget *widget)
+{
+  GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (widget);
 
-  self->x = (gdouble) (allocation_width_scaled - width_zoomed_scaled) / (2.0 * (gdouble) scale_factor);
-  self->y = (gdouble) (allocation_height_scaled - height_zoomed_scaled) / (2.0 * (gdouble) scale_factor);
+  _gd_main_icon_box_icon_zoom_unmap (self->zoom);
+  GTK_WIDGET_CLASS (gd_main_icon_box_icon_parent_class)->unmap (widget);
 }
 
 static void
@@ -245,6 +551,7 @@ gd_main_icon_box_icon_dispose (GObject *obj)
 {
   GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (obj);
 
+  _gd_main_icon_box_icon_zoom_set_icon (self->zoom, NULL);
   g_clear_object (&self->item);
 
   G_OBJECT_CLASS (gd_main_icon_box_icon_parent_class)->dispose (obj);
@@ -255,7 +562,7 @@ gd_main_icon_box_icon_finalize (GObject *obj)
 {
   GdMainIconBoxIcon *self = GD_MAIN_ICON_BOX_ICON (obj);
 
-  g_clear_pointer (&self->surface_zoomed, cairo_surface_destroy);
+  _gd_main_icon_box_icon_zoom_free (self->zoom);
 
   G_OBJECT_CLASS (gd_main_icon_box_icon_parent_class)->finalize (obj);
 }
@@ -295,6 +602,7 @@ gd_main_icon_box_icon_set_property (GObject *object, guint property_id, const GV
 static void
 gd_main_icon_box_icon_init (GdMainIconBoxIcon *self)
 {
+  self->zoom = _gd_main_icon_box_icon_zoom_new (GTK_WIDGET (self));
 }
 
 static void
@@ -310,7 +618,10 @@ gd_main_icon_box_icon_class_init (GdMainIconBoxIconClass *klass)
   wclass->draw = gd_main_icon_box_icon_draw;
   wclass->get_preferred_height = gd_main_icon_box_icon_get_preferred_height;
   wclass->get_preferred_width = gd_main_icon_box_icon_get_preferred_width;
+  wclass->map = gd_main_icon_box_icon_map;
   wclass->size_allocate = gd_main_icon_box_icon_size_allocate;
+  wclass->unmap = gd_main_icon_box_icon_unmap;
+  wclass->unrealize = gd_main_icon_box_icon_unrealize;
 
   properties[PROP_ITEM] = g_param_spec_object ("item",
                                                "Item",
@@ -349,8 +660,8 @@ gd_main_icon_box_icon_set_item (GdMainIconBoxIcon *self, GdMainBoxItem *item)
   if (self->item != NULL)
     g_signal_handlers_disconnect_by_func (self->item, gd_main_icon_box_icon_notify_icon, self);
 
-  g_clear_pointer (&self->surface_zoomed, cairo_surface_destroy);
   g_set_object (&self->item, item);
+  _gd_main_icon_box_icon_zoom_set_icon (self->zoom, self->item != NULL ? gd_main_box_item_get_icon (self->item) : NULL);
 
   if (self->item != NULL)
     {
@@ -364,3 +675,255 @@ gd_main_icon_box_icon_set_item (GdMainIconBoxIcon *self, GdMainBoxItem *item)
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_ITEM]);
   gtk_widget_queue_resize (GTK_WIDGET (self));
 }
+
+/**
+ * gd_main_icon_box_icon_get_max_zoomed_size:
+ *
+ * Returns: The number of bytes that all the #GdMainIconBoxIcon
+ * instances and flat #GdMainIconBoxChild instances together try to keep
+ * their zoomed surfaces under.
+ */
+gsize
+gd_main_icon_box_icon_get_max_zoomed_size (void)
+{
+  return max_zoomed_size;
+}
+
+/**
+ * gd_main_icon_box_icon_get_zoomed_size:
+ *
+ * Returns: The number of bytes currently held in zoomed surfaces by
+ * all the #GdMainIconBoxIcon instances and flat #GdMainIconBoxChild
+ * instances.
+ */
+gsize
+gd_main_icon_box_icon_get_zoomed_size (void)
+{
+  return zoomed_size;
+}
+
+/**
+ * gd_main_icon_box_icon_set_max_zoomed_size:
+ * @max_size: the budget in bytes
+ *
+ * Sets the number of bytes that all the #GdMainIconBoxIcon instances
+ * and flat #GdMainIconBoxChild instances together try to keep their
+ * zoomed surfaces under. Once over, the surfaces of icons that can't be
+ * seen are dropped, and recreated when the icons are shown again.
+ */
+void
+gd_main_icon_box_icon_set_max_zoomed_size (gsize max_size)
+{
+  max_zoomed_size = max_size;
+  gd_main_icon_box_icon_trim_zoomed (NULL);
+}
+
+/* Has to be freed from the finalize of @widget, because pending zooms
+ * only keep @widget alive.
+ */
+GdMainIconBoxIconZoom *
+_gd_main_icon_box_icon_zoom_new (GtkWidget *widget)
+{
+  GdMainIconBoxIconZoom *zoom;
+
+  zoom = g_slice_new0 (GdMainIconBoxIconZoom);
+  zoom->link.data = zoom;
+  zoom->widget = widget;
+
+  return zoom;
+}
+
+void
+_gd_main_icon_box_icon_zoom_free (GdMainIconBoxIconZoom *zoom)
+{
+  _gd_main_icon_box_icon_zoom_set_icon (zoom, NULL);
+  g_slice_free (GdMainIconBoxIconZoom, zoom);
+}
+
+void
+_gd_main_icon_box_icon_zoom_set_icon (GdMainIconBoxIconZoom *zoom, cairo_surface_t *icon)
+{
+  g_return_if_fail (icon == NULL || cairo_surface_get_type (icon) == CAIRO_SURFACE_TYPE_IMAGE);
+
+  /* Recycled children are often rebound to items with the same
+   * placeholder.
+   */
+  if (zoom->icon == icon)
+    return;
+
+  gd_main_icon_box_icon_zoom_cancel (zoom);
+  gd_main_icon_box_icon_zoom_set_surface (zoom, NULL);
+
+  if (icon != NULL)
+    cairo_surface_reference (icon);
+
+  g_clear_pointer (&zoom->icon, cairo_surface_destroy);
+  zoom->icon = icon;
+
+  if (zoom->icon != NULL)
+    _gd_main_icon_box_icon_zoom_allocate (zoom, &zoom->area);
+}
+
+/* Resampling is done in a worker thread, and only started when the
+ * icon is drawn, so that icons which are mapped but scrolled out of
+ * view cost nothing. Until it is done, whatever there is at hand, the
+ * previous zoomed surface or the icon itself, is scaled when drawing.
+ *
+ * While the window is being resized, the allocation changes on every
+ * frame, so once there is a zoomed surface to scale, resampling waits
+ * for the allocation to settle.
+ */
+void
+_gd_main_icon_box_icon_zoom_allocate (GdMainIconBoxIconZoom *zoom, const GdkRectangle *area)
+{
+  cairo_surface_t *zoomed;
+  gint height_scaled;
+  gint scale_factor;
+  gint width_scaled;
+
+  zoom->area = *area;
+
+  if (zoom->icon == NULL || area->height <= 0 || area->width <= 0)
+    return;
+
+  scale_factor = gtk_widget_get_scale_factor (zoom->widget);
+
+  height_scaled = cairo_image_surface_get_height (zoom->icon);
+  width_scaled = cairo_image_surface_get_width (zoom->icon);
+  gd_zoom_image_size_to_fit (width_scaled,
+                             height_scaled,
+                             area->width * scale_factor,
+                             area->height * scale_factor,
+                             &zoom->width_zoomed,
+                             &zoom->height_zoomed);
+
+  zoom->x = (gdouble) (area->width * scale_factor - zoom->width_zoomed) / (2.0 * (gdouble) scale_factor);
+  zoom->y = (gdouble) (area->height * scale_factor - zoom->height_zoomed) / (2.0 * (gdouble) scale_factor);
+
+  if (zoom->surface_zoomed != NULL
+      && zoom->surface_zoomed_height == zoom->height_zoomed
+      && zoom->surface_zoomed_width == zoom->width_zoomed)
+    {
+      gd_main_icon_box_icon_zoom_cancel (zoom);
+      return;
+    }
+
+  if ((zoom->cancellable != NULL || zoom->settle_id != 0)
+      && zoom->height_pending == zoom->height_zoomed
+      && zoom->width_pending == zoom->width_zoomed)
+    return;
+
+  gd_main_icon_box_icon_zoom_cancel (zoom);
+
+  zoomed = gd_surface_cache_lookup (gd_surface_cache_get_default (),
+                                    zoom->icon,
+                                    zoom->width_zoomed,
+                                    zoom->height_zoomed);
+  if (zoomed != NULL)
+    {
+      gd_main_icon_box_icon_zoom_set_surface (zoom, zoomed);
+      return;
+    }
+
+  /* Started once drawn. */
+  if (zoom->surface_zoomed == NULL || !gtk_widget_get_mapped (zoom->widget))
+    return;
+
+  zoom->height_pending = zoom->height_zoomed;
+  zoom->width_pending = zoom->width_zoomed;
+  zoom->settle_id = g_timeout_add (MAIN_ICON_BOX_ICON_SETTLE_TIMEOUT, gd_main_icon_box_icon_zoom_settle_timeout, zoom);
+}
+
+void
+_gd_main_icon_box_icon_zoom_draw (GdMainIconBoxIconZoom *zoom, cairo_t *cr)
+{
+  cairo_surface_t *surface;
+  gint height;
+  gint width;
+
+  if (zoom->icon == NULL || zoom->height_zoomed <= 0 || zoom->width_zoomed <= 0)
+    return;
+
+  /* Not zoomed yet, evicted while out of view, or settled. */
+  if (zoom->cancellable == NULL
+      && zoom->settle_id == 0
+      && (zoom->surface_zoomed == NULL
+          || zoom->surface_zoomed_height != zoom->height_zoomed
+          || zoom->surface_zoomed_width != zoom->width_zoomed))
+    gd_main_icon_box_icon_zoom_start (zoom);
+
+  if (zoom->surface_zoomed != NULL)
+    {
+      g_queue_unlink (&zoomed_icons, &zoom->link);
+      g_queue_push_head_link (&zoomed_icons, &zoom->link);
+
+      if (zoom->upload == NULL
+          && zoom->surface_zoomed_height == zoom->height_zoomed
+          && zoom->surface_zoomed_width == zoom->width_zoomed)
+        gd_main_icon_box_icon_zoom_upload (zoom);
+
+      surface = zoom->surface_zoomed;
+      height = zoom->surface_zoomed_height;
+      width = zoom->surface_zoomed_width;
+    }
+  else
+    {
+      surface = zoom->icon;
+      height = cairo_image_surface_get_height (surface);
+      width = cairo_image_surface_get_width (surface);
+    }
+
+  cairo_save (cr);
+  cairo_translate (cr, zoom->area.x + zoom->x, zoom->area.y + zoom->y);
+
+  if (height != zoom->height_zoomed || width != zoom->width_zoomed)
+    {
+      cairo_scale (cr, (gdouble) zoom->width_zoomed / (gdouble) width, (gdouble) zoom->height_zoomed / (gdouble) height);
+      cairo_set_source_surface (cr, surface, 0, 0);
+      cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_PAD);
+
+      /* The transform is only temporary, so keep it cheap. */
+      if (zoom->settle_id != 0)
+        cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_BILINEAR);
+    }
+  else
+    {
+      cairo_set_source_surface (cr, surface, 0, 0);
+    }
+
+  cairo_paint (cr);
+  cairo_restore (cr);
+}
+
+/* Called before chaining up, while the widget is still unmapped. */
+void
+_gd_main_icon_box_icon_zoom_map (GdMainIconBoxIconZoom *zoom)
+{
+  /* Not drawn yet, so the first to go among the mapped icons. */
+  if (zoom->surface_zoomed != NULL)
+    {
+      g_queue_unlink (&unmapped_icons, &zoom->link);
+      g_queue_push_tail_link (&zoomed_icons, &zoom->link);
+    }
+}
+
+/* Called before chaining up, while the widget is still mapped. */
+void
+_gd_main_icon_box_icon_zoom_unmap (GdMainIconBoxIconZoom *zoom)
+{
+  gd_main_icon_box_icon_zoom_cancel (zoom);
+
+  if (zoom->surface_zoomed != NULL)
+    {
+      g_queue_unlink (&zoomed_icons, &zoom->link);
+      g_queue_push_head_link (&unmapped_icons, &zoom->link);
+    }
+}
+
+void
+_gd_main_icon_box_icon_zoom_unrealize (GdMainIconBoxIconZoom *zoom)
+{
+  /* The uploaded copy was made for the screen of the window. */
+  if (zoom->upload != NULL)
+    gd_main_icon_box_icon_zoom_set_surface (zoom, NULL);
+}
@@ -35,6 +35,22 @@ GtkWidget        * gd_main_icon_box_icon_new          (GdMainBoxItem *item);
 GdMainBoxItem    * gd_main_icon_box_icon_get_item     (GdMainIconBoxIcon *self);
 void               gd_main_icon_box_icon_set_item     (GdMainIconBoxIcon *self, GdMainBoxItem *item);
 
+gsize              gd_main_icon_box_icon_get_max_zoomed_size  (void);
+gsize              gd_main_icon_box_icon_get_zoomed_size      (void);
+void               gd_main_icon_box_icon_set_max_zoomed_size  (gsize max_size);
+
+/* private */
+typedef struct _GdMainIconBoxIconZoom GdMainIconBoxIconZoom;
+
+GdMainIconBoxIconZoom * _gd_main_icon_box_icon_zoom_new        (GtkWidget *widget);
+void                    _gd_main_icon_box_icon_zoom_free       (GdMainIconBoxIconZoom *zoom);
+void                    _gd_main_icon_box_icon_zoom_set_icon   (GdMainIconBoxIconZoom *zoom, cairo_surface_t *icon);
+void                    _gd_main_icon_box_icon_zoom_allocate   (GdMainIconBoxIconZoom *zoom, const GdkRectangle *area);
+void                    _gd_main_icon_box_icon_zoom_draw       (GdMainIconBoxIconZoom *zoom, cairo_t *cr);
+void                    _gd_main_icon_box_icon_zoom_map        (GdMainIconBoxIconZoom *zoom);
+void                    _gd_main_icon_box_icon_zoom_unmap      (GdMainIconBoxIconZoom *zoom);
+void                    _gd_main_icon_box_icon_zoom_unrealize  (GdMainIconBoxIconZoom *zoom);
+
 G_END_DECLS
 
 #endif /* __GD_MAIN_ICON_BOX_ICON_H__ */
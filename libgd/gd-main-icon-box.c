@@ -25,66 +25,1024 @@
 #include <gio/gio.h>
 
 #include "gd-icon-utils.h"
+#include "gd-index-set.h"
 #include "gd-main-icon-box.h"
 #include "gd-main-icon-box-child.h"
 #include "gd-main-box-child.h"
 #include "gd-main-box-generic.h"
 #include "gd-main-box-item.h"
 
+#define MAIN_ICON_BOX_CHECK_BUTTON_GRACE 10
 #define MAIN_ICON_BOX_DND_ICON_OFFSET 20
+#define MAIN_ICON_BOX_INITIAL_WINDOW 64
+#define MAIN_ICON_BOX_MAX_PENDING_CHANGES 32
+#define MAIN_ICON_BOX_MAX_POOLED_CHILDREN 512
+#define MAIN_ICON_BOX_MAX_VIRTUAL_SPLICE 64
+#define MAIN_ICON_BOX_POPULATION_BATCH 8
+#define MAIN_ICON_BOX_SPINNER_PERIOD G_USEC_PER_SEC
 
 typedef struct _GdMainIconBoxPrivate GdMainIconBoxPrivate;
+typedef struct _GdMainIconBoxSplice GdMainIconBoxSplice;
 
 struct _GdMainIconBoxPrivate
 {
+  GArray *pending_changes;
+  GHashTable *pulsing_children;
+  GHashTable *selected_ids;
+  GdIndexSet *selection;
   GListModel *model;
+  GPtrArray *child_pool;
+  GtkAdjustment *vadjustment;
+  gboolean coalesce_updates;
   gboolean dnd_started;
+  gboolean flat_children;
+  gboolean incremental_population;
   gboolean key_pressed;
   gboolean key_shift_pressed;
   gboolean left_button_released;
   gboolean left_button_shift_released;
+  gboolean populating;
+  gboolean preserve_selection;
+  gboolean restoring_selection;
   gboolean selection_changed;
   gboolean selection_mode;
   gboolean show_primary_text;
   gboolean show_secondary_text;
+  gboolean updating_window;
+  gboolean virtualized;
   gchar *last_selected_id;
   gdouble dnd_start_x;
   gdouble dnd_start_y;
+  gdouble population_progress;
+  gdouble spinner_angle;
   gint dnd_button;
+  gint row_stride;
+  gint slice_offset;
+  guint n_columns;
+  guint n_pool_hits;
+  guint n_pool_misses;
+  guint overscan;
+  guint release_check_buttons_id;
+  guint spinner_tick_id;
+  guint tick_id;
+  guint update_window_id;
+  guint window_end;
+  guint window_start;
+};
+
+struct _GdMainIconBoxSplice
+{
+  guint position;
+  guint removed;
+  guint added;
 };
 
 enum
 {
-  PROP_LAST_SELECTED_ID = 1,
-  PROP_MODEL,
-  PROP_SELECTION_MODE,
-  PROP_SHOW_PRIMARY_TEXT,
-  PROP_SHOW_SECONDARY_TEXT,
-  NUM_PROPERTIES
-};
+  PROP_LAST_SELECTED_ID = 1,
+  PROP_MODEL,
+  PROP_SELECTION_MODE,
+  PROP_SHOW_PRIMARY_TEXT,
+  PROP_SHOW_SECONDARY_TEXT,
+  PROP_COALESCE_UPDATES,
+  PROP_PRESERVE_SELECTION,
+  PROP_VIRTUALIZED,
+  PROP_OVERSCAN,
+  PROP_INCREMENTAL_POPULATION,
+  PROP_POPULATION_PROGRESS,
+  PROP_FLAT_CHILDREN,
+  NUM_PROPERTIES
+};
+
+enum
+{
+  POPULATION_COMPLETE,
+  NUM_SIGNALS
+};
+
+static guint signals[NUM_SIGNALS] = { 0, };
+
+static void gd_main_box_generic_interface_init (GdMainBoxGenericInterface *iface);
+static void gd_main_icon_box_flush_pending_changes (GdMainIconBox *self);
+G_DEFINE_TYPE_WITH_CODE (GdMainIconBox, gd_main_icon_box, GTK_TYPE_FLOW_BOX,
+                         G_ADD_PRIVATE (GdMainIconBox)
+                         G_IMPLEMENT_INTERFACE (GD_TYPE_MAIN_BOX_GENERIC, gd_main_box_generic_interface_init))
+
+GtkWidget *
+gd_main_icon_box_create_widget_func (gpointer item, gpointer user_data)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (user_data);
+  GdMainIconBoxPrivate *priv;
+  GtkWidget *child;
+
+  g_return_val_if_fail (GD_IS_MAIN_BOX_ITEM (item), NULL);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  child = g_object_new (GD_TYPE_MAIN_ICON_BOX_CHILD,
+                        "flat", priv->flat_children,
+                        "item", item,
+                        "selection-mode", priv->selection_mode,
+                        NULL);
+  g_object_bind_property (self, "flat-children", child, "flat", G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self, "show-primary-text", child, "show-primary-text", G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self, "show-secondary-text", child, "show-secondary-text", G_BINDING_SYNC_CREATE);
+  gtk_widget_show_all (child);
+
+  return child;
+}
+
+static GtkWidget *
+gd_main_icon_box_get_pooled_child (GdMainIconBox *self, GdMainBoxItem *item)
+{
+  GdMainIconBoxPrivate *priv;
+  GtkWidget *child;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->child_pool->len == 0)
+    {
+      priv->n_pool_misses++;
+      child = g_object_ref_sink (gd_main_icon_box_create_widget_func (item, self));
+      goto out;
+    }
+
+  priv->n_pool_hits++;
+
+  /* The bindings to our show-primary-text and show-secondary-text
+   * survive in the pool, but the selection mode might have changed
+   * in the mean time.
+   */
+  child = GTK_WIDGET (g_ptr_array_steal_index_fast (priv->child_pool, priv->child_pool->len - 1));
+  gd_main_icon_box_child_set_item (GD_MAIN_ICON_BOX_CHILD (child), item);
+  g_object_set (child, "selection-mode", priv->selection_mode, NULL);
+
+ out:
+  return child;
+}
+
+static void
+gd_main_icon_box_recycle_child (GdMainIconBox *self, GtkFlowBoxChild *child)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->child_pool->len >= MAIN_ICON_BOX_MAX_POOLED_CHILDREN)
+    {
+      gtk_widget_destroy (GTK_WIDGET (child));
+      return;
+    }
+
+  /* GtkFlowBox doesn't reset the selected state of a child when it is
+   * removed, so a reused child would come back selected.
+   */
+  if (gtk_flow_box_child_is_selected (child))
+    gtk_flow_box_unselect_child (GTK_FLOW_BOX (self), child);
+
+  g_ptr_array_add (priv->child_pool, g_object_ref (child));
+  gtk_container_remove (GTK_CONTAINER (self), GTK_WIDGET (child));
+
+  gtk_widget_unset_state_flags (GTK_WIDGET (child), GTK_STATE_FLAG_ACTIVE | GTK_STATE_FLAG_PRELIGHT);
+  gd_main_icon_box_child_set_item (GD_MAIN_ICON_BOX_CHILD (child), NULL);
+}
+
+static void
+gd_main_icon_box_insert_items (GdMainIconBox *self, guint position, guint n_items, gint index)
+{
+  GdMainIconBoxPrivate *priv;
+  gboolean updating_window;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* Restoring the selection of an item that scrolled back into view
+   * is not a change that anybody needs to be notified about.
+   */
+  updating_window = priv->updating_window;
+  priv->updating_window = TRUE;
+
+  for (i = 0; i < n_items; i++)
+    {
+      GdMainBoxItem *item;
+      GtkWidget *child;
+
+      item = GD_MAIN_BOX_ITEM (g_list_model_get_object (priv->model, position + i));
+      child = gd_main_icon_box_get_pooled_child (self, item);
+      gtk_flow_box_insert (GTK_FLOW_BOX (self), child, index < 0 ? -1 : index + (gint) i);
+
+      if (gd_index_set_contains (priv->selection, position + i))
+        gtk_flow_box_select_child (GTK_FLOW_BOX (self), GTK_FLOW_BOX_CHILD (child));
+
+      g_object_unref (child);
+      g_object_unref (item);
+    }
+
+  priv->updating_window = updating_window;
+}
+
+static void
+gd_main_icon_box_remove_children (GdMainIconBox *self, gint index, guint n_children)
+{
+  GdMainIconBoxPrivate *priv;
+  gboolean updating_window;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* The selection lives in priv->selection, so it survives the
+   * children. Whoever removes selected items takes care of that.
+   */
+  updating_window = priv->updating_window;
+  priv->updating_window = TRUE;
+
+  for (i = 0; i < n_children; i++)
+    {
+      GtkFlowBoxChild *child;
+
+      child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (self), index);
+      if (child == NULL)
+        break;
+
+      gd_main_icon_box_recycle_child (self, child);
+    }
+
+  priv->updating_window = updating_window;
+}
+
+static void
+gd_main_icon_box_set_window (GdMainIconBox *self, guint start, guint end)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->window_start == start && priv->window_end == end)
+    return;
+
+  if (start >= priv->window_end || end <= priv->window_start)
+    {
+      gd_main_icon_box_remove_children (self, 0, priv->window_end - priv->window_start);
+      priv->window_start = start;
+      priv->window_end = start;
+    }
+  else
+    {
+      if (priv->window_end > end)
+        {
+          gd_main_icon_box_remove_children (self, (gint) (end - priv->window_start), priv->window_end - end);
+          priv->window_end = end;
+        }
+
+      if (priv->window_start < start)
+        {
+          gd_main_icon_box_remove_children (self, 0, start - priv->window_start);
+          priv->window_start = start;
+        }
+    }
+
+  if (priv->window_start > start)
+    {
+      gd_main_icon_box_insert_items (self, start, priv->window_start - start, 0);
+      priv->window_start = start;
+    }
+
+  if (priv->window_end < end)
+    {
+      gd_main_icon_box_insert_items (self, priv->window_end, end - priv->window_end, -1);
+      priv->window_end = end;
+    }
+}
+
+static gboolean
+gd_main_icon_box_measure_rows (GdMainIconBox *self, gint width, guint *out_n_columns, gint *out_row_stride)
+{
+  GtkFlowBox *flow_box = GTK_FLOW_BOX (self);
+  GList *children;
+  GList *l;
+  gboolean ret_val = FALSE;
+  gint column_spacing;
+  gint item_height = 0;
+  gint item_width;
+  gint nat_item_width = 0;
+  guint max_columns;
+  guint min_columns;
+  guint n_columns;
+
+  /* This mirrors the way a homogeneous GtkFlowBox lays out its
+   * children, so that the virtual rows line up with the real ones.
+   */
+
+  children = gtk_container_get_children (GTK_CONTAINER (self));
+  if (children == NULL)
+    goto out;
+
+  for (l = children; l != NULL; l = l->next)
+    {
+      gint nat_width;
+
+      gtk_widget_get_preferred_width (GTK_WIDGET (l->data), NULL, &nat_width);
+      nat_item_width = MAX (nat_item_width, nat_width);
+    }
+
+  if (nat_item_width <= 0)
+    goto out;
+
+  column_spacing = (gint) gtk_flow_box_get_column_spacing (flow_box);
+  min_columns = MAX (gtk_flow_box_get_min_children_per_line (flow_box), 1);
+  max_columns = gtk_flow_box_get_max_children_per_line (flow_box);
+
+  n_columns = (guint) MAX (width / (nat_item_width + column_spacing), 0);
+  if ((gint) n_columns * column_spacing + ((gint) n_columns + 1) * nat_item_width <= width)
+    n_columns++;
+
+  n_columns = MAX (n_columns, min_columns);
+  n_columns = MIN (n_columns, max_columns);
+
+  item_width = (width - ((gint) n_columns - 1) * column_spacing) / (gint) n_columns;
+  if (gtk_widget_get_halign (GTK_WIDGET (self)) != GTK_ALIGN_FILL)
+    item_width = MIN (item_width, nat_item_width);
+
+  for (l = children; l != NULL; l = l->next)
+    {
+      gint nat_height;
+
+      gtk_widget_get_preferred_height_for_width (GTK_WIDGET (l->data), item_width, NULL, &nat_height);
+      item_height = MAX (item_height, nat_height);
+    }
+
+  *out_n_columns = n_columns;
+  *out_row_stride = item_height + (gint) gtk_flow_box_get_row_spacing (flow_box);
+  ret_val = TRUE;
+
+ out:
+  g_list_free (children);
+  return ret_val;
+}
+
+static void
+gd_main_icon_box_get_wanted_window (GdMainIconBox *self, guint *out_start, guint *out_end)
+{
+  GdMainIconBoxPrivate *priv;
+  GtkWidget *scrolled_window;
+  GtkWidget *viewport;
+  gint bottom;
+  gint top;
+  gint x;
+  gint y;
+  guint first_row;
+  guint last_row;
+  guint n_items;
+  guint start;
+  guint end;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  n_items = priv->model != NULL ? g_list_model_get_n_items (priv->model) : 0;
+  start = 0;
+  end = n_items;
+
+  if (!priv->virtualized)
+    goto out;
+
+  /* Without a GtkScrolledWindow around us, every child is going to
+   * be visible anyway.
+   */
+  scrolled_window = gtk_widget_get_ancestor (GTK_WIDGET (self), GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled_window == NULL)
+    goto out;
+
+  end = MIN (n_items, MAIN_ICON_BOX_INITIAL_WINDOW);
+
+  if (priv->n_columns == 0 || priv->row_stride <= 0)
+    goto out;
+
+  viewport = gtk_bin_get_child (GTK_BIN (scrolled_window));
+  if (viewport == NULL)
+    goto out;
+
+  if (!gtk_widget_translate_coordinates (GTK_WIDGET (self), viewport, 0, 0, &x, &y))
+    goto out;
+
+  /* Our allocation only covers the materialized rows, which start
+   * slice_offset pixels below the top of the first virtual row.
+   */
+  top = MAX (priv->slice_offset - y, 0);
+  bottom = MAX (top + gtk_widget_get_allocated_height (viewport), top);
+
+  first_row = (guint) (top / priv->row_stride);
+  last_row = (guint) (bottom / priv->row_stride) + 1;
+
+  first_row = first_row > priv->overscan ? first_row - priv->overscan : 0;
+  last_row += priv->overscan;
+
+  start = MIN (first_row * priv->n_columns, n_items / priv->n_columns * priv->n_columns);
+  end = MIN (last_row * priv->n_columns, n_items);
+  end = MAX (start, end);
+
+ out:
+  *out_start = start;
+  *out_end = end;
+}
+
+static void
+gd_main_icon_box_update_window (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+  guint end;
+  guint start;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* The population tick takes care of moving the window. */
+  if (priv->model == NULL || priv->populating)
+    return;
+
+  gd_main_icon_box_flush_pending_changes (self);
+
+  gd_main_icon_box_get_wanted_window (self, &start, &end);
+  gd_main_icon_box_set_window (self, start, end);
+}
+
+static void
+gd_main_icon_box_set_population_progress (GdMainIconBox *self, gdouble population_progress)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->population_progress == population_progress)
+    return;
+
+  priv->population_progress = population_progress;
+  g_object_notify (G_OBJECT (self), "population-progress");
+}
+
+static gboolean
+gd_main_icon_box_population_step (GdMainIconBox *self, gint64 deadline)
+{
+  GdMainIconBoxPrivate *priv;
+  gdouble population_progress;
+  guint end;
+  guint start;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  gd_main_icon_box_get_wanted_window (self, &start, &end);
+
+  do
+    {
+      guint window_end;
+
+      window_end = MIN (end, MAX (priv->window_end, start) + MAIN_ICON_BOX_POPULATION_BATCH);
+      gd_main_icon_box_set_window (self, start, window_end);
+    }
+  while (priv->window_end < end && g_get_monotonic_time () < deadline);
+
+  if (priv->window_end >= end)
+    {
+      gd_main_icon_box_set_population_progress (self, 1.0);
+      return FALSE;
+    }
+
+  population_progress = (gdouble) (priv->window_end - start) / (gdouble) (end - start);
+  gd_main_icon_box_set_population_progress (self, population_progress);
+  return TRUE;
+}
+
+static gboolean
+gd_main_icon_box_update_window_idle (gpointer user_data)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (user_data);
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  priv->update_window_id = 0;
+  gd_main_icon_box_update_window (self);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gd_main_icon_box_queue_update_window (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (!priv->virtualized || priv->update_window_id != 0)
+    return;
+
+  /* Run before the next frame is laid out and painted. */
+  priv->update_window_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                            gd_main_icon_box_update_window_idle,
+                                            self,
+                                            NULL);
+}
+
+static void
+gd_main_icon_box_restore_selected_ids (GdMainIconBox *self, guint position, guint n_items)
+{
+  GdMainIconBoxPrivate *priv;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (!priv->preserve_selection || !priv->selection_mode || g_hash_table_size (priv->selected_ids) == 0)
+    return;
+
+  for (i = position; i < position + n_items; i++)
+    {
+      GdMainBoxItem *item;
+      const gchar *id;
+
+      item = GD_MAIN_BOX_ITEM (g_list_model_get_object (priv->model, i));
+      id = gd_main_box_item_get_id (item);
+      if (id != NULL && g_hash_table_contains (priv->selected_ids, id))
+        gd_index_set_add (priv->selection, i);
+
+      g_object_unref (item);
+    }
+}
+
+/* The IDs are only saved for the selected items that are about to go
+ * away, when the model is replaced or items are removed, and are read
+ * from the ID index because the model may no longer have the items.
+ * The selection has to be in sync with the index.
+ */
+static void
+gd_main_icon_box_save_selected_ids (GdMainIconBox *self, guint position, guint n_items)
+{
+  GdMainIconBoxPrivate *priv;
+  gboolean found;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (!priv->preserve_selection || n_items == 0)
+    return;
+
+  i = position;
+  found = gd_index_set_contains (priv->selection, i) || gd_index_set_get_next (priv->selection, i, &i);
+  while (found && i < position + n_items)
+    {
+      const gchar *id;
+
+      id = _gd_main_box_generic_get_id_at (GD_MAIN_BOX_GENERIC (self), i);
+      if (id != NULL && !g_hash_table_contains (priv->selected_ids, id))
+        g_hash_table_add (priv->selected_ids, g_strdup (id));
+
+      found = gd_index_set_get_next (priv->selection, i, &i);
+    }
+}
+
+/* Changes that the user makes replace whatever was saved. */
+static void
+gd_main_icon_box_forget_selected_ids (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->restoring_selection)
+    return;
+
+  g_hash_table_remove_all (priv->selected_ids);
+}
+
+static void
+gd_main_icon_box_apply_splice (GdMainIconBox *self, guint position, guint removed, guint added)
+{
+  GdMainIconBoxPrivate *priv;
+  guint first;
+  guint last;
+  guint n_remaining;
+  guint n_selected;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  n_selected = gd_index_set_get_size (priv->selection);
+  gd_index_set_splice (priv->selection, position, removed, added);
+  gd_main_icon_box_restore_selected_ids (self, position, added);
+
+  if (!priv->virtualized && !priv->populating)
+    {
+      gd_main_icon_box_remove_children (self, (gint) position, removed);
+      gd_main_icon_box_insert_items (self, position, added, (gint) position);
+      priv->window_end = priv->window_end - removed + added;
+      goto selection;
+    }
+
+  if (position >= priv->window_end)
+    goto out;
+
+  if (position + removed <= priv->window_start)
+    {
+      priv->window_start = priv->window_start - removed + added;
+      priv->window_end = priv->window_end - removed + added;
+      goto out;
+    }
+
+  /* Drop the children whose items are really gone. */
+  first = MAX (position, priv->window_start);
+  last = MIN (position + removed, priv->window_end);
+  gd_main_icon_box_remove_children (self, (gint) (first - priv->window_start), last - first);
+  priv->window_end -= last - first;
+
+  if (position < priv->window_start)
+    {
+      n_remaining = priv->window_end - priv->window_start;
+      priv->window_start = position + added;
+      priv->window_end = priv->window_start + n_remaining;
+    }
+  else if (added > MAIN_ICON_BOX_MAX_VIRTUAL_SPLICE)
+    {
+      /* Don't build a large number of children that might well end
+       * up outside the viewport. Let the window grow back instead.
+       */
+      gd_main_icon_box_remove_children (self,
+                                        (gint) (position - priv->window_start),
+                                        priv->window_end - position);
+      priv->window_end = position;
+    }
+  else
+    {
+      gd_main_icon_box_insert_items (self, position, added, (gint) (position - priv->window_start));
+      priv->window_end += added;
+    }
+
+ out:
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+  gd_main_icon_box_queue_update_window (self);
+
+ selection:
+  if (gd_index_set_get_size (priv->selection) != n_selected)
+    {
+      /* Removed items keep their IDs, in case they come back. */
+      priv->restoring_selection = TRUE;
+      g_signal_emit_by_name (self, "selection-changed");
+      priv->restoring_selection = FALSE;
+    }
+}
+
+static void
+gd_main_icon_box_flush_pending_changes (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+  gint delta = 0;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->pending_changes->len == 0)
+    return;
+
+  /* The pending changes are sorted and don't overlap. Applying them
+   * from the front keeps every position in sync with the model.
+   */
+  for (i = 0; i < priv->pending_changes->len; i++)
+    {
+      GdMainIconBoxSplice *splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, i);
+
+      gd_main_icon_box_apply_splice (self, (guint) ((gint) splice->position + delta), splice->removed, splice->added);
+      delta += (gint) splice->added - (gint) splice->removed;
+    }
+
+  g_array_set_size (priv->pending_changes, 0);
+}
+
+static void
+gd_main_icon_box_add_pending_change (GdMainIconBox *self, guint position, guint removed, guint added)
+{
+  GdMainIconBoxPrivate *priv;
+  GdMainIconBoxSplice merged;
+  gint delta = 0;
+  gint delta_first = 0;
+  gint first = -1;
+  gint last = -1;
+  guint end;
+  guint i;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* position, removed and added refer to the model after the pending
+   * changes, while the pending changes themselves refer to the
+   * children we have. Find the pending changes that overlap with or
+   * touch the new one.
+   */
+  for (i = 0; i < priv->pending_changes->len; i++)
+    {
+      GdMainIconBoxSplice *splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, i);
+      guint splice_start;
+      guint splice_end;
+
+      splice_start = (guint) ((gint) splice->position + delta);
+      splice_end = splice_start + splice->added;
+
+      if (splice_start > position + removed)
+        break;
+
+      if (splice_end >= position)
+        {
+          if (first == -1)
+            {
+              first = (gint) i;
+              delta_first = delta;
+            }
+
+          last = (gint) i;
+        }
+      else
+        {
+          delta_first = delta + (gint) splice->added - (gint) splice->removed;
+        }
+
+      delta += (gint) splice->added - (gint) splice->removed;
+    }
+
+  if (first == -1)
+    {
+      merged.position = (guint) ((gint) position - delta_first);
+      merged.removed = removed;
+      merged.added = added;
+      g_array_insert_val (priv->pending_changes, i, merged);
+    }
+  else
+    {
+      GdMainIconBoxSplice *first_splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, first);
+      GdMainIconBoxSplice *last_splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, last);
+      guint start;
+
+      start = MIN (position, (guint) ((gint) first_splice->position + delta_first));
+      end = MAX (position + removed, (guint) ((gint) (last_splice->position + last_splice->removed) + delta));
+
+      merged.position = (guint) ((gint) start - delta_first);
+      merged.removed = (guint) ((gint) end - delta) - merged.position;
+      merged.added = end - removed + added - start;
+
+      g_array_remove_range (priv->pending_changes, (guint) first, (guint) (last - first + 1));
+      g_array_insert_val (priv->pending_changes, (guint) first, merged);
+    }
+
+  /* Too many scattered changes. Treat everything between the first
+   * and the last one as changed.
+   */
+  if (priv->pending_changes->len > MAIN_ICON_BOX_MAX_PENDING_CHANGES)
+    {
+      GdMainIconBoxSplice *first_splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, 0);
+      GdMainIconBoxSplice *last_splice;
+
+      last_splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, priv->pending_changes->len - 1);
+
+      delta = 0;
+      for (i = 0; i < priv->pending_changes->len; i++)
+        {
+          GdMainIconBoxSplice *splice = &g_array_index (priv->pending_changes, GdMainIconBoxSplice, i);
+          delta += (gint) splice->added - (gint) splice->removed;
+        }
+
+      merged.position = first_splice->position;
+      end = last_splice->position + last_splice->removed;
+      merged.removed = end - merged.position;
+      merged.added = (guint) ((gint) end + delta) - merged.position;
+
+      g_array_set_size (priv->pending_changes, 1);
+      g_array_index (priv->pending_changes, GdMainIconBoxSplice, 0) = merged;
+    }
+}
+
+static gboolean
+gd_main_icon_box_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (widget);
+  GdMainIconBoxPrivate *priv;
 
-static void gd_main_box_generic_interface_init (GdMainBoxGenericInterface *iface);
-G_DEFINE_TYPE_WITH_CODE (GdMainIconBox, gd_main_icon_box, GTK_TYPE_FLOW_BOX,
-                         G_ADD_PRIVATE (GdMainIconBox)
-                         G_IMPLEMENT_INTERFACE (GD_TYPE_MAIN_BOX_GENERIC, gd_main_box_generic_interface_init))
+  priv = gd_main_icon_box_get_instance_private (self);
 
-GtkWidget *
-gd_main_icon_box_create_widget_func (gpointer item, gpointer user_data)
+  gd_main_icon_box_flush_pending_changes (self);
+
+  if (priv->populating)
+    {
+      gint64 refresh_interval;
+
+      /* Leave at least half of each frame for everything else. */
+      gdk_frame_clock_get_refresh_info (frame_clock,
+                                        gdk_frame_clock_get_frame_time (frame_clock),
+                                        &refresh_interval,
+                                        NULL);
+      if (refresh_interval <= 0)
+        refresh_interval = G_USEC_PER_SEC / 60;
+
+      if (gd_main_icon_box_population_step (self, g_get_monotonic_time () + refresh_interval / 2))
+        return G_SOURCE_CONTINUE;
+
+      priv->tick_id = 0;
+      priv->populating = FALSE;
+      g_signal_emit (self, signals[POPULATION_COMPLETE], 0);
+      return G_SOURCE_REMOVE;
+    }
+
+  priv->tick_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gd_main_icon_box_ensure_tick (GdMainIconBox *self)
 {
-  GdMainIconBox *self = GD_MAIN_ICON_BOX (user_data);
   GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->tick_id != 0)
+    return;
+
+  priv->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), gd_main_icon_box_tick, NULL, NULL);
+}
+
+static void
+gd_main_icon_box_stop_tick (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  priv->populating = FALSE;
+  g_array_set_size (priv->pending_changes, 0);
+
+  if (priv->tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->tick_id);
+      priv->tick_id = 0;
+    }
+}
+
+static void
+gd_main_icon_box_get_visible_area (GdMainIconBox *self, GdkRectangle *area)
+{
+  GtkWidget *scrolled_window;
+  GtkWidget *viewport;
+  gint x;
+  gint y;
+
+  area->x = 0;
+  area->y = 0;
+  area->width = gtk_widget_get_allocated_width (GTK_WIDGET (self));
+  area->height = gtk_widget_get_allocated_height (GTK_WIDGET (self));
+
+  scrolled_window = gtk_widget_get_ancestor (GTK_WIDGET (self), GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled_window == NULL)
+    return;
+
+  viewport = gtk_bin_get_child (GTK_BIN (scrolled_window));
+  if (viewport == NULL)
+    return;
+
+  if (!gtk_widget_translate_coordinates (GTK_WIDGET (self), viewport, 0, 0, &x, &y))
+    return;
+
+  area->x = -x;
+  area->y = -y;
+  area->width = gtk_widget_get_allocated_width (viewport);
+  area->height = gtk_widget_get_allocated_height (viewport);
+}
+
+static gboolean
+gd_main_icon_box_spinner_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (widget);
+  GdMainIconBoxPrivate *priv;
+  GHashTableIter iter;
+  GdkRectangle visible_area;
   GtkWidget *child;
+  gint64 frame_time;
 
-  g_return_val_if_fail (GD_IS_MAIN_BOX_ITEM (item), NULL);
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  priv->spinner_angle = 2.0 * G_PI * (gdouble) (frame_time % MAIN_ICON_BOX_SPINNER_PERIOD)
+                        / (gdouble) MAIN_ICON_BOX_SPINNER_PERIOD;
+
+  /* Every child is mapped inside the GtkViewport, so skip the ones
+   * that have been scrolled out of sight.
+   */
+  gd_main_icon_box_get_visible_area (self, &visible_area);
+
+  g_hash_table_iter_init (&iter, priv->pulsing_children);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &child, NULL))
+    {
+      GtkAllocation allocation;
+
+      gtk_widget_get_allocation (child, &allocation);
+      if (!gdk_rectangle_intersect (&allocation, &visible_area, NULL))
+        continue;
+
+      _gd_main_icon_box_child_queue_spinner_draw (GD_MAIN_ICON_BOX_CHILD (child));
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gd_main_icon_box_start_population (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+  GtkWidget *scrolled_window;
+  guint end;
+  guint n_initial = MAIN_ICON_BOX_INITIAL_WINDOW;
+  guint start;
 
   priv = gd_main_icon_box_get_instance_private (self);
 
-  child = gd_main_icon_box_child_new (GD_MAIN_BOX_ITEM (item), priv->selection_mode);
-  g_object_bind_property (self, "show-primary-text", child, "show-primary-text", G_BINDING_SYNC_CREATE);
-  g_object_bind_property (self, "show-secondary-text", child, "show-secondary-text", G_BINDING_SYNC_CREATE);
-  gtk_widget_show_all (child);
+  gd_main_icon_box_get_wanted_window (self, &start, &end);
 
-  return child;
+  /* Build the first screenful right away, so that there is something
+   * to show in the next frame.
+   */
+  scrolled_window = gtk_widget_get_ancestor (GTK_WIDGET (self), GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled_window != NULL && priv->n_columns > 0 && priv->row_stride > 0)
+    {
+      gint height;
+
+      height = gtk_widget_get_allocated_height (scrolled_window);
+      n_initial = ((guint) (height / priv->row_stride) + 1) * priv->n_columns;
+    }
+
+  gd_main_icon_box_set_window (self, start, MIN (end, start + n_initial));
+
+  if (priv->window_end >= end)
+    {
+      gd_main_icon_box_set_population_progress (self, 1.0);
+      g_signal_emit (self, signals[POPULATION_COMPLETE], 0);
+      return;
+    }
+
+  gd_main_icon_box_set_population_progress (self, (gdouble) (priv->window_end - start) / (gdouble) (end - start));
+
+  priv->populating = TRUE;
+  gd_main_icon_box_ensure_tick (self);
+}
+
+static void
+gd_main_icon_box_items_changed (GdMainIconBox *self, guint position, guint removed, guint added, GListModel *model)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* The ID index hasn't seen this change yet, and still has the IDs of
+   * the removed items.
+   */
+  if (priv->preserve_selection && removed > 0 && !gd_index_set_is_empty (priv->selection))
+    {
+      gd_main_icon_box_flush_pending_changes (self);
+      gd_main_icon_box_save_selected_ids (self, position, removed);
+    }
+
+  if (!priv->coalesce_updates)
+    {
+      gd_main_icon_box_flush_pending_changes (self);
+      gd_main_icon_box_apply_splice (self, position, removed, added);
+      return;
+    }
+
+  gd_main_icon_box_add_pending_change (self, position, removed, added);
+  gd_main_icon_box_ensure_tick (self);
+}
+
+static void
+gd_main_icon_box_adjustment_changed (GdMainIconBox *self)
+{
+  gd_main_icon_box_queue_update_window (self);
+}
+
+static void
+gd_main_icon_box_set_vadjustment (GdMainIconBox *self, GtkAdjustment *vadjustment)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->vadjustment == vadjustment)
+    return;
+
+  if (priv->vadjustment != NULL)
+    g_signal_handlers_disconnect_by_func (priv->vadjustment, gd_main_icon_box_adjustment_changed, self);
+
+  g_set_object (&priv->vadjustment, vadjustment);
+
+  if (priv->vadjustment != NULL)
+    {
+      g_signal_connect_object (priv->vadjustment,
+                               "changed",
+                               G_CALLBACK (gd_main_icon_box_adjustment_changed),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (priv->vadjustment,
+                               "value-changed",
+                               G_CALLBACK (gd_main_icon_box_adjustment_changed),
+                               self,
+                               G_CONNECT_SWAPPED);
+    }
 }
 
 static void
@@ -114,12 +1072,39 @@ static GdMainBoxChild *
 gd_main_icon_box_get_child_at_index (GdMainBoxGeneric *generic, gint index)
 {
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+  GdMainIconBoxPrivate *priv;
   GtkFlowBoxChild *child;
 
-  child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (self), index);
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  gd_main_icon_box_flush_pending_changes (self);
+
+  /* Items outside the window don't have a child. */
+  if (index < (gint) priv->window_start || index >= (gint) priv->window_end)
+    return NULL;
+
+  child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (self), index - (gint) priv->window_start);
   return GD_MAIN_BOX_CHILD (child);
 }
 
+static gboolean
+gd_main_icon_box_get_coalesce_updates (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->coalesce_updates;
+}
+
+static gboolean
+gd_main_icon_box_get_preserve_selection (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->preserve_selection;
+}
+
 static const gchar *
 gd_main_icon_box_get_last_selected_id (GdMainBoxGeneric *generic)
 {
@@ -146,10 +1131,23 @@ gd_main_icon_box_get_selected_children (GdMainBoxGeneric *generic)
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
   GList *selected_children;
 
+  gd_main_icon_box_flush_pending_changes (self);
   selected_children = gtk_flow_box_get_selected_children (GTK_FLOW_BOX (self));
   return selected_children;
 }
 
+static GdIndexSet *
+gd_main_icon_box_get_selection (GdMainBoxGeneric *generic)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  gd_main_icon_box_flush_pending_changes (self);
+  return priv->selection;
+}
+
 static gboolean
 gd_main_icon_box_get_selection_mode (GdMainIconBox *self)
 {
@@ -181,6 +1179,8 @@ static void
 gd_main_icon_box_select_all_generic (GdMainBoxGeneric *generic)
 {
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+
+  gd_main_icon_box_flush_pending_changes (self);
   g_signal_emit_by_name (self, "select-all");
 }
 
@@ -188,26 +1188,185 @@ static void
 gd_main_icon_box_select_child (GdMainBoxGeneric *generic, GdMainBoxChild *child)
 {
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+
+  gd_main_icon_box_flush_pending_changes (self);
   gtk_flow_box_select_child (GTK_FLOW_BOX (self), GTK_FLOW_BOX_CHILD (child));
 }
 
+static void
+gd_main_icon_box_set_coalesce_updates (GdMainIconBox *self, gboolean coalesce_updates)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->coalesce_updates == coalesce_updates)
+    return;
+
+  priv->coalesce_updates = coalesce_updates;
+  if (!priv->coalesce_updates)
+    gd_main_icon_box_flush_pending_changes (self);
+
+  g_object_notify (G_OBJECT (self), "coalesce-updates");
+}
+
 static void
 gd_main_icon_box_set_model (GdMainIconBox *self, GListModel *model)
 {
   GdMainIconBoxPrivate *priv;
+  gboolean selection_changed;
 
   priv = gd_main_icon_box_get_instance_private (self);
 
-  if (!g_set_object (&priv->model, model))
+  if (priv->model == model)
     return;
 
-  gtk_flow_box_bind_model (GTK_FLOW_BOX (self),
-                           priv->model,
-                           gd_main_icon_box_create_widget_func,
-                           self,
-                           NULL);
+  if (priv->model != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->model, gd_main_icon_box_items_changed, self);
+
+      gd_main_icon_box_flush_pending_changes (self);
+      gd_main_icon_box_save_selected_ids (self, 0, g_list_model_get_n_items (priv->model));
+    }
+
+  gd_main_icon_box_stop_tick (self);
+  gd_main_icon_box_remove_children (self, 0, priv->window_end - priv->window_start);
+  priv->window_start = 0;
+  priv->window_end = 0;
 
+  selection_changed = !gd_index_set_is_empty (priv->selection);
+  gd_index_set_clear (priv->selection);
+
+  g_set_object (&priv->model, model);
+
+  if (priv->model != NULL)
+    {
+      g_signal_connect_object (priv->model,
+                               "items-changed",
+                               G_CALLBACK (gd_main_icon_box_items_changed),
+                               self,
+                               G_CONNECT_SWAPPED);
+    }
+
+  _gd_main_box_generic_set_id_index_model (GD_MAIN_BOX_GENERIC (self), priv->model);
+
+  if (priv->model != NULL)
+    {
+      /* One pass over the new model against the saved IDs. */
+      gd_main_icon_box_restore_selected_ids (self, 0, g_list_model_get_n_items (priv->model));
+      if (!gd_index_set_is_empty (priv->selection))
+        selection_changed = TRUE;
+
+      if (priv->incremental_population)
+        gd_main_icon_box_start_population (self);
+      else
+        gd_main_icon_box_update_window (self);
+    }
+
+  gtk_widget_queue_resize (GTK_WIDGET (self));
   g_object_notify (G_OBJECT (self), "model");
+
+  if (selection_changed)
+    {
+      priv->restoring_selection = TRUE;
+      g_signal_emit_by_name (self, "selection-changed");
+      priv->restoring_selection = FALSE;
+    }
+}
+
+static void
+gd_main_icon_box_set_preserve_selection (GdMainIconBox *self, gboolean preserve_selection)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->preserve_selection == preserve_selection)
+    return;
+
+  priv->preserve_selection = preserve_selection;
+  if (!priv->preserve_selection)
+    g_hash_table_remove_all (priv->selected_ids);
+
+  g_object_notify (G_OBJECT (self), "preserve-selection");
+}
+
+static gboolean
+gd_main_icon_box_set_range_selected (GdMainBoxGeneric *generic, guint position, guint n_items, gboolean selected)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+  GdMainIconBoxPrivate *priv;
+  gboolean updating_window;
+  guint end;
+  guint i;
+  guint n_selected;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  gd_main_icon_box_flush_pending_changes (self);
+
+  if (priv->model == NULL || !priv->selection_mode)
+    return FALSE;
+
+  end = g_list_model_get_n_items (priv->model);
+  if (position >= end)
+    return FALSE;
+
+  end = position + MIN (n_items, end - position);
+
+  n_selected = gd_index_set_get_size (priv->selection);
+  if (selected)
+    gd_index_set_add_range (priv->selection, position, end - position);
+  else
+    gd_index_set_remove_range (priv->selection, position, end - position);
+
+  /* priv->selection is already up to date, so the children don't need
+   * to report back, and nobody needs to hear from GtkFlowBox about
+   * each one of them.
+   */
+  updating_window = priv->updating_window;
+  priv->updating_window = TRUE;
+
+  for (i = MAX (position, priv->window_start); i < MIN (end, priv->window_end); i++)
+    {
+      GtkFlowBoxChild *child;
+
+      child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (self), (gint) (i - priv->window_start));
+      if (selected)
+        gtk_flow_box_select_child (GTK_FLOW_BOX (self), child);
+      else
+        gtk_flow_box_unselect_child (GTK_FLOW_BOX (self), child);
+    }
+
+  priv->updating_window = updating_window;
+
+  return gd_index_set_get_size (priv->selection) != n_selected;
+}
+
+static void
+gd_main_icon_box_release_check_button (gpointer data, gpointer user_data)
+{
+  if (GD_IS_MAIN_ICON_BOX_CHILD (data))
+    _gd_main_icon_box_child_release_check_button (GD_MAIN_ICON_BOX_CHILD (data));
+}
+
+/* One timer for all the children, pooled ones included, rather than
+ * one for each of them.
+ */
+static gboolean
+gd_main_icon_box_release_check_buttons (gpointer user_data)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (user_data);
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  priv->release_check_buttons_id = 0;
+
+  gtk_container_foreach (GTK_CONTAINER (self), (GtkCallback) gd_main_icon_box_release_check_button, NULL);
+  g_ptr_array_foreach (priv->child_pool, gd_main_icon_box_release_check_button, NULL);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
@@ -225,10 +1384,28 @@ gd_main_icon_box_set_selection_mode (GdMainIconBox *self, gboolean selection_mod
   gd_main_icon_box_update_last_selected_id (self, NULL);
 
   priv->selection_mode = selection_mode;
+
+  if (priv->release_check_buttons_id != 0)
+    {
+      g_source_remove (priv->release_check_buttons_id);
+      priv->release_check_buttons_id = 0;
+    }
+
   if (priv->selection_mode)
-    gtk_flow_box_set_selection_mode (GTK_FLOW_BOX (self), GTK_SELECTION_MULTIPLE);
+    {
+      gtk_flow_box_set_selection_mode (GTK_FLOW_BOX (self), GTK_SELECTION_MULTIPLE);
+    }
   else
-    gtk_flow_box_set_selection_mode (GTK_FLOW_BOX (self), GTK_SELECTION_NONE);
+    {
+      /* GtkFlowBox only unselects the children that it has. */
+      gtk_flow_box_set_selection_mode (GTK_FLOW_BOX (self), GTK_SELECTION_NONE);
+      gd_index_set_clear (priv->selection);
+      g_hash_table_remove_all (priv->selected_ids);
+
+      priv->release_check_buttons_id = g_timeout_add_seconds (MAIN_ICON_BOX_CHECK_BUTTON_GRACE,
+                                                              gd_main_icon_box_release_check_buttons,
+                                                              self);
+    }
 
   children = gtk_container_get_children (GTK_CONTAINER (self));
   for (l = children; l != NULL; l = l->next)
@@ -275,6 +1452,8 @@ static void
 gd_main_icon_box_unselect_all_generic (GdMainBoxGeneric *generic)
 {
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+
+  gd_main_icon_box_flush_pending_changes (self);
   g_signal_emit_by_name (self, "unselect-all");
 }
 
@@ -282,6 +1461,8 @@ static void
 gd_main_icon_box_unselect_child (GdMainBoxGeneric *generic, GdMainBoxChild *child)
 {
   GdMainIconBox *self = GD_MAIN_ICON_BOX (generic);
+
+  gd_main_icon_box_flush_pending_changes (self);
   gtk_flow_box_unselect_child (GTK_FLOW_BOX (self), GTK_FLOW_BOX_CHILD (child));
 }
 
@@ -532,6 +1713,7 @@ gd_main_icon_box_drag_begin (GtkWidget *widget, GdkDragContext *context)
   GdMainIconBoxPrivate *priv;
   GdMainBoxItem *item;
   GtkFlowBoxChild *child;
+  cairo_surface_t *counter = NULL;
   cairo_surface_t *drag_icon = NULL;
   cairo_surface_t *icon;
 
@@ -553,34 +1735,31 @@ gd_main_icon_box_drag_begin (GtkWidget *widget, GdkDragContext *context)
 
   if (priv->selection_mode)
     {
-      GList *selected_children;
-      guint length;
+      guint n_selected;
 
-      selected_children = gtk_flow_box_get_selected_children (GTK_FLOW_BOX (self));
-      length = g_list_length (selected_children);
-      if (length > 1)
-        drag_icon = gd_create_surface_with_counter (GTK_WIDGET (self), icon, length);
-
-      g_list_free (selected_children);
+      n_selected = gd_index_set_get_size (priv->selection);
+      if (n_selected > 1)
+        counter = gd_create_surface_with_counter (GTK_WIDGET (self), icon, n_selected);
     }
 
-  if (drag_icon == NULL)
-    drag_icon = gd_copy_image_surface (icon);
+  if (counter != NULL)
+    icon = counter;
+
+  drag_icon = gd_copy_image_surface_for_window (icon, gtk_widget_get_window (widget));
 
   cairo_surface_set_device_offset (drag_icon, -MAIN_ICON_BOX_DND_ICON_OFFSET, -MAIN_ICON_BOX_DND_ICON_OFFSET);
   gtk_drag_set_icon_surface (context, drag_icon);
 
  out:
+  g_clear_pointer (&counter, cairo_surface_destroy);
   g_clear_pointer (&drag_icon, cairo_surface_destroy);
 }
 
 static void
-gd_main_icon_box_add_child_uri_to_array (GdMainBoxChild *child, GPtrArray *uri_array)
+gd_main_icon_box_add_item_uri_to_array (GdMainBoxItem *item, GPtrArray *uri_array)
 {
-  GdMainBoxItem *item;
   const gchar *uri;
 
-  item = gd_main_box_child_get_item (child);
   uri = gd_main_box_item_get_uri (item);
   g_ptr_array_add (uri_array, g_strdup (uri));
 }
@@ -608,17 +1787,20 @@ gd_main_icon_box_drag_data_get (GtkWidget *widget,
 
   if (priv->selection_mode)
     {
-      GList *l;
-      GList *selected_children;
+      GdIndexSetIter iter;
+      guint position;
+
+      gd_main_icon_box_flush_pending_changes (self);
 
-      selected_children = gtk_flow_box_get_selected_children (GTK_FLOW_BOX (self));
-      for (l = selected_children; l != NULL; l = l->next)
+      gd_index_set_iter_init (&iter, priv->selection);
+      while (gd_index_set_iter_next (&iter, &position))
         {
-          GdMainBoxChild *child = GD_MAIN_BOX_CHILD (l->data);
-          gd_main_icon_box_add_child_uri_to_array (child, uri_array);
-        }
+          GdMainBoxItem *item;
 
-      g_list_free (selected_children);
+          item = GD_MAIN_BOX_ITEM (g_list_model_get_object (priv->model, position));
+          gd_main_icon_box_add_item_uri_to_array (item, uri_array);
+          g_object_unref (item);
+        }
     }
   else
     {
@@ -629,7 +1811,12 @@ gd_main_icon_box_drag_data_get (GtkWidget *widget,
                                              (gint) priv->dnd_start_y);
 
       if (child != NULL)
-        gd_main_icon_box_add_child_uri_to_array (GD_MAIN_BOX_CHILD (child), uri_array);
+        {
+          GdMainBoxItem *item;
+
+          item = gd_main_box_child_get_item (GD_MAIN_BOX_CHILD (child));
+          gd_main_icon_box_add_item_uri_to_array (item, uri_array);
+        }
     }
 
   g_ptr_array_add (uri_array, NULL);
@@ -681,6 +1868,74 @@ gd_main_icon_box_focus (GtkWidget *widget, GtkDirectionType direction)
   return res;
 }
 
+static void
+gd_main_icon_box_get_preferred_height_for_width (GtkWidget *widget, gint width, gint *minimum, gint *natural)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (widget);
+  GdMainIconBoxPrivate *priv;
+  gint extra_height;
+  gint row_stride;
+  guint n_columns;
+  guint n_items;
+  guint n_rows;
+  guint n_window_rows;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->get_preferred_height_for_width (widget, width, minimum, natural);
+
+  if (!priv->virtualized || priv->model == NULL)
+    return;
+
+  if (!gd_main_icon_box_measure_rows (self, width, &n_columns, &row_stride))
+    return;
+
+  /* Ask for enough room to hold all the rows, not just the ones that
+   * have been materialized, so that the scrollbars make sense.
+   */
+  n_items = g_list_model_get_n_items (priv->model);
+  n_rows = (n_items + n_columns - 1) / n_columns;
+  n_window_rows = (priv->window_end - priv->window_start + n_columns - 1) / n_columns;
+  if (n_rows <= n_window_rows)
+    return;
+
+  extra_height = (gint) (n_rows - n_window_rows) * row_stride;
+  if (n_window_rows == 0)
+    extra_height -= (gint) gtk_flow_box_get_row_spacing (GTK_FLOW_BOX (self));
+
+  if (minimum != NULL)
+    *minimum += extra_height;
+  if (natural != NULL)
+    *natural += extra_height;
+}
+
+static void
+gd_main_icon_box_get_preferred_height (GtkWidget *widget, gint *minimum, gint *natural)
+{
+  gint min_width;
+
+  gtk_widget_get_preferred_width (widget, &min_width, NULL);
+  gd_main_icon_box_get_preferred_height_for_width (widget, min_width, minimum, natural);
+}
+
+static void
+gd_main_icon_box_hierarchy_changed (GtkWidget *widget, GtkWidget *previous_toplevel)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (widget);
+  GtkAdjustment *vadjustment = NULL;
+  GtkWidget *scrolled_window;
+
+  if (GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->hierarchy_changed != NULL)
+    GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->hierarchy_changed (widget, previous_toplevel);
+
+  scrolled_window = gtk_widget_get_ancestor (widget, GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled_window != NULL)
+    vadjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled_window));
+
+  gd_main_icon_box_set_vadjustment (self, vadjustment);
+  gd_main_icon_box_queue_update_window (self);
+}
+
 static gboolean
 gd_main_icon_box_motion_notify_event (GtkWidget *widget, GdkEventMotion *event)
 {
@@ -774,13 +2029,54 @@ gd_main_icon_box_remove (GtkContainer *container, GtkWidget *widget)
 
   GTK_CONTAINER_CLASS (gd_main_icon_box_parent_class)->remove (container, widget);
 
-  if (priv->selection_changed)
+  if (priv->selection_changed && !priv->updating_window)
     {
       g_signal_emit_by_name (self, "selection-changed");
       priv->selection_changed = FALSE;
     }
 }
 
+static void
+gd_main_icon_box_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+  GdMainIconBox *self = GD_MAIN_ICON_BOX (widget);
+  GdMainIconBoxPrivate *priv;
+  GtkAllocation slice_allocation;
+  gint row_stride;
+  gint slice_height;
+  guint n_columns;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (!priv->virtualized || !gd_main_icon_box_measure_rows (self, allocation->width, &n_columns, &row_stride))
+    {
+      priv->slice_offset = 0;
+      GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->size_allocate (widget, allocation);
+      goto out;
+    }
+
+  priv->n_columns = n_columns;
+  priv->row_stride = row_stride;
+
+  /* Only hand the materialized rows to GtkFlowBox, placed where they
+   * would be if every row was there.
+   */
+  GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->get_preferred_height_for_width (widget,
+                                                                                    allocation->width,
+                                                                                    NULL,
+                                                                                    &slice_height);
+
+  priv->slice_offset = (gint) (priv->window_start / n_columns) * row_stride;
+
+  slice_allocation = *allocation;
+  slice_allocation.y += priv->slice_offset;
+  slice_allocation.height = MAX (slice_height, 1);
+  GTK_WIDGET_CLASS (gd_main_icon_box_parent_class)->size_allocate (widget, &slice_allocation);
+
+ out:
+  gd_main_icon_box_queue_update_window (self);
+}
+
 static void
 gd_main_icon_box_select_all_flow_box (GtkFlowBox *flow_box)
 {
@@ -789,6 +2085,19 @@ gd_main_icon_box_select_all_flow_box (GtkFlowBox *flow_box)
 
   priv = gd_main_icon_box_get_instance_private (self);
 
+  /* Also select the items that don't have a child right now. */
+  if (priv->model != NULL && gtk_flow_box_get_selection_mode (flow_box) == GTK_SELECTION_MULTIPLE)
+    {
+      guint n_items;
+
+      n_items = g_list_model_get_n_items (priv->model);
+      if (gd_index_set_get_size (priv->selection) != n_items)
+        {
+          gd_index_set_add_range (priv->selection, 0, n_items);
+          priv->selection_changed = TRUE;
+        }
+    }
+
   GTK_FLOW_BOX_CLASS (gd_main_icon_box_parent_class)->select_all (flow_box);
 
   if (priv->selection_changed)
@@ -808,33 +2117,16 @@ gd_main_icon_box_selected_children_changed (GtkFlowBox *flow_box)
 
   GTK_FLOW_BOX_CLASS (gd_main_icon_box_parent_class)->selected_children_changed (flow_box);
 
-  priv->selection_changed = TRUE;
-
-  /* When a range selection is attempted, we override GtkFlowBox's
-   * default behaviour by changing the selection ourselves. Therefore,
-   * there is no need to update the check buttons until the final
-   * selection is available.
+  /* Children coming and going as the window moves don't change the
+   * selection.
    */
-  if (!priv->key_shift_pressed && !priv->left_button_shift_released)
-    {
-      GList *children;
-      GList *l;
-
-      children = gtk_container_get_children (GTK_CONTAINER (self));
-      for (l = children; l != NULL; l = l->next)
-        {
-          GtkFlowBoxChild *child = GTK_FLOW_BOX_CHILD (l->data);
-          gboolean selected;
-
-          /* Work around the fact that GtkFlowBoxChild:selected is not
-           * a property.
-           */
-          selected = gtk_flow_box_child_is_selected (child);
-          gd_main_box_child_set_selected (GD_MAIN_BOX_CHILD (child), selected);
-        }
+  if (priv->updating_window)
+    return;
 
-      g_list_free (children);
-    }
+  /* The children keep their check buttons in sync through their
+   * GTK_STATE_FLAG_SELECTED, so only those that changed are touched.
+   */
+  priv->selection_changed = TRUE;
 }
 
 static void
@@ -847,6 +2139,12 @@ gd_main_icon_box_unselect_all_flow_box (GtkFlowBox *flow_box)
 
   GTK_FLOW_BOX_CLASS (gd_main_icon_box_parent_class)->unselect_all (flow_box);
 
+  if (gtk_flow_box_get_selection_mode (flow_box) != GTK_SELECTION_BROWSE && !gd_index_set_is_empty (priv->selection))
+    {
+      gd_index_set_clear (priv->selection);
+      priv->selection_changed = TRUE;
+    }
+
   if (priv->selection_changed)
     {
       g_signal_emit_by_name (self, "selection-changed");
@@ -862,7 +2160,37 @@ gd_main_icon_box_dispose (GObject *obj)
 
   priv = gd_main_icon_box_get_instance_private (self);
 
-  g_clear_object (&priv->model);
+  if (priv->update_window_id != 0)
+    {
+      g_source_remove (priv->update_window_id);
+      priv->update_window_id = 0;
+    }
+
+  if (priv->release_check_buttons_id != 0)
+    {
+      g_source_remove (priv->release_check_buttons_id);
+      priv->release_check_buttons_id = 0;
+    }
+
+  gd_main_icon_box_stop_tick (self);
+  gd_main_icon_box_set_vadjustment (self, NULL);
+
+  if (priv->spinner_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->spinner_tick_id);
+      priv->spinner_tick_id = 0;
+    }
+
+  g_hash_table_remove_all (priv->pulsing_children);
+  g_ptr_array_set_size (priv->child_pool, 0);
+
+  if (priv->model != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->model, gd_main_icon_box_items_changed, self);
+      g_clear_object (&priv->model);
+    }
+
+  _gd_main_box_generic_set_id_index_model (GD_MAIN_BOX_GENERIC (self), NULL);
 
   G_OBJECT_CLASS (gd_main_icon_box_parent_class)->dispose (obj);
 }
@@ -876,6 +2204,11 @@ gd_main_icon_box_finalize (GObject *obj)
   priv = gd_main_icon_box_get_instance_private (self);
 
   g_free (priv->last_selected_id);
+  gd_index_set_free (priv->selection);
+  g_hash_table_unref (priv->pulsing_children);
+  g_hash_table_unref (priv->selected_ids);
+  g_ptr_array_unref (priv->child_pool);
+  g_array_unref (priv->pending_changes);
 
   G_OBJECT_CLASS (gd_main_icon_box_parent_class)->finalize (obj);
 }
@@ -902,6 +2235,27 @@ gd_main_icon_box_get_property (GObject *object, guint property_id, GValue *value
     case PROP_SHOW_SECONDARY_TEXT:
       g_value_set_boolean (value, gd_main_icon_box_get_show_secondary_text (self));
       break;
+    case PROP_COALESCE_UPDATES:
+      g_value_set_boolean (value, gd_main_icon_box_get_coalesce_updates (self));
+      break;
+    case PROP_PRESERVE_SELECTION:
+      g_value_set_boolean (value, gd_main_icon_box_get_preserve_selection (self));
+      break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, gd_main_icon_box_get_virtualized (self));
+      break;
+    case PROP_OVERSCAN:
+      g_value_set_uint (value, gd_main_icon_box_get_overscan (self));
+      break;
+    case PROP_INCREMENTAL_POPULATION:
+      g_value_set_boolean (value, gd_main_icon_box_get_incremental_population (self));
+      break;
+    case PROP_POPULATION_PROGRESS:
+      g_value_set_double (value, gd_main_icon_box_get_population_progress (self));
+      break;
+    case PROP_FLAT_CHILDREN:
+      g_value_set_boolean (value, gd_main_icon_box_get_flat_children (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -927,6 +2281,24 @@ gd_main_icon_box_set_property (GObject *object, guint property_id, const GValue
     case PROP_SHOW_SECONDARY_TEXT:
       gd_main_icon_box_set_show_secondary_text (self, g_value_get_boolean (value));
       break;
+    case PROP_COALESCE_UPDATES:
+      gd_main_icon_box_set_coalesce_updates (self, g_value_get_boolean (value));
+      break;
+    case PROP_PRESERVE_SELECTION:
+      gd_main_icon_box_set_preserve_selection (self, g_value_get_boolean (value));
+      break;
+    case PROP_VIRTUALIZED:
+      gd_main_icon_box_set_virtualized (self, g_value_get_boolean (value));
+      break;
+    case PROP_OVERSCAN:
+      gd_main_icon_box_set_overscan (self, g_value_get_uint (value));
+      break;
+    case PROP_INCREMENTAL_POPULATION:
+      gd_main_icon_box_set_incremental_population (self, g_value_get_boolean (value));
+      break;
+    case PROP_FLAT_CHILDREN:
+      gd_main_icon_box_set_flat_children (self, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -955,6 +2327,16 @@ gd_main_icon_box_init (GdMainIconBox *self)
   priv->dnd_button = -1;
   priv->dnd_start_x = -1.0;
   priv->dnd_start_y = -1.0;
+  priv->child_pool = g_ptr_array_new_with_free_func (g_object_unref);
+  priv->coalesce_updates = TRUE;
+  priv->pending_changes = g_array_new (FALSE, FALSE, sizeof (GdMainIconBoxSplice));
+  priv->overscan = 2;
+  priv->population_progress = 1.0;
+  priv->pulsing_children = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->selected_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->selection = gd_index_set_new ();
+
+  g_signal_connect (self, "selection-changed", G_CALLBACK (gd_main_icon_box_forget_selected_ids), NULL);
 }
 
 static void
@@ -982,7 +2364,11 @@ gd_main_icon_box_class_init (GdMainIconBoxClass *klass)
   wclass->drag_begin = gd_main_icon_box_drag_begin;
   wclass->drag_data_get = gd_main_icon_box_drag_data_get;
   wclass->focus = gd_main_icon_box_focus;
+  wclass->get_preferred_height = gd_main_icon_box_get_preferred_height;
+  wclass->get_preferred_height_for_width = gd_main_icon_box_get_preferred_height_for_width;
+  wclass->hierarchy_changed = gd_main_icon_box_hierarchy_changed;
   wclass->motion_notify_event = gd_main_icon_box_motion_notify_event;
+  wclass->size_allocate = gd_main_icon_box_size_allocate;
   cclass->remove = gd_main_icon_box_remove;
   fbclass->activate_cursor_child = gd_main_icon_box_activate_cursor_child;
   fbclass->child_activated = gd_main_icon_box_child_activated;
@@ -996,6 +2382,79 @@ gd_main_icon_box_class_init (GdMainIconBoxClass *klass)
   g_object_class_override_property (oclass, PROP_SELECTION_MODE, "gd-selection-mode");
   g_object_class_override_property (oclass, PROP_SHOW_PRIMARY_TEXT, "show-primary-text");
   g_object_class_override_property (oclass, PROP_SHOW_SECONDARY_TEXT, "show-secondary-text");
+  g_object_class_override_property (oclass, PROP_COALESCE_UPDATES, "coalesce-updates");
+  g_object_class_override_property (oclass, PROP_PRESERVE_SELECTION, "preserve-selection");
+
+  g_object_class_install_property (oclass,
+                                   PROP_VIRTUALIZED,
+                                   g_param_spec_boolean ("virtualized",
+                                                         "Virtualized",
+                                                         "Whether to only create children for the visible rows",
+                                                         FALSE,
+                                                         G_PARAM_EXPLICIT_NOTIFY |
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (oclass,
+                                   PROP_OVERSCAN,
+                                   g_param_spec_uint ("overscan",
+                                                      "Overscan",
+                                                      "Number of rows to keep above and below the visible ones",
+                                                      0,
+                                                      G_MAXUINT,
+                                                      2,
+                                                      G_PARAM_EXPLICIT_NOTIFY |
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (oclass,
+                                   PROP_INCREMENTAL_POPULATION,
+                                   g_param_spec_boolean ("incremental-population",
+                                                         "Incremental population",
+                                                         "Whether to create the children over several frames",
+                                                         FALSE,
+                                                         G_PARAM_EXPLICIT_NOTIFY |
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (oclass,
+                                   PROP_POPULATION_PROGRESS,
+                                   g_param_spec_double ("population-progress",
+                                                        "Population progress",
+                                                        "Fraction of the children that have been created",
+                                                        0.0,
+                                                        1.0,
+                                                        1.0,
+                                                        G_PARAM_EXPLICIT_NOTIFY |
+                                                        G_PARAM_READABLE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (oclass,
+                                   PROP_FLAT_CHILDREN,
+                                   g_param_spec_boolean ("flat-children",
+                                                         "Flat children",
+                                                         "Whether each child draws its item without child widgets",
+                                                         FALSE,
+                                                         G_PARAM_EXPLICIT_NOTIFY |
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GdMainIconBox::population-complete:
+   * @self:
+   *
+   * Emitted when #GdMainIconBox:incremental-population is %TRUE and
+   * the last child for a new model has been created.
+   */
+  signals[POPULATION_COMPLETE] = g_signal_new ("population-complete",
+                                               GD_TYPE_MAIN_ICON_BOX,
+                                               G_SIGNAL_RUN_LAST,
+                                               0,
+                                               NULL,
+                                               NULL,
+                                               g_cclosure_marshal_VOID__VOID,
+                                               G_TYPE_NONE,
+                                               0);
 
   for (i = 0; i < G_N_ELEMENTS (activate_modifiers); i++)
     {
@@ -1029,8 +2488,10 @@ gd_main_box_generic_interface_init (GdMainBoxGenericInterface *iface)
   iface->get_last_selected_id = gd_main_icon_box_get_last_selected_id;
   iface->get_model = gd_main_icon_box_get_model;
   iface->get_selected_children = gd_main_icon_box_get_selected_children;
+  iface->get_selection = gd_main_icon_box_get_selection;
   iface->select_all = gd_main_icon_box_select_all_generic;
   iface->select_child = gd_main_icon_box_select_child;
+  iface->set_range_selected = gd_main_icon_box_set_range_selected;
   iface->unselect_all = gd_main_icon_box_unselect_all_generic;
   iface->unselect_child = gd_main_icon_box_unselect_child;
 }
@@ -1040,3 +2501,297 @@ gd_main_icon_box_new (void)
 {
   return g_object_new (GD_TYPE_MAIN_ICON_BOX, NULL);
 }
+
+/**
+ * gd_main_icon_box_get_virtualized:
+ * @self:
+ *
+ * Returns:
+ */
+gboolean
+gd_main_icon_box_get_virtualized (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_val_if_fail (GD_IS_MAIN_ICON_BOX (self), FALSE);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->virtualized;
+}
+
+/**
+ * gd_main_icon_box_set_virtualized:
+ * @self:
+ * @virtualized:
+ *
+ * If @virtualized is %TRUE, children are only created for the rows
+ * that are visible inside the surrounding #GtkScrolledWindow, and
+ * #GdMainIconBox:overscan rows above and below them.
+ */
+void
+gd_main_icon_box_set_virtualized (GdMainIconBox *self, gboolean virtualized)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX (self));
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+  gd_main_icon_box_update_window (self);
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+  g_object_notify (G_OBJECT (self), "virtualized");
+}
+
+/**
+ * gd_main_icon_box_get_overscan:
+ * @self:
+ *
+ * Returns:
+ */
+guint
+gd_main_icon_box_get_overscan (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_val_if_fail (GD_IS_MAIN_ICON_BOX (self), 0);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->overscan;
+}
+
+/**
+ * gd_main_icon_box_set_overscan:
+ * @self:
+ * @overscan:
+ *
+ * Sets the number of rows that are kept materialized above and below
+ * the visible ones when #GdMainIconBox:virtualized is %TRUE.
+ */
+void
+gd_main_icon_box_set_overscan (GdMainIconBox *self, guint overscan)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX (self));
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->overscan == overscan)
+    return;
+
+  priv->overscan = overscan;
+  gd_main_icon_box_queue_update_window (self);
+  g_object_notify (G_OBJECT (self), "overscan");
+}
+
+/**
+ * gd_main_icon_box_get_incremental_population:
+ * @self:
+ *
+ * Returns:
+ */
+gboolean
+gd_main_icon_box_get_incremental_population (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_val_if_fail (GD_IS_MAIN_ICON_BOX (self), FALSE);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->incremental_population;
+}
+
+/**
+ * gd_main_icon_box_set_incremental_population:
+ * @self:
+ * @incremental_population:
+ *
+ * If @incremental_population is %TRUE, setting a model only creates
+ * the first screenful of children right away. The rest are created in
+ * batches from the #GdkFrameClock, using at most half of each frame.
+ * This applies to models that are set afterwards.
+ */
+void
+gd_main_icon_box_set_incremental_population (GdMainIconBox *self, gboolean incremental_population)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX (self));
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->incremental_population == incremental_population)
+    return;
+
+  priv->incremental_population = incremental_population;
+  g_object_notify (G_OBJECT (self), "incremental-population");
+}
+
+/**
+ * gd_main_icon_box_get_population_progress:
+ * @self:
+ *
+ * Returns: The fraction of the children that have been created so far.
+ */
+gdouble
+gd_main_icon_box_get_population_progress (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_val_if_fail (GD_IS_MAIN_ICON_BOX (self), 1.0);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->population_progress;
+}
+
+/**
+ * gd_main_icon_box_get_pool_stats:
+ * @self:
+ * @out_hits: (out) (allow-none): number of children that were reused
+ * @out_misses: (out) (allow-none): number of children that had to be created
+ *
+ * Children that are removed from @self are kept around and reused
+ * for other items. This returns how often that worked out.
+ */
+void
+gd_main_icon_box_get_pool_stats (GdMainIconBox *self, guint *out_hits, guint *out_misses)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX (self));
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (out_hits != NULL)
+    *out_hits = priv->n_pool_hits;
+
+  if (out_misses != NULL)
+    *out_misses = priv->n_pool_misses;
+}
+
+/**
+ * gd_main_icon_box_get_flat_children:
+ * @self:
+ *
+ * Returns:
+ */
+gboolean
+gd_main_icon_box_get_flat_children (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_val_if_fail (GD_IS_MAIN_ICON_BOX (self), FALSE);
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->flat_children;
+}
+
+/**
+ * gd_main_icon_box_set_flat_children:
+ * @self:
+ * @flat_children:
+ *
+ * If @flat_children is %TRUE, each child measures and draws its icon,
+ * check mark, spinner and text itself, instead of using a tree of
+ * widgets. This makes children a lot cheaper to create and to style.
+ */
+void
+gd_main_icon_box_set_flat_children (GdMainIconBox *self, gboolean flat_children)
+{
+  GdMainIconBoxPrivate *priv;
+
+  g_return_if_fail (GD_IS_MAIN_ICON_BOX (self));
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (priv->flat_children == flat_children)
+    return;
+
+  priv->flat_children = flat_children;
+  g_object_notify (G_OBJECT (self), "flat-children");
+}
+
+guint
+_gd_main_icon_box_get_window_start (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->window_start;
+}
+
+void
+_gd_main_icon_box_track_child_selection (GdMainIconBox *self, GtkFlowBoxChild *child, gboolean selected)
+{
+  GdMainIconBoxPrivate *priv;
+  gint index;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* Children come and go with the window without changing the
+   * selection. priv->selection is updated separately for that.
+   */
+  if (priv->updating_window)
+    return;
+
+  index = gtk_flow_box_child_get_index (child);
+  if (index < 0)
+    return;
+
+  if (selected)
+    gd_index_set_add (priv->selection, priv->window_start + (guint) index);
+  else
+    gd_index_set_remove (priv->selection, priv->window_start + (guint) index);
+}
+
+void
+_gd_main_icon_box_add_pulsing_child (GdMainIconBox *self, GdMainIconBoxChild *child)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  /* A single clock animates the spinners of all the pulsing
+   * children, instead of one per child.
+   */
+  if (!g_hash_table_add (priv->pulsing_children, child))
+    return;
+
+  if (priv->spinner_tick_id == 0)
+    {
+      priv->spinner_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                            gd_main_icon_box_spinner_tick,
+                                                            NULL,
+                                                            NULL);
+    }
+}
+
+gdouble
+_gd_main_icon_box_get_spinner_angle (GdMainIconBox *self)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+  return priv->spinner_angle;
+}
+
+void
+_gd_main_icon_box_remove_pulsing_child (GdMainIconBox *self, GdMainIconBoxChild *child)
+{
+  GdMainIconBoxPrivate *priv;
+
+  priv = gd_main_icon_box_get_instance_private (self);
+
+  if (!g_hash_table_remove (priv->pulsing_children, child))
+    return;
+
+  if (g_hash_table_size (priv->pulsing_children) == 0 && priv->spinner_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->spinner_tick_id);
+      priv->spinner_tick_id = 0;
+    }
+}
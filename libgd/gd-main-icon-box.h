@@ -24,6 +24,8 @@
 
 #include <gtk/gtk.h>
 
+#include "gd-main-icon-box-child.h"
+
 G_BEGIN_DECLS
 
 #define GD_TYPE_MAIN_ICON_BOX gd_main_icon_box_get_type()
@@ -39,6 +41,30 @@ struct _GdMainIconBoxClass
 
 GtkWidget * gd_main_icon_box_new (void);
 
+gboolean    gd_main_icon_box_get_virtualized    (GdMainIconBox *self);
+void        gd_main_icon_box_set_virtualized    (GdMainIconBox *self, gboolean virtualized);
+
+guint       gd_main_icon_box_get_overscan       (GdMainIconBox *self);
+void        gd_main_icon_box_set_overscan       (GdMainIconBox *self, guint overscan);
+
+gboolean    gd_main_icon_box_get_incremental_population (GdMainIconBox *self);
+void        gd_main_icon_box_set_incremental_population (GdMainIconBox *self, gboolean incremental_population);
+gdouble     gd_main_icon_box_get_population_progress    (GdMainIconBox *self);
+
+void        gd_main_icon_box_get_pool_stats     (GdMainIconBox *self, guint *out_hits, guint *out_misses);
+
+gboolean    gd_main_icon_box_get_flat_children  (GdMainIconBox *self);
+void        gd_main_icon_box_set_flat_children  (GdMainIconBox *self, gboolean flat_children);
+
+/* private */
+guint       _gd_main_icon_box_get_window_start  (GdMainIconBox *self);
+void        _gd_main_icon_box_track_child_selection  (GdMainIconBox *self,
+                                                      GtkFlowBoxChild *child,
+                                                      gboolean selected);
+void        _gd_main_icon_box_add_pulsing_child      (GdMainIconBox *self, GdMainIconBoxChild *child);
+void        _gd_main_icon_box_remove_pulsing_child   (GdMainIconBox *self, GdMainIconBoxChild *child);
+gdouble     _gd_main_icon_box_get_spinner_angle      (GdMainIconBox *self);
+
 G_END_DECLS
 
 #endif /* __GD_MAIN_ICON_BOX_H__ */
@@ -32,16 +32,26 @@
 #define VIEW_ITEM_WRAP_WIDTH 128
 #define VIEW_COLUMN_SPACING 20
 #define VIEW_MARGIN 16
+#define VIEW_SPINNER_PERIOD G_USEC_PER_SEC
+#define VIEW_SPINNER_STEPS 12
 
 typedef struct _GdMainIconViewPrivate GdMainIconViewPrivate;
 
 struct _GdMainIconViewPrivate {
+  GArray *pulsing_areas;
+  GtkAdjustment *vadjustment;
   GtkCellRenderer *pixbuf_cell;
   GtkCellRenderer *text_cell;
+  GtkTreeModel *model;
   gboolean selection_mode;
+  guint pulse_phase;
+  guint pulse_tick_id;
+  guint update_pulsing_areas_id;
 };
 
 static void gd_main_view_generic_iface_init (GdMainViewGenericIface *iface);
+static void gd_main_icon_view_set_pulse_model (GdMainIconView *self);
+static void gd_main_icon_view_set_pulse_vadjustment (GdMainIconView *self);
 G_DEFINE_TYPE_WITH_CODE (GdMainIconView, gd_main_icon_view, GTK_TYPE_ICON_VIEW,
                          G_ADD_PRIVATE (GdMainIconView)
                          G_IMPLEMENT_INTERFACE (GD_TYPE_MAIN_VIEW_GENERIC,
@@ -162,6 +172,8 @@ gd_main_icon_view_constructed (GObject *obj)
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (self), cell, FALSE);
 
   set_attributes_from_model (self);
+  gd_main_icon_view_set_pulse_model (self);
+  gd_main_icon_view_set_pulse_vadjustment (self);
 
   gtk_icon_view_enable_model_drag_source (GTK_ICON_VIEW (self),
                                           GDK_BUTTON1_MASK,
@@ -227,6 +239,188 @@ path_from_line_rects (cairo_t *cr,
   while (end_line < n_lines);
 }
 
+static gboolean
+gd_main_icon_view_pulse_tick (GtkWidget     *widget,
+                              GdkFrameClock *frame_clock,
+                              gpointer       user_data)
+{
+  GdMainIconView *self = GD_MAIN_ICON_VIEW (widget);
+  GdMainIconViewPrivate *priv;
+  gint64 frame_time;
+  guint i;
+  guint phase;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  phase = (guint) ((frame_time % VIEW_SPINNER_PERIOD) * VIEW_SPINNER_STEPS / VIEW_SPINNER_PERIOD);
+
+  /* The spinner only has so many steps. There is nothing to redraw
+   * until the next one.
+   */
+  if (phase == priv->pulse_phase)
+    return G_SOURCE_CONTINUE;
+
+  priv->pulse_phase = phase;
+  g_object_set (priv->pixbuf_cell, "pulse-phase", phase, NULL);
+
+  for (i = 0; i < priv->pulsing_areas->len; i++)
+    {
+      GdkRectangle *area;
+
+      area = &g_array_index (priv->pulsing_areas, GdkRectangle, i);
+      gtk_widget_queue_draw_area (widget, area->x, area->y, area->width, area->height);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Instead of having the application bump GD_MAIN_COLUMN_PULSE on
+ * every row, which emits row-changed for each of them, the spinners
+ * of all the visible pulsing rows are animated from a single tick.
+ * They are looked up again when the view scrolls, is resized or the
+ * model changes; see gd_main_icon_view_queue_update_pulsing_areas().
+ */
+static void
+gd_main_icon_view_update_pulsing_areas (GdMainIconView *self)
+{
+  GdMainIconViewPrivate *priv;
+  GtkTreeModel *model;
+  GtkTreePath *end = NULL;
+  GtkTreePath *path = NULL;
+  GtkTreeIter iter;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+
+  g_array_set_size (priv->pulsing_areas, 0);
+
+  model = gtk_icon_view_get_model (GTK_ICON_VIEW (self));
+  if (model == NULL)
+    goto out;
+
+  if (!gtk_icon_view_get_visible_range (GTK_ICON_VIEW (self), &path, &end))
+    goto out;
+
+  while (gtk_tree_path_compare (path, end) <= 0 && gtk_tree_model_get_iter (model, &iter, path))
+    {
+      GdkRectangle area;
+      guint pulse;
+
+      gtk_tree_model_get (model, &iter, GD_MAIN_COLUMN_PULSE, &pulse, -1);
+      if (pulse != 0 && gtk_icon_view_get_cell_rect (GTK_ICON_VIEW (self), path, priv->pixbuf_cell, &area))
+        g_array_append_val (priv->pulsing_areas, area);
+
+      gtk_tree_path_next (path);
+    }
+
+ out:
+  if (priv->pulsing_areas->len > 0 && priv->pulse_tick_id == 0)
+    {
+      priv->pulse_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                                          gd_main_icon_view_pulse_tick,
+                                                          NULL,
+                                                          NULL);
+    }
+  else if (priv->pulsing_areas->len == 0 && priv->pulse_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->pulse_tick_id);
+      priv->pulse_tick_id = 0;
+    }
+
+  g_clear_pointer (&end, gtk_tree_path_free);
+  g_clear_pointer (&path, gtk_tree_path_free);
+}
+
+static gboolean
+gd_main_icon_view_update_pulsing_areas_idle (gpointer user_data)
+{
+  GdMainIconView *self = GD_MAIN_ICON_VIEW (user_data);
+  GdMainIconViewPrivate *priv;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+  priv->update_pulsing_areas_id = 0;
+
+  gd_main_icon_view_update_pulsing_areas (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Coalesces bursts of changes, and runs after GtkIconView has laid
+ * out the items again, so that their cell rectangles are current.
+ */
+static void
+gd_main_icon_view_queue_update_pulsing_areas (GdMainIconView *self)
+{
+  GdMainIconViewPrivate *priv;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+
+  if (priv->update_pulsing_areas_id != 0)
+    return;
+
+  priv->update_pulsing_areas_id = g_idle_add (gd_main_icon_view_update_pulsing_areas_idle, self);
+}
+
+static void
+gd_main_icon_view_set_pulse_model (GdMainIconView *self)
+{
+  GdMainIconViewPrivate *priv;
+  GtkTreeModel *model;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+  model = gtk_icon_view_get_model (GTK_ICON_VIEW (self));
+
+  if (priv->model != NULL)
+    g_signal_handlers_disconnect_by_func (priv->model, gd_main_icon_view_queue_update_pulsing_areas, self);
+
+  g_set_object (&priv->model, model);
+
+  if (priv->model != NULL)
+    {
+      g_signal_connect_swapped (priv->model, "row-changed",
+                                G_CALLBACK (gd_main_icon_view_queue_update_pulsing_areas), self);
+      g_signal_connect_swapped (priv->model, "row-inserted",
+                                G_CALLBACK (gd_main_icon_view_queue_update_pulsing_areas), self);
+      g_signal_connect_swapped (priv->model, "row-deleted",
+                                G_CALLBACK (gd_main_icon_view_queue_update_pulsing_areas), self);
+      g_signal_connect_swapped (priv->model, "rows-reordered",
+                                G_CALLBACK (gd_main_icon_view_queue_update_pulsing_areas), self);
+    }
+
+  gd_main_icon_view_queue_update_pulsing_areas (self);
+}
+
+static void
+gd_main_icon_view_set_pulse_vadjustment (GdMainIconView *self)
+{
+  GdMainIconViewPrivate *priv;
+  GtkAdjustment *vadjustment;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+  vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (self));
+
+  if (priv->vadjustment != NULL)
+    g_signal_handlers_disconnect_by_func (priv->vadjustment, gd_main_icon_view_queue_update_pulsing_areas, self);
+
+  g_set_object (&priv->vadjustment, vadjustment);
+
+  if (priv->vadjustment != NULL)
+    g_signal_connect_swapped (priv->vadjustment, "value-changed",
+                              G_CALLBACK (gd_main_icon_view_queue_update_pulsing_areas), self);
+
+  gd_main_icon_view_queue_update_pulsing_areas (self);
+}
+
+static void
+gd_main_icon_view_size_allocate (GtkWidget *widget,
+                                 GtkAllocation *allocation)
+{
+  GTK_WIDGET_CLASS (gd_main_icon_view_parent_class)->size_allocate (widget, allocation);
+
+  /* The items may have been laid out again. */
+  gd_main_icon_view_queue_update_pulsing_areas (GD_MAIN_ICON_VIEW (widget));
+}
+
 static gboolean
 gd_main_icon_view_draw (GtkWidget *widget,
 			cairo_t   *cr)
@@ -334,6 +528,54 @@ gd_main_icon_view_draw (GtkWidget *widget,
   return FALSE;
 }
 
+static void
+gd_main_icon_view_dispose (GObject *obj)
+{
+  GdMainIconView *self = GD_MAIN_ICON_VIEW (obj);
+  GdMainIconViewPrivate *priv;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+
+  if (priv->pulse_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->pulse_tick_id);
+      priv->pulse_tick_id = 0;
+    }
+
+  if (priv->update_pulsing_areas_id != 0)
+    {
+      g_source_remove (priv->update_pulsing_areas_id);
+      priv->update_pulsing_areas_id = 0;
+    }
+
+  if (priv->model != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->model, gd_main_icon_view_queue_update_pulsing_areas, self);
+      g_clear_object (&priv->model);
+    }
+
+  if (priv->vadjustment != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment, gd_main_icon_view_queue_update_pulsing_areas, self);
+      g_clear_object (&priv->vadjustment);
+    }
+
+  G_OBJECT_CLASS (gd_main_icon_view_parent_class)->dispose (obj);
+}
+
+static void
+gd_main_icon_view_finalize (GObject *obj)
+{
+  GdMainIconView *self = GD_MAIN_ICON_VIEW (obj);
+  GdMainIconViewPrivate *priv;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+
+  g_array_unref (priv->pulsing_areas);
+
+  G_OBJECT_CLASS (gd_main_icon_view_parent_class)->finalize (obj);
+}
+
 static void
 gd_main_icon_view_class_init (GdMainIconViewClass *klass)
 {
@@ -346,8 +588,11 @@ gd_main_icon_view_class_init (GdMainIconViewClass *klass)
   binding_set = gtk_binding_set_by_class (klass);
 
   oclass->constructed = gd_main_icon_view_constructed;
+  oclass->dispose = gd_main_icon_view_dispose;
+  oclass->finalize = gd_main_icon_view_finalize;
   wclass->drag_data_get = gd_main_icon_view_drag_data_get;
   wclass->draw = gd_main_icon_view_draw;
+  wclass->size_allocate = gd_main_icon_view_size_allocate;
 
   gtk_widget_class_install_style_property (wclass,
                                            g_param_spec_int ("check-icon-size",
@@ -374,8 +619,17 @@ gd_main_icon_view_class_init (GdMainIconViewClass *klass)
 static void
 gd_main_icon_view_init (GdMainIconView *self)
 {
+  GdMainIconViewPrivate *priv;
+
+  priv = gd_main_icon_view_get_instance_private (self);
+  priv->pulsing_areas = g_array_new (FALSE, FALSE, sizeof (GdkRectangle));
+
   g_signal_connect (self, "notify::model",
 		    G_CALLBACK (set_attributes_from_model), NULL);
+  g_signal_connect (self, "notify::model",
+                    G_CALLBACK (gd_main_icon_view_set_pulse_model), NULL);
+  g_signal_connect (self, "notify::vadjustment",
+                    G_CALLBACK (gd_main_icon_view_set_pulse_vadjustment), NULL);
 }
 
 static GtkTreePath *
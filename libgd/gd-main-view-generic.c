@@ -222,32 +222,239 @@ model_get_selection_uris (GtkTreeModel *model)
   return (gchar **) g_ptr_array_free (ptr_array, FALSE);
 }
 
-static gboolean
-set_selection_foreach (GtkTreeModel *model,
-                       GtkTreePath *path,
-                       GtkTreeIter *iter,
-                       gpointer user_data)
+/* Only the top-level rows are indexed. @parents tracks which of them
+ * have children, so that the whole model is walked instead whenever
+ * there are nested rows.
+ */
+typedef struct {
+  GdIndexSet *selected;
+  GdIndexSet *parents;
+  GtkTreeModel *model;
+} SelectionInfo;
+
+static void
+selection_info_update_row (SelectionInfo *info,
+                           GtkTreePath *path,
+                           GtkTreeIter *iter)
 {
-  gboolean selection = GPOINTER_TO_INT (user_data);
-  GtkTreeModel *actual_model;
-  GtkTreeIter real_iter;
+  gboolean is_selected;
+  guint position;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  position = (guint) gtk_tree_path_get_indices (path)[0];
+
+  gtk_tree_model_get (info->model, iter,
+                      GD_MAIN_COLUMN_SELECTED, &is_selected,
+                      -1);
+
+  if (is_selected)
+    gd_index_set_add (info->selected, position);
+  else
+    gd_index_set_remove (info->selected, position);
+}
+
+static void
+on_selection_row_changed (GtkTreeModel *model,
+                          GtkTreePath *path,
+                          GtkTreeIter *iter,
+                          gpointer user_data)
+{
+  SelectionInfo *info = user_data;
+
+  selection_info_update_row (info, path, iter);
+}
+
+static void
+on_selection_row_inserted (GtkTreeModel *model,
+                           GtkTreePath *path,
+                           GtkTreeIter *iter,
+                           gpointer user_data)
+{
+  SelectionInfo *info = user_data;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  gd_index_set_splice (info->selected, (guint) gtk_tree_path_get_indices (path)[0], 0, 1);
+  gd_index_set_splice (info->parents, (guint) gtk_tree_path_get_indices (path)[0], 0, 1);
+  selection_info_update_row (info, path, iter);
+}
+
+static void
+on_selection_row_deleted (GtkTreeModel *model,
+                          GtkTreePath *path,
+                          gpointer user_data)
+{
+  SelectionInfo *info = user_data;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  gd_index_set_splice (info->selected, (guint) gtk_tree_path_get_indices (path)[0], 1, 0);
+  gd_index_set_splice (info->parents, (guint) gtk_tree_path_get_indices (path)[0], 1, 0);
+}
+
+static void
+on_selection_row_has_child_toggled (GtkTreeModel *model,
+                                    GtkTreePath *path,
+                                    GtkTreeIter *iter,
+                                    gpointer user_data)
+{
+  SelectionInfo *info = user_data;
+  guint position;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  position = (guint) gtk_tree_path_get_indices (path)[0];
+
+  if (gtk_tree_model_iter_has_child (model, iter))
+    gd_index_set_add (info->parents, position);
+  else
+    gd_index_set_remove (info->parents, position);
+}
+
+static void
+on_selection_rows_reordered (GtkTreeModel *model,
+                             GtkTreePath *path,
+                             GtkTreeIter *iter,
+                             gint *new_order,
+                             gpointer user_data)
+{
+  SelectionInfo *info = user_data;
+  gint n_rows;
+
+  if (gtk_tree_path_get_depth (path) != 0)
+    return;
+
+  n_rows = gtk_tree_model_iter_n_children (model, NULL);
+  gd_index_set_permute (info->selected, new_order, (guint) n_rows);
+  gd_index_set_permute (info->parents, new_order, (guint) n_rows);
+}
+
+static void
+selection_info_set_model (SelectionInfo *info,
+                          GtkTreeModel *model)
+{
+  GtkTreeIter iter;
+  guint position = 0;
 
-  if (GTK_IS_TREE_MODEL_FILTER (model))
+  if (info->model != NULL)
     {
-      actual_model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (model));
-      gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (model),
-                                                        &real_iter, iter);
+      g_signal_handlers_disconnect_by_func (info->model, on_selection_row_changed, info);
+      g_signal_handlers_disconnect_by_func (info->model, on_selection_row_inserted, info);
+      g_signal_handlers_disconnect_by_func (info->model, on_selection_row_deleted, info);
+      g_signal_handlers_disconnect_by_func (info->model, on_selection_row_has_child_toggled, info);
+      g_signal_handlers_disconnect_by_func (info->model, on_selection_rows_reordered, info);
     }
-  else if (GTK_IS_TREE_MODEL_SORT (model))
+
+  g_set_object (&info->model, model);
+  gd_index_set_clear (info->selected);
+  gd_index_set_clear (info->parents);
+
+  if (info->model == NULL)
+    return;
+
+  /* Read the selection once, and follow the model from then on. */
+  if (gtk_tree_model_get_iter_first (info->model, &iter))
     {
-      actual_model = gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model));
-      gtk_tree_model_sort_convert_iter_to_child_iter (GTK_TREE_MODEL_SORT (model),
-                                                      &real_iter, iter);
+      do
+        {
+          gboolean is_selected;
+
+          gtk_tree_model_get (info->model, &iter,
+                              GD_MAIN_COLUMN_SELECTED, &is_selected,
+                              -1);
+          if (is_selected)
+            gd_index_set_add (info->selected, position);
+          if (gtk_tree_model_iter_has_child (info->model, &iter))
+            gd_index_set_add (info->parents, position);
+
+          position++;
+        }
+      while (gtk_tree_model_iter_next (info->model, &iter));
     }
-  else
+
+  g_signal_connect (info->model, "row-changed",
+                    G_CALLBACK (on_selection_row_changed), info);
+  g_signal_connect (info->model, "row-inserted",
+                    G_CALLBACK (on_selection_row_inserted), info);
+  g_signal_connect (info->model, "row-deleted",
+                    G_CALLBACK (on_selection_row_deleted), info);
+  g_signal_connect (info->model, "row-has-child-toggled",
+                    G_CALLBACK (on_selection_row_has_child_toggled), info);
+  g_signal_connect (info->model, "rows-reordered",
+                    G_CALLBACK (on_selection_rows_reordered), info);
+}
+
+static void
+selection_info_destroy (SelectionInfo *info)
+{
+  selection_info_set_model (info, NULL);
+  gd_index_set_free (info->selected);
+  gd_index_set_free (info->parents);
+  g_slice_free (SelectionInfo, info);
+}
+
+static SelectionInfo *
+get_selection_info (GdMainViewGeneric *self)
+{
+  SelectionInfo *info;
+  GtkTreeModel *model;
+
+  info = g_object_get_data (G_OBJECT (self), "gd-main-view-generic-selection");
+  if (info == NULL)
+    {
+      info = g_slice_new0 (SelectionInfo);
+      info->selected = gd_index_set_new ();
+      info->parents = gd_index_set_new ();
+      g_object_set_data_full (G_OBJECT (self), "gd-main-view-generic-selection",
+                              info, (GDestroyNotify) selection_info_destroy);
+    }
+
+  model = gd_main_view_generic_get_model (self);
+  if (model != info->model)
+    selection_info_set_model (info, model);
+
+  return info;
+}
+
+static void
+set_row_selected (GtkTreeModel *model,
+                  GtkTreeIter *iter,
+                  gboolean selection)
+{
+  GtkTreeModel *actual_model;
+  GtkTreeIter real_iter;
+
+  actual_model = model;
+  real_iter = *iter;
+
+  while (GTK_IS_TREE_MODEL_FILTER (actual_model) ||
+         GTK_IS_TREE_MODEL_SORT (actual_model))
     {
-      actual_model = model;
-      real_iter = *iter;
+      GtkTreeIter child_iter;
+
+      if (GTK_IS_TREE_MODEL_FILTER (actual_model))
+        {
+          GtkTreeModelFilter *filter;
+
+          filter = GTK_TREE_MODEL_FILTER (actual_model);
+          gtk_tree_model_filter_convert_iter_to_child_iter (filter, &child_iter, &real_iter);
+          actual_model = gtk_tree_model_filter_get_model (filter);
+        }
+      else
+        {
+          GtkTreeModelSort *sort;
+
+          sort = GTK_TREE_MODEL_SORT (actual_model);
+          gtk_tree_model_sort_convert_iter_to_child_iter (sort, &child_iter, &real_iter);
+          actual_model = gtk_tree_model_sort_get_model (sort);
+        }
+
+      real_iter = child_iter;
     }
 
   if (GTK_IS_LIST_STORE (actual_model))
@@ -262,21 +469,145 @@ set_selection_foreach (GtkTreeModel *model,
                           GD_MAIN_COLUMN_SELECTED, selection,
                           -1);
     }
+}
 
+static gboolean
+set_selection_foreach (GtkTreeModel *model,
+                       GtkTreePath *path,
+                       GtkTreeIter *iter,
+                       gpointer user_data)
+{
+  set_row_selected (model, iter, GPOINTER_TO_INT (user_data));
   return FALSE;
 }
 
+static gboolean
+invert_selection_foreach (GtkTreeModel *model,
+                          GtkTreePath *path,
+                          GtkTreeIter *iter,
+                          gpointer user_data)
+{
+  gboolean is_selected;
+
+  gtk_tree_model_get (model, iter,
+                      GD_MAIN_COLUMN_SELECTED, &is_selected,
+                      -1);
+  set_row_selected (model, iter, !is_selected);
+
+  return FALSE;
+}
+
+static gboolean
+count_selection_foreach (GtkTreeModel *model,
+                         GtkTreePath *path,
+                         GtkTreeIter *iter,
+                         gpointer user_data)
+{
+  guint *n_selected = user_data;
+  gboolean is_selected;
+
+  gtk_tree_model_get (model, iter,
+                      GD_MAIN_COLUMN_SELECTED, &is_selected,
+                      -1);
+  if (is_selected)
+    (*n_selected)++;
+
+  return FALSE;
+}
+
+/* Writes GD_MAIN_COLUMN_SELECTED for the rows in @rows only, which
+ * must not be the live selection, because the writes update it.
+ */
+static void
+set_rows_selected (GtkTreeModel *model,
+                   GdIndexSet *rows,
+                   gboolean selection)
+{
+  GdIndexSetIter set_iter;
+  GtkTreeIter iter;
+  guint current = G_MAXUINT;
+  guint position;
+
+  gd_index_set_iter_init (&set_iter, rows);
+  while (gd_index_set_iter_next (&set_iter, &position))
+    {
+      if (!_gd_main_view_generic_iter_seek (model, &iter, &current, position))
+        break;
+
+      set_row_selected (model, &iter, selection);
+    }
+}
+
 static void
 set_all_selection (GdMainViewGeneric *self,
                    GtkTreeModel *model,
                    gboolean selection)
 {
-  gtk_tree_model_foreach (model,
-                          set_selection_foreach,
-                          GINT_TO_POINTER (selection));
+  SelectionInfo *info;
+  GdIndexSet *rows;
+
+  if (model == NULL)
+    return;
+
+  info = get_selection_info (self);
+  if (gd_index_set_get_size (info->parents) > 0)
+    {
+      gtk_tree_model_foreach (model,
+                              set_selection_foreach,
+                              GINT_TO_POINTER (selection));
+      goto out;
+    }
+
+  rows = gd_index_set_copy (info->selected);
+
+  /* Only touch the rows that actually flip. */
+  if (selection)
+    gd_index_set_invert (rows, (guint) gtk_tree_model_iter_n_children (model, NULL));
+
+  set_rows_selected (model, rows, selection);
+  gd_index_set_free (rows);
+
+ out:
   g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
 }
 
+static void
+set_range_selection (GdMainViewGeneric *self,
+                     guint position,
+                     guint n_items,
+                     gboolean selection)
+{
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  SelectionInfo *info;
+  gboolean changed = FALSE;
+  guint i;
+
+  model = gd_main_view_generic_get_model (self);
+  if (model == NULL || n_items == 0)
+    return;
+
+  info = get_selection_info (self);
+
+  if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, (gint) position))
+    return;
+
+  for (i = 0; i < n_items; i++)
+    {
+      if (gd_index_set_contains (info->selected, position + i) != selection)
+        {
+          set_row_selected (model, &iter, selection);
+          changed = TRUE;
+        }
+
+      if (!gtk_tree_model_iter_next (model, &iter))
+        break;
+    }
+
+  if (changed)
+    g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
+}
+
 void
 gd_main_view_generic_select_all (GdMainViewGeneric *self)
 {
@@ -293,6 +624,138 @@ gd_main_view_generic_unselect_all (GdMainViewGeneric *self)
   set_all_selection (self, model, FALSE);
 }
 
+void
+gd_main_view_generic_invert_selection (GdMainViewGeneric *self)
+{
+  GtkTreeModel *model = gd_main_view_generic_get_model (self);
+  SelectionInfo *info;
+  GdIndexSet *selected;
+  GdIndexSet *unselected;
+
+  if (model == NULL)
+    return;
+
+  info = get_selection_info (self);
+  if (gd_index_set_get_size (info->parents) > 0)
+    {
+      gtk_tree_model_foreach (model, invert_selection_foreach, NULL);
+      goto out;
+    }
+
+  selected = gd_index_set_copy (info->selected);
+  unselected = gd_index_set_copy (info->selected);
+  gd_index_set_invert (unselected, (guint) gtk_tree_model_iter_n_children (model, NULL));
+
+  set_rows_selected (model, selected, FALSE);
+  set_rows_selected (model, unselected, TRUE);
+
+  gd_index_set_free (selected);
+  gd_index_set_free (unselected);
+
+ out:
+  g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
+}
+
+void
+gd_main_view_generic_select_range (GdMainViewGeneric *self,
+                                   guint position,
+                                   guint n_items)
+{
+  set_range_selection (self, position, n_items, TRUE);
+}
+
+void
+gd_main_view_generic_unselect_range (GdMainViewGeneric *self,
+                                     guint position,
+                                     guint n_items)
+{
+  set_range_selection (self, position, n_items, FALSE);
+}
+
+/**
+ * gd_main_view_generic_get_n_selected:
+ * @self:
+ *
+ * Returns: The number of selected rows, nested ones included. This
+ * takes constant time unless the model has nested rows.
+ */
+guint
+gd_main_view_generic_get_n_selected (GdMainViewGeneric *self)
+{
+  SelectionInfo *info;
+  guint n_selected = 0;
+
+  info = get_selection_info (self);
+  if (gd_index_set_get_size (info->parents) == 0)
+    return gd_index_set_get_size (info->selected);
+
+  gtk_tree_model_foreach (info->model, count_selection_foreach, &n_selected);
+  return n_selected;
+}
+
+/**
+ * gd_main_view_generic_get_selection:
+ * @self:
+ *
+ * The positions mirror %GD_MAIN_COLUMN_SELECTED of the top-level rows,
+ * and follow the model as rows are added, removed or reordered. Nested
+ * rows are left out.
+ *
+ * Returns: (transfer none): The positions of the selected rows
+ */
+GdIndexSet *
+gd_main_view_generic_get_selection (GdMainViewGeneric *self)
+{
+  SelectionInfo *info;
+
+  info = get_selection_info (self);
+  return info->selected;
+}
+
+/* Moves @iter forward to the top-level row at @position, from the one
+ * at *@current, or from the first row if *@current is %G_MAXUINT.
+ * Seeking to increasing positions walks the model once, which unlike
+ * gtk_tree_model_iter_nth_child() is linear for a GtkTreeStore too.
+ */
+gboolean
+_gd_main_view_generic_iter_seek (GtkTreeModel *model,
+                                 GtkTreeIter *iter,
+                                 guint *current,
+                                 guint position)
+{
+  if (*current == G_MAXUINT)
+    {
+      if (!gtk_tree_model_get_iter_first (model, iter))
+        return FALSE;
+
+      *current = 0;
+    }
+
+  g_return_val_if_fail (position >= *current, FALSE);
+
+  while (*current < position)
+    {
+      if (!gtk_tree_model_iter_next (model, iter))
+        {
+          *current = G_MAXUINT;
+          return FALSE;
+        }
+
+      (*current)++;
+    }
+
+  return TRUE;
+}
+
+gboolean
+_gd_main_view_generic_has_nested_rows (GdMainViewGeneric *self)
+{
+  SelectionInfo *info;
+
+  info = get_selection_info (self);
+  return gd_index_set_get_size (info->parents) > 0;
+}
+
 void
 _gd_main_view_generic_dnd_common (GtkTreeModel *model,
                                   gboolean selection_mode,
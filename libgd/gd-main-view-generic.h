@@ -26,6 +26,8 @@
 
 #include <gtk/gtk.h>
 
+#include "gd-index-set.h"
+
 G_BEGIN_DECLS
 
 typedef enum {
@@ -99,11 +101,25 @@ GtkTreePath * gd_main_view_generic_get_path_at_pos (GdMainViewGeneric *self,
                                                     gint y);
 void gd_main_view_generic_select_all (GdMainViewGeneric *self);
 void gd_main_view_generic_unselect_all (GdMainViewGeneric *self);
+void gd_main_view_generic_invert_selection (GdMainViewGeneric *self);
+void gd_main_view_generic_select_range (GdMainViewGeneric *self,
+                                        guint position,
+                                        guint n_items);
+void gd_main_view_generic_unselect_range (GdMainViewGeneric *self,
+                                          guint position,
+                                          guint n_items);
+guint gd_main_view_generic_get_n_selected (GdMainViewGeneric *self);
+GdIndexSet * gd_main_view_generic_get_selection (GdMainViewGeneric *self);
 void gd_main_view_generic_set_rubberband_range (GdMainViewGeneric *self,
 						GtkTreePath *start,
 						GtkTreePath *end);
 
 /* private */
+gboolean _gd_main_view_generic_has_nested_rows (GdMainViewGeneric *self);
+gboolean _gd_main_view_generic_iter_seek (GtkTreeModel *model,
+                                          GtkTreeIter *iter,
+                                          guint *current,
+                                          guint position);
 void _gd_main_view_generic_dnd_common (GtkTreeModel *model,
                                        gboolean selection_mode,
                                        GtkTreePath *path,
@@ -52,12 +52,17 @@ struct _GdMainViewPrivate {
   gchar *button_press_item_path;
 
   gchar *last_selected_id;
+
+  gboolean preserve_selection;
+  gboolean restoring_selection;
+  GHashTable *selected_ids;
 };
 
 enum {
   PROP_VIEW_TYPE = 1,
   PROP_SELECTION_MODE,
   PROP_MODEL,
+  PROP_PRESERVE_SELECTION,
   NUM_PROPERTIES
 };
 
@@ -71,6 +76,8 @@ enum {
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 static guint signals[NUM_SIGNALS] = { 0, };
 
+static void gd_main_view_forget_selected_ids (GdMainView *self);
+
 G_DEFINE_TYPE_WITH_PRIVATE (GdMainView, gd_main_view, GTK_TYPE_SCROLLED_WINDOW)
 
 static void
@@ -96,6 +103,7 @@ gd_main_view_finalize (GObject *obj)
 
   g_free (priv->button_press_item_path);
   g_free (priv->last_selected_id);
+  g_hash_table_unref (priv->selected_ids);
 
   if (priv->rubberband_select_first_path)
     gtk_tree_path_free (priv->rubberband_select_first_path);
@@ -117,6 +125,10 @@ gd_main_view_init (GdMainView *self)
   /* so that we get constructed with the right view even at startup */
   priv->current_type = MAIN_VIEW_TYPE_INITIAL;
 
+  priv->selected_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_signal_connect (self, "view-selection-changed",
+                    G_CALLBACK (gd_main_view_forget_selected_ids), NULL);
+
   gtk_widget_set_hexpand (GTK_WIDGET (self), TRUE);
   gtk_widget_set_vexpand (GTK_WIDGET (self), TRUE);
   gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (self), GTK_SHADOW_IN);
@@ -147,6 +159,9 @@ gd_main_view_get_property (GObject    *object,
     case PROP_MODEL:
       g_value_set_object (value, gd_main_view_get_model (self));
       break;
+    case PROP_PRESERVE_SELECTION:
+      g_value_set_boolean (value, gd_main_view_get_preserve_selection (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -172,6 +187,9 @@ gd_main_view_set_property (GObject    *object,
     case PROP_MODEL:
       gd_main_view_set_model (self, g_value_get_object (value));
       break;
+    case PROP_PRESERVE_SELECTION:
+      gd_main_view_set_preserve_selection (self, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -217,6 +235,14 @@ gd_main_view_class_init (GdMainViewClass *klass)
                          G_PARAM_CONSTRUCT |
                          G_PARAM_STATIC_STRINGS);
 
+  properties[PROP_PRESERVE_SELECTION] =
+    g_param_spec_boolean ("preserve-selection",
+                          "Preserve selection",
+                          "Whether the selection is kept across model changes by row ID",
+                          FALSE,
+                          G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS);
+
   signals[ITEM_ACTIVATED] =
     g_signal_new ("item-activated",
                   GD_TYPE_MAIN_VIEW,
@@ -318,6 +344,104 @@ do_select_row (GdMainView *self,
     }
 }
 
+/* The IDs are only saved when the model is about to be replaced, and
+ * carried over to the new model and to the rows inserted into it.
+ */
+static void
+gd_main_view_save_selected_ids (GdMainView *self)
+{
+  GdMainViewPrivate *priv;
+  GdMainViewGeneric *generic = get_generic (self);
+  GdIndexSet *selection;
+  GdIndexSetIter set_iter;
+  GtkTreeIter iter;
+  guint current = G_MAXUINT;
+  guint position;
+
+  priv = gd_main_view_get_instance_private (self);
+
+  if (!priv->preserve_selection || priv->model == NULL || generic == NULL)
+    return;
+
+  selection = gd_main_view_generic_get_selection (generic);
+
+  gd_index_set_iter_init (&set_iter, selection);
+  while (gd_index_set_iter_next (&set_iter, &position))
+    {
+      gchar *id;
+
+      if (!_gd_main_view_generic_iter_seek (priv->model, &iter, &current, position))
+        break;
+
+      gtk_tree_model_get (priv->model, &iter,
+                          GD_MAIN_COLUMN_ID, &id,
+                          -1);
+      if (id != NULL)
+        g_hash_table_add (priv->selected_ids, id);
+    }
+}
+
+/* Changes that the user makes replace whatever was saved. */
+static void
+gd_main_view_forget_selected_ids (GdMainView *self)
+{
+  GdMainViewPrivate *priv;
+
+  priv = gd_main_view_get_instance_private (self);
+
+  if (priv->restoring_selection)
+    return;
+
+  g_hash_table_remove_all (priv->selected_ids);
+}
+
+static void
+gd_main_view_restore_selected_ids (GdMainView *self)
+{
+  GdMainViewPrivate *priv;
+  GtkTreeIter iter;
+  gboolean changed = FALSE;
+
+  priv = gd_main_view_get_instance_private (self);
+
+  if (!priv->preserve_selection ||
+      !priv->selection_mode ||
+      priv->model == NULL ||
+      g_hash_table_size (priv->selected_ids) == 0)
+    return;
+
+  if (!gtk_tree_model_get_iter_first (priv->model, &iter))
+    return;
+
+  /* One pass over the new model against the saved IDs. */
+  do
+    {
+      gboolean is_selected;
+      gchar *id;
+
+      gtk_tree_model_get (priv->model, &iter,
+                          GD_MAIN_COLUMN_ID, &id,
+                          GD_MAIN_COLUMN_SELECTED, &is_selected,
+                          -1);
+
+      if (!is_selected && id != NULL && g_hash_table_contains (priv->selected_ids, id))
+        {
+          do_select_row (self, &iter, TRUE);
+          changed = TRUE;
+        }
+
+      g_free (id);
+    }
+  while (gtk_tree_model_iter_next (priv->model, &iter));
+
+  if (changed)
+    {
+      priv->restoring_selection = TRUE;
+      g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
+      priv->restoring_selection = FALSE;
+    }
+}
+
 static void
 selection_mode_do_select_range (GdMainView *self,
                                 GtkTreeIter *first_element,
@@ -360,14 +484,54 @@ selection_mode_do_select_range (GdMainView *self,
   gtk_tree_path_free (last_path);
 }
 
+/* Nested rows are not indexed, so look for the nearest selected
+ * sibling, backwards first.
+ */
+static gboolean
+find_selected_sibling (GtkTreeModel *model,
+                       GtkTreeIter *iter,
+                       GtkTreeIter *out_other)
+{
+  GtkTreeIter other;
+  gboolean selected;
+
+  other = *iter;
+  while (gtk_tree_model_iter_previous (model, &other))
+    {
+      gtk_tree_model_get (model, &other,
+                          GD_MAIN_COLUMN_SELECTED, &selected,
+                          -1);
+      if (selected)
+        goto found;
+    }
+
+  other = *iter;
+  while (gtk_tree_model_iter_next (model, &other))
+    {
+      gtk_tree_model_get (model, &other,
+                          GD_MAIN_COLUMN_SELECTED, &selected,
+                          -1);
+      if (selected)
+        goto found;
+    }
+
+  return FALSE;
+
+ found:
+  *out_other = other;
+  return TRUE;
+}
+
 static void
 selection_mode_select_range (GdMainView *self,
                              GtkTreeIter *iter)
 {
   GdMainViewPrivate *priv;
+  GdIndexSet *selection;
   GtkTreeIter other;
+  GtkTreePath *path;
   gboolean found = FALSE;
-  gboolean selected;
+  guint other_position;
   char *id;
 
   priv = gd_main_view_get_instance_private (self);
@@ -391,39 +555,26 @@ selection_mode_select_range (GdMainView *self,
       while (gtk_tree_model_iter_next (priv->model, &other));
     }
 
-  if (!found)
+  /* Otherwise, extend from the nearest selected row, looking
+   * backwards first.
+   */
+  path = gtk_tree_model_get_path (priv->model, iter);
+  if (!found && path != NULL && gtk_tree_path_get_depth (path) == 1)
     {
-      other = *iter;
-      while (gtk_tree_model_iter_previous (priv->model, &other))
-	{
-	  gtk_tree_model_get (priv->model, &other,
-			      GD_MAIN_COLUMN_SELECTED, &selected,
-			      -1);
+      guint position = (guint) gtk_tree_path_get_indices (path)[0];
 
-	  if (selected)
-	    {
-	      found = TRUE;
-	      break;
-	    }
-	}
+      selection = gd_main_view_generic_get_selection (get_generic (self));
+      if (gd_index_set_get_previous (selection, position, &other_position) ||
+          gd_index_set_get_next (selection, position, &other_position))
+        found = gtk_tree_model_iter_nth_child (priv->model, &other, NULL, (gint) other_position);
     }
-
-  if (!found)
+  else if (!found)
     {
-      other = *iter;
-      while (gtk_tree_model_iter_next (priv->model, &other))
-	{
-	  gtk_tree_model_get (priv->model, &other,
-			      GD_MAIN_COLUMN_SELECTED, &selected,
-			      -1);
-	  if (selected)
-	    {
-	      found = TRUE;
-	      break;
-	    }
-	}
+      found = find_selected_sibling (priv->model, iter, &other);
     }
 
+  gtk_tree_path_free (path);
+
   if (found)
     selection_mode_do_select_range (self, iter, &other);
   else
@@ -661,8 +812,7 @@ on_button_press_event (GtkWidget *view,
   GdMainViewPrivate *priv;
   GdMainViewGeneric *generic = get_generic (self);
   GtkTreePath *path;
-  GList *selection, *l;
-  GtkTreePath *sel_path;
+  GtkTreeIter iter;
   gboolean found = FALSE;
   gboolean force_selection;
 
@@ -680,22 +830,12 @@ on_button_press_event (GtkWidget *view,
       return FALSE;
     }
 
-  if (path && !force_selection)
+  if (path && !force_selection &&
+      gtk_tree_model_get_iter (priv->model, &iter, path))
     {
-      selection = gd_main_view_get_selection (self);
-
-      for (l = selection; l != NULL; l = l->next)
-	{
-	  sel_path = l->data;
-	  if (gtk_tree_path_compare (path, sel_path) == 0)
-	    {
-	      found = TRUE;
-	      break;
-	    }
-	}
-
-      if (selection != NULL)
-	g_list_free_full (selection, (GDestroyNotify) gtk_tree_path_free);
+      gtk_tree_model_get (priv->model, &iter,
+                          GD_MAIN_COLUMN_SELECTED, &found,
+                          -1);
     }
 
   /* if we did not find the item in the selection, block
@@ -814,24 +954,26 @@ on_drag_begin (GdMainViewGeneric *generic,
       if (priv->selection_mode &&
           surface != NULL)
         {
-          GList *selection;
+          guint n_selected;
           cairo_surface_t *counter;
 
-          selection = gd_main_view_get_selection (self);
+          n_selected = gd_main_view_get_n_selected (self);
 
-          if (g_list_length (selection) > 1)
+          if (n_selected > 1)
             {
-              counter = gd_create_surface_with_counter (GTK_WIDGET (self), surface, g_list_length (selection));
+              counter = gd_create_surface_with_counter (GTK_WIDGET (self), surface, n_selected);
               cairo_surface_destroy (surface);
               surface = counter;
             }
-
-          if (selection != NULL)
-            g_list_free_full (selection, (GDestroyNotify) gtk_tree_path_free);
         }
 
       if (surface != NULL)
         {
+          cairo_surface_t *image = surface;
+
+          surface = gd_copy_image_surface_for_window (image, gtk_widget_get_window (GTK_WIDGET (self)));
+          cairo_surface_destroy (image);
+
           cairo_surface_set_device_offset (surface,
                                            -MAIN_VIEW_DND_ICON_OFFSET,
                                            -MAIN_VIEW_DND_ICON_OFFSET);
@@ -898,8 +1040,51 @@ on_row_deleted_cb (GtkTreeModel *model,
                    gpointer user_data)
 {
   GdMainView *self = user_data;
+  GdMainViewPrivate *priv;
+
+  priv = gd_main_view_get_instance_private (self);
 
+  /* The ID of a deleted row can't be read any more, but the IDs that
+   * were saved stay for the rows that are still to be inserted.
+   */
+  priv->restoring_selection = TRUE;
   g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
+  priv->restoring_selection = FALSE;
+}
+
+static void
+on_row_inserted_cb (GtkTreeModel *model,
+                    GtkTreePath *path,
+                    GtkTreeIter *iter,
+                    gpointer user_data)
+{
+  GdMainView *self = user_data;
+  GdMainViewPrivate *priv;
+  gboolean is_selected;
+  gchar *id;
+
+  priv = gd_main_view_get_instance_private (self);
+
+  if (!priv->preserve_selection ||
+      !priv->selection_mode ||
+      g_hash_table_size (priv->selected_ids) == 0)
+    return;
+
+  gtk_tree_model_get (model, iter,
+                      GD_MAIN_COLUMN_ID, &id,
+                      GD_MAIN_COLUMN_SELECTED, &is_selected,
+                      -1);
+
+  if (!is_selected && id != NULL && g_hash_table_contains (priv->selected_ids, id))
+    {
+      do_select_row (self, iter, TRUE);
+
+      priv->restoring_selection = TRUE;
+      g_signal_emit (self, signals[VIEW_SELECTION_CHANGED], 0);
+      priv->restoring_selection = FALSE;
+    }
+
+  g_free (id);
 }
 
 static void
@@ -925,6 +1110,7 @@ gd_main_view_apply_selection_mode (GdMainView *self)
   if (!priv->selection_mode)
     {
       g_clear_pointer (&priv->last_selected_id, g_free);
+      g_hash_table_remove_all (priv->selected_ids);
       if (priv->model != NULL)
         gd_main_view_unselect_all (self);
     }
@@ -1052,8 +1238,13 @@ gd_main_view_set_model (GdMainView *self,
   if (model != priv->model)
     {
       if (priv->model)
-        g_signal_handlers_disconnect_by_func (priv->model,
-                                              on_row_deleted_cb, self);
+        {
+          gd_main_view_save_selected_ids (self);
+          g_signal_handlers_disconnect_by_func (priv->model,
+                                                on_row_deleted_cb, self);
+          g_signal_handlers_disconnect_by_func (priv->model,
+                                                on_row_inserted_cb, self);
+        }
 
       g_clear_object (&priv->model);
 
@@ -1062,6 +1253,9 @@ gd_main_view_set_model (GdMainView *self,
           priv->model = g_object_ref (model);
           g_signal_connect (priv->model, "row-deleted",
                             G_CALLBACK (on_row_deleted_cb), self);
+          /* After the views have seen the row. */
+          g_signal_connect_after (priv->model, "row-inserted",
+                                  G_CALLBACK (on_row_inserted_cb), self);
         }
       else
         {
@@ -1069,10 +1263,48 @@ gd_main_view_set_model (GdMainView *self,
         }
 
       gd_main_view_apply_model (self);
+      gd_main_view_restore_selected_ids (self);
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEL]);
     }
 }
 
+/**
+ * gd_main_view_set_preserve_selection:
+ * @self:
+ * @preserve_selection:
+ *
+ * Whether the selection is remembered by %GD_MAIN_COLUMN_ID, and
+ * carried over to the rows with the same ID when the model is
+ * replaced, including rows inserted into the new model later on.
+ */
+void
+gd_main_view_set_preserve_selection (GdMainView *self,
+                                     gboolean preserve_selection)
+{
+  GdMainViewPrivate *priv;
+
+  priv = gd_main_view_get_instance_private (self);
+
+  if (preserve_selection != priv->preserve_selection)
+    {
+      priv->preserve_selection = preserve_selection;
+
+      if (!priv->preserve_selection)
+        g_hash_table_remove_all (priv->selected_ids);
+
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PRESERVE_SELECTION]);
+    }
+}
+
+gboolean
+gd_main_view_get_preserve_selection (GdMainView *self)
+{
+  GdMainViewPrivate *priv;
+
+  priv = gd_main_view_get_instance_private (self);
+  return priv->preserve_selection;
+}
+
 /**
  * gd_main_view_get_model:
  * @self:
@@ -1131,18 +1363,53 @@ build_selection_list_foreach (GtkTreeModel *model,
 GList *
 gd_main_view_get_selection (GdMainView *self)
 {
-  GdMainViewPrivate *priv;
+  GdMainViewGeneric *generic = get_generic (self);
+  GdIndexSet *selection;
+  GdIndexSetIter iter;
   GList *retval = NULL;
+  guint position;
 
-  priv = gd_main_view_get_instance_private (self);
+  if (generic == NULL)
+    return NULL;
+
+  if (_gd_main_view_generic_has_nested_rows (generic))
+    {
+      GtkTreeModel *model = gd_main_view_generic_get_model (generic);
+
+      gtk_tree_model_foreach (model,
+                              build_selection_list_foreach,
+                              &retval);
+      goto out;
+    }
 
-  gtk_tree_model_foreach (priv->model,
-                          build_selection_list_foreach,
-                          &retval);
+  selection = gd_main_view_generic_get_selection (generic);
 
+  gd_index_set_iter_init (&iter, selection);
+  while (gd_index_set_iter_next (&iter, &position))
+    retval = g_list_prepend (retval, gtk_tree_path_new_from_indices ((gint) position, -1));
+
+ out:
   return g_list_reverse (retval);
 }
 
+/**
+ * gd_main_view_get_n_selected:
+ * @self:
+ *
+ * Returns: The number of selected rows, without building the list
+ * returned by gd_main_view_get_selection().
+ */
+guint
+gd_main_view_get_n_selected (GdMainView *self)
+{
+  GdMainViewGeneric *generic = get_generic (self);
+
+  if (generic == NULL)
+    return 0;
+
+  return gd_main_view_generic_get_n_selected (generic);
+}
+
 void
 gd_main_view_select_all (GdMainView *self)
 {
@@ -1158,3 +1425,11 @@ gd_main_view_unselect_all (GdMainView *self)
 
   gd_main_view_generic_unselect_all (generic);
 }
+
+void
+gd_main_view_invert_selection (GdMainView *self)
+{
+  GdMainViewGeneric *generic = get_generic (self);
+
+  gd_main_view_generic_invert_selection (generic);
+}
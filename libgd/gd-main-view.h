@@ -50,14 +50,20 @@ void gd_main_view_set_selection_mode (GdMainView *self,
 gboolean gd_main_view_get_selection_mode (GdMainView *self);
 
 GList * gd_main_view_get_selection (GdMainView *self);
+guint gd_main_view_get_n_selected (GdMainView *self);
 
 void gd_main_view_select_all (GdMainView *self);
 void gd_main_view_unselect_all (GdMainView *self);
+void gd_main_view_invert_selection (GdMainView *self);
 
 GtkTreeModel * gd_main_view_get_model (GdMainView *self);
 void gd_main_view_set_model (GdMainView *self,
                              GtkTreeModel *model);
 
+void gd_main_view_set_preserve_selection (GdMainView *self,
+                                          gboolean preserve_selection);
+gboolean gd_main_view_get_preserve_selection (GdMainView *self);
+
 GtkWidget * gd_main_view_get_generic_view (GdMainView *self);
 
 G_END_DECLS
@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gd-icon-utils.h"
+#include "gd-surface-cache.h"
+
+/* Zoomed copies of image surfaces, shared by everything that shows
+ * the same source surface at the same size. Placeholder icons are
+ * typically used by a lot of items at once, and this lets them be
+ * zoomed only once.
+ *
+ * The cache does not keep the source surfaces alive. The entries for
+ * a source are dropped when it is destroyed, so a new surface that
+ * ends up at the same address can't pick up stale copies.
+ */
+
+#define SURFACE_CACHE_DEFAULT_MAX_SIZE (64 * 1024 * 1024)
+
+typedef struct _GdSurfaceCacheEntry GdSurfaceCacheEntry;
+typedef struct _GdSurfaceCacheKey GdSurfaceCacheKey;
+typedef struct _GdSurfaceCacheSource GdSurfaceCacheSource;
+typedef struct _GdSurfaceCacheZoomData GdSurfaceCacheZoomData;
+
+struct _GdSurfaceCacheKey
+{
+  cairo_surface_t *surface;
+  gdouble scale_x;
+  gdouble scale_y;
+  gint height;
+  gint width;
+};
+
+struct _GdSurfaceCacheEntry
+{
+  GdSurfaceCacheKey key;
+  GdSurfaceCacheSource *source;
+  GList link;
+  cairo_surface_t *zoomed;
+  gsize size;
+};
+
+struct _GdSurfaceCacheSource
+{
+  GdSurfaceCache *cache;
+  GList *entries;
+};
+
+struct _GdSurfaceCacheZoomData
+{
+  GdSurfaceCache *cache;
+  cairo_surface_t *surface;
+  gint height_zoomed;
+  gint width_zoomed;
+};
+
+struct _GdSurfaceCache
+{
+  GHashTable *entries;
+  GMutex mutex;
+  GQueue lru;
+  gsize max_size;
+  gsize size;
+  guint hits;
+  guint misses;
+};
+
+static const cairo_user_data_key_t source_key;
+
+static guint
+gd_surface_cache_key_hash (gconstpointer data)
+{
+  const GdSurfaceCacheKey *key = data;
+  guint hash;
+
+  hash = g_direct_hash (key->surface);
+  hash = hash * 31 + (guint) key->width;
+  hash = hash * 31 + (guint) key->height;
+  return hash;
+}
+
+static gboolean
+gd_surface_cache_key_equal (gconstpointer a, gconstpointer b)
+{
+  const GdSurfaceCacheKey *key_a = a;
+  const GdSurfaceCacheKey *key_b = b;
+
+  return key_a->surface == key_b->surface
+         && key_a->width == key_b->width
+         && key_a->height == key_b->height
+         && key_a->scale_x == key_b->scale_x
+         && key_a->scale_y == key_b->scale_y;
+}
+
+/* The surfaces that are removed are collected in @garbage, to be
+ * destroyed once the lock is released. Destroying the last reference
+ * to a surface that is itself a source in the cache would otherwise
+ * take the lock again from gd_surface_cache_source_destroyed().
+ */
+static GPtrArray *
+gd_surface_cache_garbage_new (void)
+{
+  return g_ptr_array_new_with_free_func ((GDestroyNotify) cairo_surface_destroy);
+}
+
+static void
+gd_surface_cache_remove_entry (GdSurfaceCache *cache, GdSurfaceCacheEntry *entry, GPtrArray *garbage)
+{
+  g_hash_table_remove (cache->entries, &entry->key);
+  g_queue_unlink (&cache->lru, &entry->link);
+  entry->source->entries = g_list_remove (entry->source->entries, entry);
+  cache->size -= entry->size;
+
+  g_ptr_array_add (garbage, entry->zoomed);
+  g_slice_free (GdSurfaceCacheEntry, entry);
+}
+
+static void
+gd_surface_cache_remove_source_entries (GdSurfaceCache *cache, GdSurfaceCacheSource *source, GPtrArray *garbage)
+{
+  while (source->entries != NULL)
+    gd_surface_cache_remove_entry (cache, source->entries->data, garbage);
+}
+
+static void
+gd_surface_cache_init_key (GdSurfaceCacheKey *key,
+                           cairo_surface_t   *surface,
+                           gint               width_zoomed,
+                           gint               height_zoomed)
+{
+  key->surface = surface;
+  key->height = height_zoomed;
+  key->width = width_zoomed;
+  cairo_surface_get_device_scale (surface, &key->scale_x, &key->scale_y);
+}
+
+static cairo_surface_t *
+gd_surface_cache_lookup_locked (GdSurfaceCache *cache, GdSurfaceCacheKey *key)
+{
+  GdSurfaceCacheEntry *entry;
+
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (entry == NULL)
+    return NULL;
+
+  cache->hits++;
+  g_queue_unlink (&cache->lru, &entry->link);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+  return cairo_surface_reference (entry->zoomed);
+}
+
+static void
+gd_surface_cache_trim (GdSurfaceCache *cache, GPtrArray *garbage)
+{
+  while (cache->size > cache->max_size && cache->lru.tail != NULL)
+    gd_surface_cache_remove_entry (cache, cache->lru.tail->data, garbage);
+}
+
+static void
+gd_surface_cache_source_destroyed (gpointer data)
+{
+  GdSurfaceCacheSource *source = data;
+  GdSurfaceCache *cache = source->cache;
+  GPtrArray *garbage;
+
+  garbage = gd_surface_cache_garbage_new ();
+
+  g_mutex_lock (&cache->mutex);
+  gd_surface_cache_remove_source_entries (cache, source, garbage);
+  g_mutex_unlock (&cache->mutex);
+
+  g_ptr_array_unref (garbage);
+  g_slice_free (GdSurfaceCacheSource, source);
+}
+
+static void
+gd_surface_cache_zoom_data_free (GdSurfaceCacheZoomData *data)
+{
+  cairo_surface_destroy (data->surface);
+  g_slice_free (GdSurfaceCacheZoomData, data);
+}
+
+static void
+gd_surface_cache_zoom_thread (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  GdSurfaceCacheZoomData *data = task_data;
+  cairo_surface_t *zoomed;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  zoomed = gd_surface_cache_get_zoomed (data->cache, data->surface, data->width_zoomed, data->height_zoomed);
+  g_task_return_pointer (task, zoomed, (GDestroyNotify) cairo_surface_destroy);
+}
+
+static GdSurfaceCacheSource *
+gd_surface_cache_get_source (GdSurfaceCache *cache, cairo_surface_t *surface)
+{
+  GdSurfaceCacheSource *source;
+
+  source = cairo_surface_get_user_data (surface, &source_key);
+  if (source != NULL)
+    goto out;
+
+  source = g_slice_new0 (GdSurfaceCacheSource);
+  source->cache = cache;
+  if (cairo_surface_set_user_data (surface, &source_key, source, gd_surface_cache_source_destroyed) != CAIRO_STATUS_SUCCESS)
+    {
+      g_slice_free (GdSurfaceCacheSource, source);
+      source = NULL;
+    }
+
+ out:
+  return source;
+}
+
+/**
+ * gd_surface_cache_get_default:
+ *
+ * Returns: (transfer none): The #GdSurfaceCache shared by the whole
+ * process.
+ */
+GdSurfaceCache *
+gd_surface_cache_get_default (void)
+{
+  static GdSurfaceCache *cache;
+
+  if (g_once_init_enter (&cache))
+    {
+      GdSurfaceCache *new_cache;
+
+      new_cache = g_slice_new0 (GdSurfaceCache);
+      new_cache->entries = g_hash_table_new (gd_surface_cache_key_hash, gd_surface_cache_key_equal);
+      new_cache->max_size = SURFACE_CACHE_DEFAULT_MAX_SIZE;
+      g_mutex_init (&new_cache->mutex);
+      g_queue_init (&new_cache->lru);
+
+      g_once_init_leave (&cache, new_cache);
+    }
+
+  return cache;
+}
+
+void
+gd_surface_cache_clear (GdSurfaceCache *cache)
+{
+  GPtrArray *garbage;
+
+  g_return_if_fail (cache != NULL);
+
+  garbage = gd_surface_cache_garbage_new ();
+
+  g_mutex_lock (&cache->mutex);
+
+  while (cache->lru.head != NULL)
+    gd_surface_cache_remove_entry (cache, cache->lru.head->data, garbage);
+
+  g_mutex_unlock (&cache->mutex);
+
+  g_ptr_array_unref (garbage);
+}
+
+gsize
+gd_surface_cache_get_max_size (GdSurfaceCache *cache)
+{
+  g_return_val_if_fail (cache != NULL, 0);
+  return cache->max_size;
+}
+
+/**
+ * gd_surface_cache_get_stats:
+ * @cache:
+ * @out_hits: (out) (optional):
+ * @out_misses: (out) (optional):
+ * @out_size: (out) (optional):
+ *
+ * Retrieves the number of lookups that were answered from @cache and
+ * the number of ones that required zooming, along with the number of
+ * bytes currently held by @cache.
+ */
+void
+gd_surface_cache_get_stats (GdSurfaceCache *cache, guint *out_hits, guint *out_misses, gsize *out_size)
+{
+  g_return_if_fail (cache != NULL);
+
+  g_mutex_lock (&cache->mutex);
+
+  if (out_hits != NULL)
+    *out_hits = cache->hits;
+
+  if (out_misses != NULL)
+    *out_misses = cache->misses;
+
+  if (out_size != NULL)
+    *out_size = cache->size;
+
+  g_mutex_unlock (&cache->mutex);
+}
+
+/**
+ * gd_surface_cache_get_zoomed:
+ * @cache:
+ * @surface: an image surface
+ * @width_zoomed:
+ * @height_zoomed:
+ *
+ * Looks up a copy of @surface zoomed to @width_zoomed x
+ * @height_zoomed, and creates it with gd_zoom_image_surface() if
+ * there isn't one yet.
+ *
+ * Returns: (transfer full): The zoomed surface.
+ */
+cairo_surface_t *
+gd_surface_cache_get_zoomed (GdSurfaceCache  *cache,
+                             cairo_surface_t *surface,
+                             gint             width_zoomed,
+                             gint             height_zoomed)
+{
+  GdSurfaceCacheEntry *entry;
+  GdSurfaceCacheKey key;
+  GdSurfaceCacheSource *source;
+  GPtrArray *garbage;
+  cairo_surface_t *ret_val = NULL;
+  cairo_surface_t *zoomed;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (surface != NULL, NULL);
+  g_return_val_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE, NULL);
+
+  gd_surface_cache_init_key (&key, surface, width_zoomed, height_zoomed);
+
+  g_mutex_lock (&cache->mutex);
+
+  ret_val = gd_surface_cache_lookup_locked (cache, &key);
+  if (ret_val != NULL)
+    {
+      g_mutex_unlock (&cache->mutex);
+      goto out;
+    }
+
+  cache->misses++;
+  g_mutex_unlock (&cache->mutex);
+
+  /* Zooming can take a while, so it is done without holding the
+   * lock. If somebody else got there first, theirs is kept.
+   */
+  zoomed = gd_zoom_image_surface (surface, width_zoomed, height_zoomed);
+  ret_val = zoomed;
+  garbage = gd_surface_cache_garbage_new ();
+
+  g_mutex_lock (&cache->mutex);
+
+  if (g_hash_table_contains (cache->entries, &key))
+    goto unlock;
+
+  source = gd_surface_cache_get_source (cache, surface);
+  if (source == NULL)
+    goto unlock;
+
+  entry = g_slice_new0 (GdSurfaceCacheEntry);
+  entry->key = key;
+  entry->link.data = entry;
+  entry->source = source;
+  entry->zoomed = cairo_surface_reference (zoomed);
+  entry->size = (gsize) cairo_image_surface_get_stride (zoomed) * (gsize) cairo_image_surface_get_height (zoomed);
+
+  g_hash_table_insert (cache->entries, &entry->key, entry);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+  source->entries = g_list_prepend (source->entries, entry);
+  cache->size += entry->size;
+
+  gd_surface_cache_trim (cache, garbage);
+
+ unlock:
+  g_mutex_unlock (&cache->mutex);
+  g_ptr_array_unref (garbage);
+
+ out:
+  return ret_val;
+}
+
+/**
+ * gd_surface_cache_get_zoomed_async:
+ * @cache:
+ * @surface: an image surface
+ * @width_zoomed:
+ * @height_zoomed:
+ * @cancellable: (nullable):
+ * @callback:
+ * @user_data:
+ *
+ * Like gd_surface_cache_get_zoomed(), but zooms in a worker thread.
+ * @surface must not be modified until @callback has been invoked.
+ */
+void
+gd_surface_cache_get_zoomed_async (GdSurfaceCache      *cache,
+                                   cairo_surface_t     *surface,
+                                   gint                 width_zoomed,
+                                   gint                 height_zoomed,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  GTask *task;
+  GdSurfaceCacheZoomData *data;
+
+  g_return_if_fail (cache != NULL);
+  g_return_if_fail (surface != NULL);
+  g_return_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  data = g_slice_new0 (GdSurfaceCacheZoomData);
+  data->cache = cache;
+  data->surface = cairo_surface_reference (surface);
+  data->height_zoomed = height_zoomed;
+  data->width_zoomed = width_zoomed;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gd_surface_cache_get_zoomed_async);
+  g_task_set_task_data (task, data, (GDestroyNotify) gd_surface_cache_zoom_data_free);
+  g_task_run_in_thread (task, gd_surface_cache_zoom_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gd_surface_cache_get_zoomed_finish:
+ * @cache:
+ * @res:
+ * @error:
+ *
+ * Returns: (transfer full): The zoomed surface, or %NULL if the
+ * operation was cancelled.
+ */
+cairo_surface_t *
+gd_surface_cache_get_zoomed_finish (GdSurfaceCache *cache, GAsyncResult *res, GError **error)
+{
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (g_task_is_valid (res, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (res)) == gd_surface_cache_get_zoomed_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * gd_surface_cache_invalidate:
+ * @cache:
+ * @surface:
+ *
+ * Drops all the zoomed copies of @surface. This is only needed if
+ * the contents of @surface were changed in place.
+ */
+void
+gd_surface_cache_invalidate (GdSurfaceCache *cache, cairo_surface_t *surface)
+{
+  GdSurfaceCacheSource *source;
+  GPtrArray *garbage;
+
+  g_return_if_fail (cache != NULL);
+  g_return_if_fail (surface != NULL);
+
+  garbage = gd_surface_cache_garbage_new ();
+
+  g_mutex_lock (&cache->mutex);
+
+  source = cairo_surface_get_user_data (surface, &source_key);
+  if (source != NULL)
+    gd_surface_cache_remove_source_entries (cache, source, garbage);
+
+  g_mutex_unlock (&cache->mutex);
+
+  g_ptr_array_unref (garbage);
+}
+
+/**
+ * gd_surface_cache_set_max_size:
+ * @cache:
+ * @max_size: the budget in bytes
+ *
+ * Sets the number of bytes that @cache can hold on to. Once it goes
+ * over, the least recently used surfaces are dropped first.
+ */
+void
+gd_surface_cache_set_max_size (GdSurfaceCache *cache, gsize max_size)
+{
+  GPtrArray *garbage;
+
+  g_return_if_fail (cache != NULL);
+
+  garbage = gd_surface_cache_garbage_new ();
+
+  g_mutex_lock (&cache->mutex);
+
+  cache->max_size = max_size;
+  gd_surface_cache_trim (cache, garbage);
+
+  g_mutex_unlock (&cache->mutex);
+
+  g_ptr_array_unref (garbage);
+}
+
+/**
+ * gd_surface_cache_lookup:
+ * @cache:
+ * @surface: an image surface
+ * @width_zoomed:
+ * @height_zoomed:
+ *
+ * Looks up a copy of @surface zoomed to @width_zoomed x
+ * @height_zoomed, without creating it.
+ *
+ * Returns: (transfer full) (nullable): The zoomed surface, or %NULL
+ * if it is not in @cache.
+ */
+cairo_surface_t *
+gd_surface_cache_lookup (GdSurfaceCache  *cache,
+                         cairo_surface_t *surface,
+                         gint             width_zoomed,
+                         gint             height_zoomed)
+{
+  GdSurfaceCacheKey key;
+  cairo_surface_t *ret_val;
+
+  g_return_val_if_fail (cache != NULL, NULL);
+  g_return_val_if_fail (surface != NULL, NULL);
+
+  gd_surface_cache_init_key (&key, surface, width_zoomed, height_zoomed);
+
+  g_mutex_lock (&cache->mutex);
+  ret_val = gd_surface_cache_lookup_locked (cache, &key);
+  g_mutex_unlock (&cache->mutex);
+
+  return ret_val;
+}
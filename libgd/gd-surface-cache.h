@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GD_SURFACE_CACHE_H__
+#define __GD_SURFACE_CACHE_H__
+
+#include <cairo.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdSurfaceCache GdSurfaceCache;
+
+GdSurfaceCache  * gd_surface_cache_get_default    (void);
+
+void              gd_surface_cache_clear          (GdSurfaceCache *cache);
+gsize             gd_surface_cache_get_max_size   (GdSurfaceCache *cache);
+void              gd_surface_cache_get_stats      (GdSurfaceCache *cache,
+                                                   guint          *out_hits,
+                                                   guint          *out_misses,
+                                                   gsize          *out_size);
+cairo_surface_t * gd_surface_cache_get_zoomed     (GdSurfaceCache  *cache,
+                                                   cairo_surface_t *surface,
+                                                   gint             width_zoomed,
+                                                   gint             height_zoomed);
+void              gd_surface_cache_get_zoomed_async   (GdSurfaceCache      *cache,
+                                                       cairo_surface_t     *surface,
+                                                       gint                 width_zoomed,
+                                                       gint                 height_zoomed,
+                                                       GCancellable        *cancellable,
+                                                       GAsyncReadyCallback  callback,
+                                                       gpointer             user_data);
+cairo_surface_t * gd_surface_cache_get_zoomed_finish  (GdSurfaceCache  *cache,
+                                                       GAsyncResult    *res,
+                                                       GError         **error);
+void              gd_surface_cache_invalidate     (GdSurfaceCache  *cache,
+                                                   cairo_surface_t *surface);
+cairo_surface_t * gd_surface_cache_lookup         (GdSurfaceCache  *cache,
+                                                   cairo_surface_t *surface,
+                                                   gint             width_zoomed,
+                                                   gint             height_zoomed);
+void              gd_surface_cache_set_max_size   (GdSurfaceCache *cache, gsize max_size);
+
+G_END_DECLS
+
+#endif /* __GD_SURFACE_CACHE_H__ */
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gd-icon-utils.h"
+#include "gd-symbolic-icon-factory.h"
+
+/* Rendering a symbolic placeholder icon involves a style context, an
+ * icon theme lookup, and loading and recoloring an SVG. The factory
+ * does that once for every name, size and scale, and hands out the
+ * same surface after that. The GIcons are converted from the surfaces,
+ * and are cached separately.
+ *
+ * Everything that the icons depend on, the icon theme and the style,
+ * is tracked by a generation counter. When either changes, the cached
+ * icons are dropped, and so are any pre-warmed icons still being
+ * rendered for the previous generation. The style context emits
+ * "changed" for the GTK+ theme as well as for CSS providers that the
+ * application adds later on.
+ */
+
+typedef struct _GdSymbolicIconFactoryPrewarmData GdSymbolicIconFactoryPrewarmData;
+
+struct _GdSymbolicIconFactory
+{
+  GObject parent_instance;
+  GHashTable *icons;
+  GHashTable *surfaces;
+  GtkIconTheme *theme;
+  GtkStyleContext *style;
+  guint generation;
+};
+
+struct _GdSymbolicIconFactoryPrewarmData
+{
+  gchar **names;
+  gint base_size;
+  gint scale;
+  guint generation;
+  guint index;
+};
+
+enum
+{
+  PROP_ICON_THEME = 1,
+  NUM_PROPERTIES
+};
+
+enum
+{
+  CHANGED,
+  NUM_SIGNALS
+};
+
+static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
+static guint signals[NUM_SIGNALS] = { 0, };
+
+G_DEFINE_TYPE (GdSymbolicIconFactory, gd_symbolic_icon_factory, G_TYPE_OBJECT)
+
+static gchar *
+gd_symbolic_icon_factory_create_key (const gchar *name, gint base_size, gint scale)
+{
+  return g_strdup_printf ("%s:%d@%d", name, base_size, scale);
+}
+
+static void gd_symbolic_icon_factory_invalidate (GdSymbolicIconFactory *self);
+
+static void
+gd_symbolic_icon_factory_clear_style (GdSymbolicIconFactory *self)
+{
+  if (self->style == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (self->style, gd_symbolic_icon_factory_invalidate, self);
+  g_clear_object (&self->style);
+}
+
+static void
+gd_symbolic_icon_factory_invalidate (GdSymbolicIconFactory *self)
+{
+  self->generation++;
+  g_hash_table_remove_all (self->icons);
+  g_hash_table_remove_all (self->surfaces);
+  gd_symbolic_icon_factory_clear_style (self);
+
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+static void
+gd_symbolic_icon_factory_prewarm_data_free (GdSymbolicIconFactoryPrewarmData *data)
+{
+  g_strfreev (data->names);
+  g_slice_free (GdSymbolicIconFactoryPrewarmData, data);
+}
+
+/* The icons are rendered with GTK+, so this happens one icon at a
+ * time in idles on the main context, rather than in a thread.
+ */
+static gboolean
+gd_symbolic_icon_factory_prewarm_idle (gpointer user_data)
+{
+  GTask *task = G_TASK (user_data);
+  GdSymbolicIconFactory *self;
+  GdSymbolicIconFactoryPrewarmData *data;
+  GIcon *icon;
+
+  if (g_task_return_error_if_cancelled (task))
+    return G_SOURCE_REMOVE;
+
+  self = GD_SYMBOLIC_ICON_FACTORY (g_task_get_source_object (task));
+  data = g_task_get_task_data (task);
+
+  if (data->generation != self->generation)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_CANCELLED,
+                               "The theme changed while the icons were being rendered");
+      return G_SOURCE_REMOVE;
+    }
+
+  if (data->names[data->index] == NULL)
+    {
+      g_task_return_boolean (task, TRUE);
+      return G_SOURCE_REMOVE;
+    }
+
+  icon = gd_symbolic_icon_factory_lookup (self, data->names[data->index], data->base_size, data->scale);
+  g_clear_object (&icon);
+  data->index++;
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gd_symbolic_icon_factory_constructed (GObject *obj)
+{
+  GdSymbolicIconFactory *self = GD_SYMBOLIC_ICON_FACTORY (obj);
+
+  G_OBJECT_CLASS (gd_symbolic_icon_factory_parent_class)->constructed (obj);
+
+  if (self->theme == NULL)
+    self->theme = g_object_ref (gtk_icon_theme_get_default ());
+
+  g_signal_connect_object (self->theme,
+                           "changed",
+                           G_CALLBACK (gd_symbolic_icon_factory_invalidate),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
+
+static void
+gd_symbolic_icon_factory_dispose (GObject *obj)
+{
+  GdSymbolicIconFactory *self = GD_SYMBOLIC_ICON_FACTORY (obj);
+
+  gd_symbolic_icon_factory_clear_style (self);
+  g_clear_object (&self->theme);
+
+  if (self->icons != NULL)
+    g_hash_table_remove_all (self->icons);
+  if (self->surfaces != NULL)
+    g_hash_table_remove_all (self->surfaces);
+
+  G_OBJECT_CLASS (gd_symbolic_icon_factory_parent_class)->dispose (obj);
+}
+
+static void
+gd_symbolic_icon_factory_finalize (GObject *obj)
+{
+  GdSymbolicIconFactory *self = GD_SYMBOLIC_ICON_FACTORY (obj);
+
+  g_hash_table_unref (self->icons);
+  g_hash_table_unref (self->surfaces);
+
+  G_OBJECT_CLASS (gd_symbolic_icon_factory_parent_class)->finalize (obj);
+}
+
+static void
+gd_symbolic_icon_factory_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+  GdSymbolicIconFactory *self = GD_SYMBOLIC_ICON_FACTORY (object);
+
+  switch (property_id)
+    {
+    case PROP_ICON_THEME:
+      g_value_set_object (value, gd_symbolic_icon_factory_get_icon_theme (self));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gd_symbolic_icon_factory_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+  GdSymbolicIconFactory *self = GD_SYMBOLIC_ICON_FACTORY (object);
+
+  switch (property_id)
+    {
+    case PROP_ICON_THEME:
+      self->theme = g_value_dup_object (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gd_symbolic_icon_factory_init (GdSymbolicIconFactory *self)
+{
+  self->icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  self->surfaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) cairo_surface_destroy);
+}
+
+static void
+gd_symbolic_icon_factory_class_init (GdSymbolicIconFactoryClass *klass)
+{
+  GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+  oclass->constructed = gd_symbolic_icon_factory_constructed;
+  oclass->dispose = gd_symbolic_icon_factory_dispose;
+  oclass->finalize = gd_symbolic_icon_factory_finalize;
+  oclass->get_property = gd_symbolic_icon_factory_get_property;
+  oclass->set_property = gd_symbolic_icon_factory_set_property;
+
+  properties[PROP_ICON_THEME] = g_param_spec_object ("icon-theme",
+                                                     "Icon Theme",
+                                                     "The icon theme that the icons are looked up in",
+                                                     GTK_TYPE_ICON_THEME,
+                                                     G_PARAM_CONSTRUCT_ONLY |
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (oclass, NUM_PROPERTIES, properties);
+
+  /**
+   * GdSymbolicIconFactory::changed:
+   * @self:
+   *
+   * Emitted when the cached icons were dropped because the icon theme
+   * or the style changed, for instance with the GTK+ theme or a new CSS
+   * provider. Icons that were handed out earlier
+   * should be looked up again.
+   */
+  signals[CHANGED] = g_signal_new ("changed",
+                                   GD_TYPE_SYMBOLIC_ICON_FACTORY,
+                                   G_SIGNAL_RUN_LAST,
+                                   0,
+                                   NULL,
+                                   NULL,
+                                   g_cclosure_marshal_VOID__VOID,
+                                   G_TYPE_NONE,
+                                   0);
+}
+
+/**
+ * gd_symbolic_icon_factory_new:
+ * @theme: (nullable): a #GtkIconTheme, or %NULL for the default one
+ *
+ * Returns: (transfer full): A new #GdSymbolicIconFactory.
+ */
+GdSymbolicIconFactory *
+gd_symbolic_icon_factory_new (GtkIconTheme *theme)
+{
+  g_return_val_if_fail (theme == NULL || GTK_IS_ICON_THEME (theme), NULL);
+  return g_object_new (GD_TYPE_SYMBOLIC_ICON_FACTORY, "icon-theme", theme, NULL);
+}
+
+/**
+ * gd_symbolic_icon_factory_get_default:
+ *
+ * Returns: (transfer none): The #GdSymbolicIconFactory for the default
+ * icon theme, which is used by gd_create_symbolic_icon_for_scale().
+ */
+GdSymbolicIconFactory *
+gd_symbolic_icon_factory_get_default (void)
+{
+  static GdSymbolicIconFactory *factory;
+
+  if (factory == NULL)
+    factory = gd_symbolic_icon_factory_new (NULL);
+
+  return factory;
+}
+
+void
+gd_symbolic_icon_factory_clear (GdSymbolicIconFactory *self)
+{
+  g_return_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self));
+  g_hash_table_remove_all (self->icons);
+  g_hash_table_remove_all (self->surfaces);
+}
+
+/**
+ * gd_symbolic_icon_factory_get_icon_theme:
+ * @self:
+ *
+ * Returns: (transfer none): The #GtkIconTheme used by @self.
+ */
+GtkIconTheme *
+gd_symbolic_icon_factory_get_icon_theme (GdSymbolicIconFactory *self)
+{
+  g_return_val_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self), NULL);
+  return self->theme;
+}
+
+/**
+ * gd_symbolic_icon_factory_lookup_surface:
+ * @self:
+ * @name: the name of the icon, without the "-symbolic" suffix
+ * @base_size:
+ * @scale:
+ *
+ * Like gd_symbolic_icon_factory_lookup(), but returns the surface that
+ * the icon is rendered to, which saves converting it to a #GdkPixbuf
+ * and back when it is drawn with cairo. The surface is shared, and
+ * must not be modified.
+ *
+ * Returns: (transfer full) (nullable): An image surface with a device
+ * scale of @scale, or %NULL if @name isn't in the icon theme.
+ */
+cairo_surface_t *
+gd_symbolic_icon_factory_lookup_surface (GdSymbolicIconFactory *self,
+                                         const gchar           *name,
+                                         gint                   base_size,
+                                         gint                   scale)
+{
+  cairo_surface_t *surface;
+  gchar *key;
+
+  g_return_val_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (scale > 0, NULL);
+
+  key = gd_symbolic_icon_factory_create_key (name, base_size, scale);
+
+  surface = g_hash_table_lookup (self->surfaces, key);
+  if (surface != NULL)
+    {
+      cairo_surface_reference (surface);
+      g_free (key);
+      goto out;
+    }
+
+  if (self->style == NULL)
+    {
+      self->style = _gd_create_symbolic_icon_style ();
+      g_signal_connect_swapped (self->style,
+                                "changed",
+                                G_CALLBACK (gd_symbolic_icon_factory_invalidate),
+                                self);
+    }
+
+  surface = _gd_create_symbolic_surface_for_style (self->style, self->theme, name, base_size, scale);
+  if (surface == NULL)
+    {
+      g_free (key);
+      goto out;
+    }
+
+  g_hash_table_insert (self->surfaces, key, cairo_surface_reference (surface));
+
+ out:
+  return surface;
+}
+
+/**
+ * gd_symbolic_icon_factory_lookup:
+ * @self:
+ * @name: the name of the icon, without the "-symbolic" suffix
+ * @base_size:
+ * @scale:
+ *
+ * Looks up the icon that gd_create_symbolic_icon_for_scale() would
+ * create, and renders it if it isn't cached yet. The icon is shared,
+ * and must not be modified.
+ *
+ * Returns: (transfer full) (nullable): The icon, or %NULL if @name
+ * isn't in the icon theme.
+ */
+GIcon *
+gd_symbolic_icon_factory_lookup (GdSymbolicIconFactory *self, const gchar *name, gint base_size, gint scale)
+{
+  cairo_surface_t *surface;
+  GIcon *icon;
+  gchar *key;
+
+  g_return_val_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (scale > 0, NULL);
+
+  key = gd_symbolic_icon_factory_create_key (name, base_size, scale);
+
+  icon = g_hash_table_lookup (self->icons, key);
+  if (icon != NULL)
+    {
+      g_object_ref (icon);
+      g_free (key);
+      goto out;
+    }
+
+  surface = gd_symbolic_icon_factory_lookup_surface (self, name, base_size, scale);
+  if (surface == NULL)
+    {
+      g_free (key);
+      goto out;
+    }
+
+  icon = G_ICON (gd_create_pixbuf_from_surface (surface));
+  cairo_surface_destroy (surface);
+
+  g_hash_table_insert (self->icons, key, g_object_ref (icon));
+
+ out:
+  return icon;
+}
+
+/**
+ * gd_symbolic_icon_factory_prewarm_async:
+ * @self:
+ * @names: (array zero-terminated=1): the names of the icons
+ * @base_size:
+ * @scale:
+ * @cancellable: (nullable):
+ * @callback:
+ * @user_data:
+ *
+ * Renders the icons for @names into the cache of @self, a little at a
+ * time, so that later lookups don't have to. This fails with
+ * %G_IO_ERROR_CANCELLED if the theme changes before it is done.
+ */
+void
+gd_symbolic_icon_factory_prewarm_async (GdSymbolicIconFactory *self,
+                                        const gchar * const   *names,
+                                        gint                   base_size,
+                                        gint                   scale,
+                                        GCancellable          *cancellable,
+                                        GAsyncReadyCallback    callback,
+                                        gpointer               user_data)
+{
+  GdSymbolicIconFactoryPrewarmData *data;
+  GSource *source;
+  GTask *task;
+
+  g_return_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self));
+  g_return_if_fail (names != NULL);
+  g_return_if_fail (scale > 0);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  data = g_slice_new0 (GdSymbolicIconFactoryPrewarmData);
+  data->names = g_strdupv ((gchar **) names);
+  data->base_size = base_size;
+  data->scale = scale;
+  data->generation = self->generation;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gd_symbolic_icon_factory_prewarm_async);
+  g_task_set_task_data (task, data, (GDestroyNotify) gd_symbolic_icon_factory_prewarm_data_free);
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_LOW);
+  g_task_attach_source (task, source, gd_symbolic_icon_factory_prewarm_idle);
+  g_source_unref (source);
+
+  g_object_unref (task);
+}
+
+gboolean
+gd_symbolic_icon_factory_prewarm_finish (GdSymbolicIconFactory *self, GAsyncResult *res, GError **error)
+{
+  g_return_val_if_fail (GD_IS_SYMBOLIC_ICON_FACTORY (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (res)) == gd_symbolic_icon_factory_prewarm_async, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 The libgd authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GD_SYMBOLIC_ICON_FACTORY_H__
+#define __GD_SYMBOLIC_ICON_FACTORY_H__
+
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GD_TYPE_SYMBOLIC_ICON_FACTORY gd_symbolic_icon_factory_get_type()
+G_DECLARE_FINAL_TYPE (GdSymbolicIconFactory, gd_symbolic_icon_factory, GD, SYMBOLIC_ICON_FACTORY, GObject)
+
+GdSymbolicIconFactory  * gd_symbolic_icon_factory_new              (GtkIconTheme *theme);
+GdSymbolicIconFactory  * gd_symbolic_icon_factory_get_default      (void);
+
+void                     gd_symbolic_icon_factory_clear            (GdSymbolicIconFactory *self);
+GtkIconTheme           * gd_symbolic_icon_factory_get_icon_theme   (GdSymbolicIconFactory *self);
+GIcon                  * gd_symbolic_icon_factory_lookup           (GdSymbolicIconFactory *self,
+                                                                    const gchar           *name,
+                                                                    gint                   base_size,
+                                                                    gint                   scale);
+cairo_surface_t        * gd_symbolic_icon_factory_lookup_surface   (GdSymbolicIconFactory *self,
+                                                                    const gchar           *name,
+                                                                    gint                   base_size,
+                                                                    gint                   scale);
+void                     gd_symbolic_icon_factory_prewarm_async    (GdSymbolicIconFactory *self,
+                                                                    const gchar * const   *names,
+                                                                    gint                   base_size,
+                                                                    gint                   scale,
+                                                                    GCancellable          *cancellable,
+                                                                    GAsyncReadyCallback    callback,
+                                                                    gpointer               user_data);
+gboolean                 gd_symbolic_icon_factory_prewarm_finish   (GdSymbolicIconFactory  *self,
+                                                                    GAsyncResult           *res,
+                                                                    GError                **error);
+
+G_END_DECLS
+
+#endif /* __GD_SYMBOLIC_ICON_FACTORY_H__ */
@@ -25,6 +25,7 @@ enum {
   PROP_ACTIVE = 1,
   PROP_TOGGLE_VISIBLE,
   PROP_PULSE,
+  PROP_PULSE_PHASE,
   NUM_PROPERTIES
 };
 
@@ -37,6 +38,7 @@ struct _GdTogglePixbufRendererPrivate {
   gboolean toggle_visible;
 
   guint pulse;
+  guint pulse_phase;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GdTogglePixbufRenderer, gd_toggle_pixbuf_renderer, GTK_TYPE_CELL_RENDERER_PIXBUF)
@@ -117,7 +119,7 @@ render_activity (GdTogglePixbufRenderer *self,
                      GTK_STATE_FLAG_ACTIVE,
                      widget,
                      NULL,
-                     (guint) priv->pulse - 1,
+                     (guint) priv->pulse - 1 + priv->pulse_phase,
                      x, y,
                      width, height);
   G_GNUC_END_IGNORE_DEPRECATIONS;
@@ -195,6 +197,9 @@ gd_toggle_pixbuf_renderer_get_property (GObject    *object,
     case PROP_PULSE:
       g_value_set_uint (value, priv->pulse);
       break;
+    case PROP_PULSE_PHASE:
+      g_value_set_uint (value, priv->pulse_phase);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -223,6 +228,9 @@ gd_toggle_pixbuf_renderer_set_property (GObject    *object,
     case PROP_PULSE:
       priv->pulse = g_value_get_uint (value);
       break;
+    case PROP_PULSE_PHASE:
+      priv->pulse_phase = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -264,6 +272,17 @@ gd_toggle_pixbuf_renderer_class_init (GdTogglePixbufRendererClass *klass)
 		       0,
 		       G_PARAM_READWRITE |
 		       G_PARAM_STATIC_STRINGS);
+  properties[PROP_PULSE_PHASE] =
+    g_param_spec_uint ("pulse-phase",
+                       "Pulse phase",
+                       "Added to the pulse to pick the step of the "
+                       "spinner, so that all the cells can be animated "
+                       "together.",
+                       0,
+                       G_MAXUINT,
+                       0,
+                       G_PARAM_READWRITE |
+                       G_PARAM_STATIC_STRINGS);
 
   g_object_class_install_properties (oclass, NUM_PROPERTIES, properties);
 }
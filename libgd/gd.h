@@ -27,7 +27,15 @@ G_BEGIN_DECLS
 #include <libgd/gd-types-catalog.h>
 
 #ifdef LIBGD_GTK_HACKS
+# include <libgd/gd-frame-renderer.h>
 # include <libgd/gd-icon-utils.h>
+# include <libgd/gd-image-scaler.h>
+# include <libgd/gd-surface-cache.h>
+# include <libgd/gd-symbolic-icon-factory.h>
+#endif
+
+#ifdef LIBGD__SELECTION_COMMON
+# include <libgd/gd-index-set.h>
 #endif
 
 #ifdef LIBGD__BOX_COMMON